@@ -0,0 +1,489 @@
+
+/*
+ *  main.cpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#include <SFML/Graphics.hpp>
+#include <sfeMovie/Movie.hpp>
+#include "ImageKernels.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(SFML_SYSTEM_WINDOWS)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(SFML_SYSTEM_MACOS)
+#include <mach/mach.h>
+#else
+#include <unistd.h>
+#endif
+
+/*
+ * Performance benchmarks of sfeMovie
+ *
+ * Usage: sfeMovieBench [--output results.json] [media_path...]
+ *
+ * Without media paths, the synthetic media generated by the sfeMovieBenchMedia build target are
+ * measured. For each media, the results are written as JSON to the standard output or to the given
+ * file, so that they can be compared between revisions. The image kernels are measured too, they
+ * don't need any media.
+ */
+
+namespace
+{
+    const unsigned int OpenRepetitions = 10;
+    const unsigned int SeekCount = 20;
+    const unsigned int MemoryMovieCount = 4;
+    const sf::Time PlaybackDuration = sf::seconds(3);
+    const unsigned int KernelRepetitions = 20;
+    
+    /** Summary of repeated duration measurements
+     */
+    struct Measure
+    {
+        Measure() :
+        median(sf::Time::Zero),
+        minimum(sf::Time::Zero),
+        maximum(sf::Time::Zero)
+        {
+        }
+        
+        sf::Time median;
+        sf::Time minimum;
+        sf::Time maximum;
+    };
+    
+    struct MediaResult
+    {
+        MediaResult() :
+        path(),
+        couldOpen(false),
+        duration(sf::Time::Zero),
+        videoSize(),
+        openTime(),
+        fastOpenTime(),
+        seekLatency(),
+        videoDecodeFps(0),
+        videoConvertFps(0),
+        videoUploadFps(0),
+        audioDecodeFps(0),
+        audioConvertFps(0),
+        memoryPerMovie(0)
+        {
+        }
+        
+        std::string path;
+        bool couldOpen;
+        sf::Time duration;
+        sf::Vector2f videoSize;
+        Measure openTime;
+        Measure fastOpenTime;
+        Measure seekLatency;
+        double videoDecodeFps;
+        double videoConvertFps;
+        double videoUploadFps;
+        double audioDecodeFps;
+        double audioConvertFps;
+        long long memoryPerMovie;
+    };
+    
+    struct KernelResult
+    {
+        Measure expandPalette;
+        Measure expandPaletteScalar;
+    };
+    
+    Measure summarize(std::vector<sf::Time> durations)
+    {
+        Measure measure;
+        
+        if (!durations.empty())
+        {
+            std::sort(durations.begin(), durations.end());
+            measure.median = durations[durations.size() / 2];
+            measure.minimum = durations.front();
+            measure.maximum = durations.back();
+        }
+        
+        return measure;
+    }
+    
+    /** @return the frames per second that can be processed at the given histogram's mean cost
+     */
+    double throughput(const sfe::TimeHistogram& histogram)
+    {
+        if (histogram.count == 0 || histogram.total <= sf::Time::Zero)
+            return 0;
+        
+        return histogram.count / histogram.total.asSeconds();
+    }
+    
+    /** @return the physical memory used by this process, in bytes
+     */
+    long long residentMemory()
+    {
+#if defined(SFML_SYSTEM_WINDOWS)
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return static_cast<long long>(counters.WorkingSetSize);
+        return 0;
+#elif defined(SFML_SYSTEM_MACOS)
+        mach_task_basic_info info;
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+        if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS)
+            return static_cast<long long>(info.resident_size);
+        return 0;
+#else
+        long long totalPages = 0;
+        long long residentPages = 0;
+        std::ifstream statm("/proc/self/statm");
+        if (statm >> totalPages >> residentPages)
+            return residentPages * sysconf(_SC_PAGESIZE);
+        return 0;
+#endif
+    }
+    
+    /** @return options that open the media with as little stream analysis as possible
+     */
+    sfe::OpenOptions fastOpenOptions()
+    {
+        sfe::OpenOptions options;
+        options.probeSize = 32 * 1024;
+        options.analyzeDuration = sf::milliseconds(500);
+        options.fpsProbeSize = 0;
+        options.trustContainerHeader = true;
+        return options;
+    }
+    
+    void measureOpening(MediaResult& result)
+    {
+        std::vector<sf::Time> durations;
+        std::vector<sf::Time> fastDurations;
+        
+        for (unsigned int i = 0; i < OpenRepetitions; i++)
+        {
+            sfe::Movie movie;
+            sf::Clock clock;
+            
+            if (!movie.openFromFile(result.path))
+                return;
+            
+            durations.push_back(clock.getElapsedTime());
+            result.duration = movie.getDuration();
+            result.videoSize = movie.getSize();
+        }
+        
+        for (unsigned int i = 0; i < OpenRepetitions; i++)
+        {
+            sfe::Movie movie;
+            sf::Clock clock;
+            
+            if (movie.openFromFile(result.path, fastOpenOptions()))
+                fastDurations.push_back(clock.getElapsedTime());
+        }
+        
+        result.couldOpen = true;
+        result.openTime = summarize(durations);
+        result.fastOpenTime = summarize(fastDurations);
+    }
+    
+    void measureDecoding(MediaResult& result)
+    {
+        sfe::Movie movie;
+        if (!movie.openFromFile(result.path))
+            return;
+        
+        // Decoding happens at playback pace, the throughput is deduced from the time spent per frame
+        const sf::Time playbackDuration = std::min(PlaybackDuration, result.duration);
+        sf::Clock clock;
+        movie.play();
+        
+        while (clock.getElapsedTime() < playbackDuration && movie.getStatus() == sfe::Playing)
+        {
+            movie.update();
+            sf::sleep(sf::milliseconds(1));
+        }
+        
+        movie.stop();
+        
+        for (const sfe::StreamStats& stats : movie.getPlaybackStats().streams)
+        {
+            if (stats.stream.type == sfe::Video)
+            {
+                result.videoDecodeFps = throughput(stats.decodeTime);
+                result.videoConvertFps = throughput(stats.convertTime);
+                result.videoUploadFps = throughput(stats.uploadTime);
+            }
+            else if (stats.stream.type == sfe::Audio)
+            {
+                result.audioDecodeFps = throughput(stats.decodeTime);
+                result.audioConvertFps = throughput(stats.convertTime);
+            }
+        }
+    }
+    
+    void measureSeeking(MediaResult& result)
+    {
+        sfe::Movie movie;
+        if (!movie.openFromFile(result.path) || result.duration <= sf::Time::Zero)
+            return;
+        
+        std::vector<sf::Time> durations;
+        movie.update();
+        
+        // Spread the targets over the whole media, out of order so that each seek needs a new keyframe
+        for (unsigned int i = 0; i < SeekCount; i++)
+        {
+            const unsigned int slot = (i * 7) % SeekCount;
+            const sf::Time target = result.duration * (slot / static_cast<float>(SeekCount));
+            sf::Clock clock;
+            
+            if (movie.setPlayingOffset(target))
+            {
+                movie.update();
+                durations.push_back(clock.getElapsedTime());
+            }
+        }
+        
+        result.seekLatency = summarize(durations);
+    }
+    
+    void measureMemory(MediaResult& result)
+    {
+        std::vector<std::unique_ptr<sfe::Movie> > movies;
+        const long long memoryBefore = residentMemory();
+        
+        for (unsigned int i = 0; i < MemoryMovieCount; i++)
+        {
+            std::unique_ptr<sfe::Movie> movie(new sfe::Movie);
+            if (!movie->openFromFile(result.path))
+                return;
+            
+            movie->update();
+            movies.push_back(std::move(movie));
+        }
+        
+        result.memoryPerMovie = (residentMemory() - memoryBefore) / MemoryMovieCount;
+    }
+    
+    void expandPaletteScalar(const sf::Uint8* indices, std::size_t pixelCount, const sf::Uint32 palette[256],
+                             sf::Uint8* destination)
+    {
+        sf::Uint32* data = reinterpret_cast<sf::Uint32*>(destination);
+        for (std::size_t j = 0; j < pixelCount; ++j)
+            data[j] = palette[indices[j]];
+    }
+    
+    /** A full HD subtitle bitmap: transparent but for a few lines of antialiased text at the bottom
+     */
+    std::vector<sf::Uint8> makeSubtitleIndices(unsigned int width, unsigned int height)
+    {
+        std::vector<sf::Uint8> indices(width * height, 0);
+        
+        for (unsigned int y = height - 200; y < height - 50; y++)
+        {
+            for (unsigned int x = 300; x < width - 300; x++)
+            {
+                if ((x / 12 + y / 20) % 3 != 0)
+                    indices[y * width + x] = static_cast<sf::Uint8>(1 + (x * 7 + y * 3) % 255);
+            }
+        }
+        
+        return indices;
+    }
+    
+    Measure measureExpansion(void (*expand)(const sf::Uint8*, std::size_t, const sf::Uint32*, sf::Uint8*),
+                             const std::vector<sf::Uint8>& indices, const sf::Uint32 palette[256])
+    {
+        std::vector<sf::Uint8> pixels(indices.size() * 4);
+        std::vector<sf::Time> durations;
+        
+        for (unsigned int i = 0; i < KernelRepetitions; i++)
+        {
+            sf::Clock clock;
+            expand(indices.data(), indices.size(), palette, pixels.data());
+            durations.push_back(clock.getElapsedTime());
+        }
+        
+        return summarize(durations);
+    }
+    
+    void measureKernels(KernelResult& result)
+    {
+        sf::Uint32 palette[256];
+        for (unsigned int i = 0; i < 256; i++)
+            palette[i] = i * 0x01010101u;
+        
+        const std::vector<sf::Uint8> indices = makeSubtitleIndices(1920, 1080);
+        result.expandPalette = measureExpansion(sfe::ImageKernels::expandPalette, indices, palette);
+        result.expandPaletteScalar = measureExpansion(expandPaletteScalar, indices, palette);
+    }
+    
+    std::string escape(const std::string& text)
+    {
+        std::string result;
+        
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                result += '\\';
+            result += c;
+        }
+        
+        return result;
+    }
+    
+    void writeMeasure(std::ostream& output, const std::string& name, const Measure& measure)
+    {
+        output << "\"" << name << "\": {\"median_us\": " << measure.median.asMicroseconds()
+               << ", \"min_us\": " << measure.minimum.asMicroseconds()
+               << ", \"max_us\": " << measure.maximum.asMicroseconds() << "}";
+    }
+    
+    void writeResults(std::ostream& output, const KernelResult& kernels, const std::vector<MediaResult>& results)
+    {
+        output << "{\n  \"kernels\": {";
+        writeMeasure(output, "expand_palette_1080p", kernels.expandPalette);
+        output << ", ";
+        writeMeasure(output, "expand_palette_scalar_1080p", kernels.expandPaletteScalar);
+        output << "},\n  \"benchmarks\": [";
+        
+        for (std::size_t i = 0; i < results.size(); i++)
+        {
+            const MediaResult& result = results[i];
+            output << (i ? ",\n" : "\n") << "    {\"media\": \"" << escape(result.path) << "\", "
+                   << "\"opened\": " << (result.couldOpen ? "true" : "false");
+            
+            if (result.couldOpen)
+            {
+                output << ", \"width\": " << result.videoSize.x << ", \"height\": " << result.videoSize.y
+                       << ", \"duration_us\": " << result.duration.asMicroseconds() << ",\n      ";
+                writeMeasure(output, "open", result.openTime);
+                output << ", ";
+                writeMeasure(output, "fast_open", result.fastOpenTime);
+                output << ",\n      ";
+                writeMeasure(output, "seek", result.seekLatency);
+                output << ",\n      \"video_decode_fps\": " << result.videoDecodeFps
+                       << ", \"video_convert_fps\": " << result.videoConvertFps
+                       << ", \"video_upload_fps\": " << result.videoUploadFps
+                       << ", \"audio_decode_fps\": " << result.audioDecodeFps
+                       << ", \"audio_convert_fps\": " << result.audioConvertFps
+                       << ",\n      \"memory_per_movie_bytes\": " << result.memoryPerMovie;
+            }
+            
+            output << "}";
+        }
+        
+        output << "\n  ]\n}\n";
+    }
+    
+    std::vector<std::string> generatedMedia()
+    {
+        std::vector<std::string> paths;
+#ifdef SFEMOVIE_BENCH_MEDIA_LIST
+        std::ifstream list(SFEMOVIE_BENCH_MEDIA_LIST);
+        std::string line;
+        
+        while (std::getline(list, line))
+        {
+            // The media are only generated on request
+            if (!line.empty() && std::ifstream(line.c_str()).good())
+                paths.push_back(line);
+        }
+#endif
+        return paths;
+    }
+}
+
+int main(int argc, const char* argv[])
+{
+    std::string outputPath;
+    std::vector<std::string> paths;
+    
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string argument(argv[i]);
+        
+        if (argument == "--output" && i + 1 < argc)
+            outputPath = argv[++i];
+        else
+            paths.push_back(argument);
+    }
+    
+    if (paths.empty())
+        paths = generatedMedia();
+    
+    if (paths.empty())
+    {
+        std::cerr << "Usage: " << argv[0] << " [--output results.json] [media_path...]" << std::endl;
+        std::cerr << "No media to measure, only the image kernels are measured. Build the sfeMovieBenchMedia "
+                  << "target to generate the synthetic media" << std::endl;
+    }
+    
+    KernelResult kernels;
+    measureKernels(kernels);
+    
+    // Video frames are uploaded to textures, which need an OpenGL context
+    sf::Context context;
+    std::vector<MediaResult> results;
+    
+    for (const std::string& path : paths)
+    {
+        std::cerr << "Measuring " << path << std::endl;
+        MediaResult result;
+        result.path = path;
+        
+        measureOpening(result);
+        
+        if (result.couldOpen)
+        {
+            measureDecoding(result);
+            measureSeeking(result);
+            measureMemory(result);
+        }
+        
+        results.push_back(result);
+    }
+    
+    if (outputPath.empty())
+    {
+        writeResults(std::cout, kernels, results);
+    }
+    else
+    {
+        std::ofstream file(outputPath.c_str());
+        writeResults(file, kernels, results);
+        
+        if (!file)
+        {
+            std::cerr << "Could not write " << outputPath << std::endl;
+            return 1;
+        }
+    }
+    
+    return 0;
+}
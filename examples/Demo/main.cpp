@@ -71,7 +71,7 @@ int main(int argc, const char *argv[])
 {
     if (argc < 2)
     {
-        std::cout << "Usage: " << std::string(argv[0]) << " movie_path" << std::endl;
+        std::cout << "Usage: " << std::string(argv[0]) << " movie_path [subtitles_path]" << std::endl;
         my_pause();
         return 1;
     }
@@ -86,6 +86,14 @@ int main(int argc, const char *argv[])
         return 1;
     }
     
+    if (argc >= 3)
+    {
+        std::cout << "Adding subtitle file \"" << argv[2] << "\"" << std::endl;
+        
+        if (movie.addSubtitleFile(argv[2]))
+            movie.selectStream(movie.getStreams(sfe::Subtitle).back());
+    }
+    
     bool fullscreen = false;
     sf::VideoMode desktopMode = sf::VideoMode::getDesktopMode();
     float width = std::min(static_cast<float>(desktopMode.width), movie.getSize().x);
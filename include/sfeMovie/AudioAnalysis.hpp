@@ -0,0 +1,75 @@
+
+/*
+ *  AudioAnalysis.hpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef SFEMOVIE_AUDIO_ANALYSIS_HPP
+#define SFEMOVIE_AUDIO_ANALYSIS_HPP
+
+#include <SFML/System.hpp>
+#include <sfeMovie/Visibility.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace sfe
+{
+    /** Interface for receiving the audio samples played by a Movie
+     *
+     * The samples are given right after they have been decoded and converted to signed 16 bits,
+     * before they are queued for playback. As the audio playback is buffered, they are given
+     * ahead of the moment they are actually heard.
+     */
+    class SFE_API AudioSampleObserver
+    {
+    public:
+        virtual ~AudioSampleObserver();
+        
+        /** Called for each chunk of audio samples that is about to be played
+         *
+         * @warning This is called from the audio streaming thread, implementations must be thread safe
+         * and return quickly, otherwise the audio playback will stutter
+         *
+         * @param samples the interleaved signed 16 bits audio samples
+         * @param sampleCount the count of samples in @a samples, all channels included
+         * @param channelCount the count of interleaved channels
+         * @param sampleRate the amount of samples per second and per channel
+         * @param position the media position of the first sample of this chunk
+         */
+        virtual void didReceiveAudioSamples(const sf::Int16* samples, std::size_t sampleCount,
+                                            unsigned int channelCount, unsigned int sampleRate,
+                                            sf::Time position) = 0;
+    };
+    
+    /** Result of the built-in audio analysis, see Movie::enableAudioAnalysis()
+     */
+    struct SFE_API AudioSpectrum
+    {
+        AudioSpectrum();
+        
+        sf::Time position;          //!< Media position at which the analyzed samples are played
+        float peak[2];              //!< Peak level of the left and right channels, in range [0, 1]
+        float rms[2];               //!< RMS level of the left and right channels, in range [0, 1]
+        std::vector<float> bands;   //!< Magnitude of logarithmically spaced frequency bands, in range [0, 1]
+    };
+}
+
+#endif
@@ -0,0 +1,106 @@
+
+/*
+ *  AudioClip.hpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef SFEMOVIE_AUDIO_CLIP_HPP
+#define SFEMOVIE_AUDIO_CLIP_HPP
+
+#include <SFML/Audio.hpp>
+#include <SFML/System.hpp>
+#include <sfeMovie/Visibility.hpp>
+#include <memory>
+#include <string>
+
+namespace sfe
+{
+    class AudioClipImpl;
+    /** Whole audio track of a media, decoded once into memory
+     *
+     * Unlike Movie, which decodes audio while it is being played, this is meant for short sounds
+     * that are played often: the decoding cost is only paid when loading. The decoded samples
+     * are stored in an sf::SoundBuffer, to be played with sf::Sound.
+     *
+     * Only the first audio stream of the media is decoded, as signed 16 bits interleaved samples.
+     */
+    class SFE_API AudioClip
+    {
+    public:
+        AudioClip();
+        ~AudioClip();
+        
+        /** @brief Decode the first audio stream of the given media
+         *
+         * This blocks until the whole audio stream is decoded. Long media are split into
+         * segments that are decoded in parallel, then stitched together.
+         *
+         * @param filename the path to the media file
+         * @param segmentCount the maximum count of parts of the media that are decoded in parallel,
+         * 0 to use as many as there are CPU cores. Media whose duration is unknown are always decoded
+         * as one part
+         * @return true on success, false if the media could not be opened, has no audio stream or
+         * could not be decoded. The previously loaded audio is kept on failure
+         */
+        bool loadFromFile(const std::string& filename, unsigned int segmentCount = 0);
+        
+        /** @brief Returns the decoded audio, ready to be played with sf::Sound
+         *
+         * @return the sound buffer holding the decoded samples, empty if nothing has been loaded
+         */
+        const sf::SoundBuffer& getBuffer() const;
+        
+        /** @brief Returns the decoded samples
+         *
+         * @return the interleaved signed 16 bits samples, or nullptr if nothing has been loaded
+         */
+        const sf::Int16* getSamples() const;
+        
+        /** @brief Returns the count of decoded samples, all channels included
+         *
+         * @return the size of the array returned by getSamples()
+         */
+        std::size_t getSampleCount() const;
+        
+        /** @brief Returns the count of interleaved channels of the decoded samples
+         *
+         * @return the channel count, 0 if nothing has been loaded
+         */
+        unsigned int getChannelCount() const;
+        
+        /** @brief Returns the amount of samples per second and per channel of the decoded samples
+         *
+         * @return the sample rate, 0 if nothing has been loaded
+         */
+        unsigned int getSampleRate() const;
+        
+        /** @brief Returns the duration of the decoded audio
+         *
+         * @return the duration matching the decoded samples
+         */
+        sf::Time getDuration() const;
+    
+    private:
+        std::shared_ptr<AudioClipImpl> m_impl;
+    };
+}
+
+#endif
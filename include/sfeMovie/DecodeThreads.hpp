@@ -0,0 +1,61 @@
+
+/*
+ *  DecodeThreads.hpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef SFEMOVIE_DECODE_THREADS_HPP
+#define SFEMOVIE_DECODE_THREADS_HPP
+
+#include <sfeMovie/Visibility.hpp>
+
+namespace sfe
+{
+    /** Process-wide worker threads shared by all the movies for decoding video frames
+     *
+     * By default there is no worker thread and each movie decodes its video frames in Movie::update().
+     * With worker threads, Movie::update() only uploads and displays the frames that were decoded
+     * ahead of time, which lets a single thread drive many movies. The frames that are due first are
+     * decoded first, among the movies of highest priority (see Movie::setDecodePriority()).
+     *
+     * Audio is not decoded by these threads on purpose: each audio stream is already decoded ahead on
+     * the streaming thread of its sf::SoundStream, which SFML runs as soon as the audio device needs
+     * samples. Queuing this work behind the video frames of other movies could only make the audio
+     * output underrun, and would not free the thread calling Movie::update() any further.
+     */
+    namespace DecodeThreads
+    {
+        /** Set the count of worker threads that decode video frames for all the movies
+         *
+         * The decoding that is in progress finishes before the count changes. With a count of zero, the
+         * decoding that was waiting for a worker happens right away on the calling thread.
+         *
+         * @param count the count of worker threads, 0 to decode in Movie::update()
+         */
+        SFE_API void setWorkerCount(unsigned int count);
+        
+        /** @return the count of worker threads that decode video frames, 0 if they are decoded in Movie::update()
+         */
+        SFE_API unsigned int getWorkerCount();
+    }
+}
+
+#endif
@@ -0,0 +1,91 @@
+
+/*
+ *  MediaInfo.hpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+
+#ifndef SFEMOVIE_MEDIA_INFO_HPP
+#define SFEMOVIE_MEDIA_INFO_HPP
+
+#include <SFML/System.hpp>
+#include <sfeMovie/Visibility.hpp>
+#include <sfeMovie/StreamSelection.hpp>
+#include <sfeMovie/OpenOptions.hpp>
+#include <string>
+#include <vector>
+
+namespace sfe
+{
+    /** Properties of an audio, video or subtitle stream, as described by the media
+     */
+    struct SFE_API StreamInfo
+    {
+        StreamInfo();
+        
+        StreamDescriptor descriptor;    //!< Stream kind, identifier and language, as given by Movie::getStreams()
+        std::string codec;              //!< Short name of the codec, such as "h264" or "vorbis"
+        bool isDecodable;               //!< Whether this sfeMovie build can play this stream
+        sf::Int64 bitRate;              //!< Bits per second, 0 if unknown
+        sf::Vector2i frameSize;         //!< Size of the video frames, video streams only
+        float frameRate;                //!< Video frames per second, 0 if unknown, video streams only
+        unsigned int sampleRate;        //!< Audio samples per second and per channel, audio streams only
+        unsigned int channelCount;      //!< Count of audio channels, audio streams only
+        std::string channelLayout;      //!< Name of the audio channel layout, such as "stereo" or "5.1", audio streams only
+    };
+    
+    /** Properties of a media and of its streams, see probe()
+     */
+    struct SFE_API MediaInfo
+    {
+        MediaInfo();
+        
+        bool isValid;                   //!< Whether the media could be opened, the other fields are empty otherwise
+        std::string format;             //!< Short name of the container format, such as "matroska,webm" or "ogg"
+        sf::Time duration;              //!< Duration of the media, zero if unknown
+        sf::Int64 bitRate;              //!< Total bits per second, 0 if unknown
+        std::vector<StreamInfo> streams;//!< Audio, video and subtitle streams of the media, including the ones that cannot be played
+    };
+    
+    /** @brief Read the properties of a media without preparing it for playback
+     *
+     * Unlike Movie::openFromFile(), no decoder is loaded and no buffer is allocated, which makes
+     * indexing many media files much faster. This can be called from any thread.
+     *
+     * @param filename the path to the media file
+     * @param options the limits of the work done to find the stream properties
+     * @return the properties of the media, whose isValid field is false if it could not be opened
+     */
+    SFE_API MediaInfo probe(const std::string& filename, const OpenOptions& options = OpenOptions());
+    
+    /** @brief Read the properties of several media in parallel, see probe()
+     *
+     * @param filenames the paths to the media files
+     * @param options the limits of the work done to find the stream properties
+     * @param threadCount the count of files probed at the same time, 0 for the count of CPU cores
+     * @return the properties of each media, in the order of @a filenames
+     */
+    SFE_API std::vector<MediaInfo> probe(const std::vector<std::string>& filenames,
+                                         const OpenOptions& options = OpenOptions(),
+                                         unsigned int threadCount = 0);
+}
+
+#endif
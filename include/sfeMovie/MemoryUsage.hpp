@@ -0,0 +1,72 @@
+
+/*
+ *  MemoryUsage.hpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef SFEMOVIE_MEMORY_USAGE_HPP
+#define SFEMOVIE_MEMORY_USAGE_HPP
+
+#include <sfeMovie/Visibility.hpp>
+#include <cstddef>
+
+namespace sfe
+{
+    /** Memory used by the buffers of one or several movies, in bytes
+     */
+    struct SFE_API MemoryUsage
+    {
+        MemoryUsage();
+        
+        /** @return the sum of all the categories
+         */
+        std::size_t getTotal() const;
+        
+        std::size_t videoFrames;    //!< Decoded video frames, in RAM and in textures
+        std::size_t audioSamples;   //!< Decoded audio samples waiting to be played
+        std::size_t encodedPackets; //!< Encoded packets read ahead of decoding
+    };
+    
+    /** Process-wide limit of the memory used by the buffers of all the movies
+     *
+     * When the buffers of all the movies use more than the limit, the movies read fewer packets ahead
+     * of decoding until usage goes back under the limit. The decoded frames and samples that are
+     * needed for playback are always kept, so the limit can be exceeded.
+     */
+    namespace MemoryBudget
+    {
+        /** Set the memory limit of the buffers of all the movies
+         *
+         * @param bytes the limit in bytes, 0 for no limit (the default)
+         */
+        SFE_API void setLimit(std::size_t bytes);
+        
+        /** @return the memory limit of the buffers of all the movies, 0 if there is no limit
+         */
+        SFE_API std::size_t getLimit();
+        
+        /** @return the memory used by the buffers of all the movies
+         */
+        SFE_API MemoryUsage getUsage();
+    }
+}
+
+#endif
@@ -30,6 +30,12 @@
 #include <SFML/System.hpp>
 #include <sfeMovie/Visibility.hpp>
 #include <sfeMovie/StreamSelection.hpp>
+#include <sfeMovie/AudioAnalysis.hpp>
+#include <sfeMovie/DecodeThreads.hpp>
+#include <sfeMovie/MemoryUsage.hpp>
+#include <sfeMovie/OpenOptions.hpp>
+#include <sfeMovie/MediaInfo.hpp>
+#include <sfeMovie/PlaybackStats.hpp>
 #include <vector>
 #include <string>
 #include <memory>
@@ -66,6 +72,17 @@ namespace sfe
          */
         bool openFromFile(const std::string& filename);
         
+        /** @brief Attemps to open a media file (movie or audio), with bounded stream analysis
+         *
+         * Opening some media requires reading its beginning and decoding a few frames to find the stream
+         * properties, the options limit this work to open faster.
+         *
+         * @param filename the path to the media file
+         * @param options the limits of the work done to find the stream properties
+         * @return true on success, false otherwise
+         */
+        bool openFromFile(const std::string& filename, const OpenOptions& options);
+        
         /** @brief Return a description of all the streams of the given type contained in the opened media
          *
          * @param type the stream type (audio, video...) to return
@@ -87,6 +104,53 @@ namespace sfe
          */
         bool selectStream(const StreamDescriptor& streamDescriptor);
         
+        /** @brief Load subtitles from a separate file, such as a .srt or .ass file next to the media
+         *
+         * The subtitles are added to the subtitle streams given by getStreams() and can be activated
+         * with selectStream(). The file is indexed in background so that it doesn't delay playback,
+         * and only the subtitles about to be displayed are decoded and kept in memory.
+         *
+         * @note The subtitle files are forgotten when opening another media
+         *
+         * @param filename the path to the subtitle file
+         * @return true if the file was added (ie. a media is opened), false otherwise. As the file is
+         * read in background, errors while reading it are only logged
+         */
+        bool addSubtitleFile(const std::string& filename);
+        
+        /** @brief Play the given audio stream together with the active audio stream
+         *
+         * All the mixed audio streams are played through a single sound output, at the sample rate
+         * of the active audio stream. Selecting another audio stream keeps the mixed streams.
+         *
+         * @warning This method can only be used when the movie is stopped
+         *
+         * @param streamDescriptor the descriptor of the audio stream to mix
+         * @return true if the stream could be mixed (ie. valid audio stream that is not the active one,
+         * an audio stream is active and movie is stopped)
+         */
+        bool addMixedAudioStream(const StreamDescriptor& streamDescriptor);
+        
+        /** @brief Stop playing the given audio stream together with the active audio stream
+         *
+         * @warning This method can only be used when the movie is stopped
+         *
+         * @param streamDescriptor the descriptor of the audio stream to stop mixing
+         * @return true if the stream was mixed and could be removed from the mix
+         */
+        bool removeMixedAudioStream(const StreamDescriptor& streamDescriptor);
+        
+        /** @brief Set the gain of an audio stream, to balance the mixed audio streams
+         *
+         * Unlike the volume, the gain is set for each audio stream. It can be changed while playing
+         * but takes effect with a delay, as audio is buffered.
+         *
+         * @param streamDescriptor the descriptor of the audio stream
+         * @param gain the factor applied to the audio samples, 1 leaves them unchanged (default)
+         * @return true if @a streamDescriptor is a valid audio stream
+         */
+        bool setAudioStreamGain(const StreamDescriptor& streamDescriptor, float gain);
+        
         /** @brief Start or resume playing the media playback
          *
          * This function starts the stream if it was stopped, resumes it if it was paused,
@@ -111,9 +175,32 @@ namespace sfe
         void stop();
         
         /** @brief Update the media status and eventually decode frames
+         *
+         * Updating a paused or stopped movie costs nothing, unless its state changed since the last update
          */
         void update();
         
+        /** @brief Returns when the next call to update() will change the displayed image or subtitles
+         *
+         * This lets applications sleep until the next video frame or subtitle change is due, and skip
+         * redrawing when nothing changed. The audio is played in background and never needs an update.
+         * A delay of zero means update() has work to do right away.
+         *
+         * @param delay [out] the time left before the next change, unmodified if nothing is scheduled
+         * @return true if a change is scheduled, false if nothing changes until the status of the movie
+         * does, for example when it is paused or has no video nor subtitles
+         */
+        bool getTimeUntilNextUpdate(sf::Time& delay) const;
+        
+        /** @brief Tell whether the displayed image or subtitles changed since the movie was last drawn
+         *
+         * Applications drawing many paused movies can skip redrawing the ones that didn't change.
+         * Changes made to the transform of the movie through sf::Transformable are not tracked.
+         *
+         * @return true if the movie needs to be drawn again, false otherwise
+         */
+        bool hasVisibleChanges() const;
+        
         /** @brief Sets the sound's volume (default is 100)
          *
          * @param volume the volume in range [0, 100]
@@ -206,7 +293,77 @@ namespace sfe
          * @return the current image of the movie for the activated video stream
          */
         const sf::Texture& getCurrentImage() const;
+        
+        /** @brief Register an observer that receives the decoded audio samples of the movie
+         *
+         * The observer stays registered when opening another media file. It is notified from the
+         * audio streaming thread, see AudioSampleObserver for the constraints this implies.
+         *
+         * @param observer the observer to register, it must outlive its registration
+         */
+        void addAudioSampleObserver(AudioSampleObserver& observer);
+        
+        /** @brief Unregister an observer previously registered with addAudioSampleObserver()
+         *
+         * Once this returns, the observer is guaranteed not to be notified anymore
+         *
+         * @param observer the observer to unregister
+         */
+        void removeAudioSampleObserver(AudioSampleObserver& observer);
+        
+        /** @brief Start computing peak, RMS and spectrum levels of the audio being played
+         *
+         * The analysis runs in a background thread and its results can be retrieved with
+         * getAudioSpectrum(). Enabling the analysis again only changes the count of frequency bands.
+         *
+         * @param bandCount the count of logarithmically spaced frequency bands to compute
+         */
+        void enableAudioAnalysis(unsigned int bandCount = 32);
+        
+        /** @brief Stop the audio analysis started with enableAudioAnalysis()
+         */
+        void disableAudioAnalysis();
+        
+        /** @brief Returns the latest audio analysis result
+         *
+         * This never blocks and is meant to be called once per rendered frame, after update()
+         *
+         * @param spectrum [out] the levels of the audio being heard
+         * @return true if a result was available, false if the analysis is disabled or has not
+         * received enough audio samples yet
+         */
+        bool getAudioSpectrum(AudioSpectrum& spectrum) const;
+        
+        /** @brief Returns the decoding and presentation statistics of the active streams
+         *
+         * The statistics are counted since the media was opened, they tell whether the machine keeps up
+         * with the media: late video frames are dropped, and the decoding times show which step is too slow.
+         *
+         * @return the statistics of each active stream
+         */
+        PlaybackStats getPlaybackStats() const;
+        
+        /** @brief Set how urgent decoding this movie is compared to the other movies
+         *
+         * This only matters when the video frames are decoded by worker threads, see
+         * DecodeThreads::setWorkerCount(). Their frames are decoded before the ones of movies
+         * of lower priority, whatever their display time. The default priority is 0.
+         *
+         * @param priority the decoding priority of this movie, higher is more urgent
+         */
+        void setDecodePriority(int priority);
+        
+        /** @brief Returns the memory used by the buffers of this movie
+         *
+         * This includes the buffers of the subtitle files added with addSubtitleFile(). The limit of
+         * the memory used by all the movies is set with MemoryBudget::setLimit().
+         *
+         * @return the memory used by the buffers of this movie, in bytes
+         */
+        MemoryUsage getMemoryUsage() const;
     private:
+        friend class PlaybackClock;
+        
         void draw(sf::RenderTarget& Target, sf::RenderStates states) const;
         std::shared_ptr<MovieImpl> m_impl;
     };
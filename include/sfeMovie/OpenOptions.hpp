@@ -0,0 +1,57 @@
+
+/*
+ *  OpenOptions.hpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+
+#ifndef SFEMOVIE_OPEN_OPTIONS_HPP
+#define SFEMOVIE_OPEN_OPTIONS_HPP
+
+#include <SFML/System.hpp>
+#include <sfeMovie/Visibility.hpp>
+
+namespace sfe
+{
+    /** Options that bound the work done by Movie::openFromFile() to find the properties of the streams
+     *
+     * Some containers (MPEG-TS especially) don't describe their streams in a header, so the beginning of
+     * the media is read and a few frames are decoded when it is opened. Lower limits open faster, but
+     * streams whose properties could not be found within the limits are not playable.
+     *
+     * Containers such as MP4 and Matroska give the codec, video size and audio sample rate of each stream
+     * in their header. Trusting it skips reading the media altogether, but the duration and frame rate then
+     * only come from the header.
+     */
+    struct SFE_API OpenOptions
+    {
+        /** Default options, that use the FFmpeg limits
+         */
+        OpenOptions();
+        
+        sf::Int64 probeSize;        //!< Maximum amount of bytes read to find the stream properties, 0 for the FFmpeg default (5 MB)
+        sf::Time analyzeDuration;   //!< Maximum media duration read to find the stream properties, zero for the FFmpeg default (5 seconds)
+        int fpsProbeSize;           //!< Maximum count of frames decoded to guess the video frame rate, -1 for the FFmpeg default
+        bool trustContainerHeader;  //!< Whether to skip reading the media when the container header describes all the streams
+    };
+}
+
+#endif
@@ -0,0 +1,128 @@
+
+/*
+ *  PlaybackClock.hpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef SFEMOVIE_PLAYBACK_CLOCK_HPP
+#define SFEMOVIE_PLAYBACK_CLOCK_HPP
+
+#include <SFML/System.hpp>
+#include <sfeMovie/Movie.hpp>
+#include <sfeMovie/Visibility.hpp>
+#include <cstddef>
+#include <memory>
+
+namespace sfe
+{
+    class PlaybackClockImpl;
+    /** Playback position shared by several movies, to play them in sync
+     *
+     * The movies attached to the same clock display the frames matching the position of the clock.
+     * Playing, pausing, stopping and seeking apply to all of them together, whether it is done with
+     * the clock or with one of its movies. The clock only starts once all the movies are ready to
+     * play, and the movies seek in parallel when decoding threads are enabled (see DecodeThreads).
+     *
+     * A movie that reaches its end stops on its own, and stays stopped until the clock is stopped
+     * or seeks.
+     */
+    class SFE_API PlaybackClock
+    {
+    public:
+        PlaybackClock();
+        
+        /** Detach all the movies, they keep playing on their own
+         */
+        ~PlaybackClock();
+        
+        /** @brief Make a movie follow this clock
+         *
+         * The movie is stopped if it was not, then brought to the position and status of the clock.
+         * A movie can only follow one clock, it is detached from its previous clock if any. Movies
+         * opening another media file stay attached.
+         *
+         * @param movie the movie to attach, it is detached when destroyed
+         */
+        void attach(Movie& movie);
+        
+        /** @brief Stop making a movie follow this clock
+         *
+         * The movie keeps its status and carries on from the position of the clock
+         *
+         * @param movie the movie to detach
+         */
+        void detach(Movie& movie);
+        
+        /** @brief Returns the count of movies attached to this clock
+         *
+         * @return the count of attached movies
+         */
+        std::size_t getMovieCount() const;
+        
+        /** @brief Start or resume playing all the attached movies
+         */
+        void play();
+        
+        /** @brief Pause all the attached movies
+         */
+        void pause();
+        
+        /** @brief Stop all the attached movies and reset the position of the clock
+         */
+        void stop();
+        
+        /** @brief Seek all the attached movies
+         *
+         * The movies that are shorter than the given position are stopped
+         *
+         * @param position the new position of the clock
+         * @return true if all the movies could seek, false otherwise
+         */
+        bool setPlayingOffset(sf::Time position);
+        
+        /** @brief Returns the status of the clock
+         *
+         * @return See enum Status
+         */
+        Status getStatus() const;
+        
+        /** @brief Returns the position of the clock
+         *
+         * @return the playing position shared by the attached movies
+         */
+        sf::Time getPlayingOffset() const;
+        
+        /** @brief Returns how far the given movie is from the clock
+         *
+         * This accounts for the movie position and for how late its latest video frame was displayed.
+         * It is zero while the movie keeps up, negative when it lags behind the clock.
+         *
+         * @param movie an attached movie
+         * @return the drift of @a movie, zero if it is not attached
+         */
+        sf::Time getDrift(const Movie& movie) const;
+    
+    private:
+        std::shared_ptr<PlaybackClockImpl> m_impl;
+    };
+}
+
+#endif
@@ -0,0 +1,103 @@
+
+/*
+ *  PlaybackStats.hpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef SFEMOVIE_PLAYBACK_STATS_HPP
+#define SFEMOVIE_PLAYBACK_STATS_HPP
+
+#include <SFML/System.hpp>
+#include <sfeMovie/Visibility.hpp>
+#include <sfeMovie/StreamSelection.hpp>
+#include <vector>
+
+namespace sfe
+{
+    /** Distribution of durations, counted in buckets of exponentially growing size
+     *
+     * Bucket 0 counts the durations below 1 microsecond, and bucket i counts the durations in range
+     * [2^(i-1), 2^i[ microseconds. The last bucket also counts all the longer durations.
+     */
+    struct SFE_API TimeHistogram
+    {
+        static const unsigned int BucketCount = 24;
+        
+        TimeHistogram();
+        
+        /** Count the given duration
+         */
+        void add(sf::Time duration);
+        
+        /** @return the average of the counted durations, or zero if none was counted
+         */
+        sf::Time getMean() const;
+        
+        /** Estimate the duration below which the given ratio of the counted durations are
+         *
+         * The estimation is the upper bound of the bucket where the percentile falls, it is thus
+         * at most twice the actual value
+         *
+         * @param ratio the ratio of counted durations, in range [0, 1] (ie. 0.99 for the 99th percentile)
+         * @return the estimated percentile, or zero if no duration was counted
+         */
+        sf::Time getPercentile(float ratio) const;
+        
+        /** @return the duration from which durations are not counted in the given bucket anymore,
+         * except for the last bucket
+         */
+        static sf::Time getBucketUpperBound(unsigned int bucket);
+        
+        sf::Uint64 count;                   //!< Count of durations
+        sf::Time total;                     //!< Sum of the durations
+        sf::Time maximum;                   //!< Longest duration
+        sf::Uint64 buckets[BucketCount];    //!< Count of durations in each bucket
+    };
+    
+    /** Decoding and presentation statistics of a stream since the media was opened
+     */
+    struct SFE_API StreamStats
+    {
+        StreamStats();
+        
+        StreamDescriptor stream;        //!< The stream these statistics are about
+        sf::Uint64 framesDecoded;       //!< Video frames, audio frames or subtitles decoded
+        sf::Uint64 framesPresented;     //!< Video frames displayed
+        sf::Uint64 framesDroppedLate;   //!< Video frames decoded too late to be displayed
+        sf::Uint64 framesRepeated;      //!< Video frames that stayed displayed at least one frame longer than planned
+        TimeHistogram decodeTime;       //!< Time spent decoding each frame
+        TimeHistogram convertTime;      //!< Time spent converting each frame to RGBA pixels or 16 bits stereo samples
+        TimeHistogram uploadTime;       //!< Time spent uploading each video frame to its texture
+        TimeHistogram syncError;        //!< Gap between each displayed video frame and the playback position
+        TimeHistogram playLatency;      //!< Time the audio output took to start playing, which delays the movie
+        TimeHistogram pauseLatency;     //!< Time the audio output took to pause
+        TimeHistogram stopLatency;      //!< Time the audio output took to stop
+    };
+    
+    /** Statistics returned by Movie::getPlaybackStats()
+     */
+    struct SFE_API PlaybackStats
+    {
+        std::vector<StreamStats> streams; //!< Statistics of each active stream
+    };
+}
+
+#endif
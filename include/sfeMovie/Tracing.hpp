@@ -0,0 +1,69 @@
+
+/*
+ *  Tracing.hpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef SFEMOVIE_TRACING_HPP
+#define SFEMOVIE_TRACING_HPP
+
+#include <sfeMovie/Visibility.hpp>
+#include <string>
+
+namespace sfe
+{
+    /** Timing of the playback pipeline stages, for finding what stalls playback
+     *
+     * When sfeMovie is built with SFEMOVIE_ENABLE_TRACING, the time spent reading packets, decoding,
+     * converting and uploading frames and notifying the timer observers is recorded on each thread.
+     * The result can be opened in chrome://tracing or https://ui.perfetto.dev.
+     *
+     * Without SFEMOVIE_ENABLE_TRACING, nothing is recorded and tracing has no cost.
+     */
+    namespace Tracing
+    {
+        /** @return true if sfeMovie was built with tracing support
+         */
+        SFE_API bool isAvailable();
+        
+        /** Start recording, the previously recorded spans are dropped
+         *
+         * Each thread keeps its latest spans only, older ones are overwritten when recording for long
+         */
+        SFE_API void start();
+        
+        /** Stop recording, the recorded spans are kept until the next start()
+         */
+        SFE_API void stop();
+        
+        /** Write the recorded spans in the Chrome trace event JSON format
+         *
+         * Spans that are recorded while writing may be missing or truncated, stop recording first for
+         * a consistent trace
+         *
+         * @param filename the path of the JSON file to write
+         * @return true on success, false if the file could not be written or tracing is not available
+         */
+        SFE_API bool writeChromeTrace(const std::string& filename);
+    }
+}
+
+#endif
@@ -0,0 +1,124 @@
+
+/*
+ *  WaveformOverview.hpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+
+#ifndef SFEMOVIE_WAVEFORM_OVERVIEW_HPP
+#define SFEMOVIE_WAVEFORM_OVERVIEW_HPP
+
+#include <SFML/System.hpp>
+#include <sfeMovie/Visibility.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sfe
+{
+    /** Lowest and highest sample values over a slice of time, all channels merged
+     */
+    struct SFE_API WaveformPeak
+    {
+        float minimum;  //!< Lowest sample value, in range [-1, 1]
+        float maximum;  //!< Highest sample value, in range [-1, 1]
+        bool decoded;   //!< False if the audio of this slice has not been decoded yet
+    };
+    
+    class WaveformOverviewImpl;
+    /** Computes the waveform of a whole audio track in the background, typically for displaying
+     * it in a timeline
+     *
+     * The media is opened independently from any Movie and its first audio stream is decoded as
+     * fast as possible. The waveform can be queried while it is being computed, slices that are
+     * not decoded yet are reported as such.
+     */
+    class SFE_API WaveformOverview
+    {
+    public:
+        WaveformOverview();
+        ~WaveformOverview();
+        
+        /** @brief Start computing the waveform of the given media
+         *
+         * Any computation in progress is cancelled first. The media is opened before returning,
+         * the decoding itself happens in background threads.
+         *
+         * @param filename the path to the media file
+         * @param segmentCount the count of parts of the media that are decoded in parallel, 0 to use
+         * as many as there are CPU cores. Media whose duration is unknown are always decoded
+         * as one part
+         * @return true if decoding could start, false if the media could not be opened or has no
+         * audio stream
+         */
+        bool generateFromFile(const std::string& filename, unsigned int segmentCount = 1);
+        
+        /** @brief Stop the computation in progress, the peaks computed so far are kept
+         */
+        void cancel();
+        
+        /** @brief Tell whether the decoding of the whole audio track is over
+         *
+         * Parts of the track that could not be decoded don't prevent completion, see hasFailed()
+         *
+         * @return true if the waveform is complete, false otherwise
+         */
+        bool isComplete() const;
+        
+        /** @brief Tell whether parts of the audio track could not be decoded
+         *
+         * The peaks of these parts are reported as not decoded
+         *
+         * @return true if decoding failed for some parts of the track, false otherwise
+         */
+        bool hasFailed() const;
+        
+        /** @brief Returns how much of the audio track has been decoded
+         *
+         * @return the decoding progress, in range [0, 1]
+         */
+        float getProgress() const;
+        
+        /** @brief Returns the duration of the audio track
+         *
+         * @return the duration of the media, or zero if it is unknown
+         */
+        sf::Time getDuration() const;
+        
+        /** @brief Summarize the waveform over the given time range
+         *
+         * The range is split into @a peakCount slices of equal duration. This is cheap enough
+         * to be called for every displayed frame, whatever the range.
+         *
+         * @param begin the beginning of the time range
+         * @param end the end of the time range
+         * @param peakCount the count of slices, typically the width in pixels of the displayed waveform
+         * @param[out] peaks the @a peakCount peaks
+         * @return true if a waveform is being or has been computed, false otherwise
+         */
+        bool getPeaks(sf::Time begin, sf::Time end, std::size_t peakCount, std::vector<WaveformPeak>& peaks) const;
+    
+    private:
+        std::shared_ptr<WaveformOverviewImpl> m_impl;
+    };
+}
+
+#endif
@@ -0,0 +1,257 @@
+
+/*
+ *  AudioAnalyzer.cpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#include "AudioAnalyzer.hpp"
+#include "Macros.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace sfe
+{
+    namespace
+    {
+        const unsigned int WindowSize = 2048;       // frames analyzed at once
+        const unsigned int HistorySeconds = 4;      // must cover the audio playback buffering
+        const float LowestBandFrequency = 40.f;     // Hz
+        const float HighestBandFrequency = 16000.f; // Hz
+        const float DynamicRange = 80.f;            // dB mapped to [0, 1]
+        const int SnapshotIndexMask = 3;
+        const int DirtySnapshot = 4;
+        
+        sf::Time framesToTime(sf::Int64 frames, unsigned int sampleRate)
+        {
+            return sf::microseconds(frames * 1000000 / sampleRate);
+        }
+    }
+    
+    AudioAnalyzer::AudioAnalyzer(unsigned int bandCount) :
+    m_bandCount(bandCount),
+    m_fft(WindowSize),
+    m_window(WindowSize),
+    m_real(WindowSize),
+    m_imag(WindowSize),
+    m_analyzedSamples(WindowSize * 2),
+    m_history(),
+    m_writtenFrames(0),
+    m_historyBasePosition(sf::Time::Zero),
+    m_sampleRate(0),
+    m_shouldStop(false),
+    m_requestedPosition(0),
+    m_backSnapshot(0),
+    m_frontSnapshot(2),
+    m_middleSnapshot(1),
+    m_hasSnapshot(false),
+    m_hasPendingWork(false)
+    {
+        CHECK(bandCount > 0, "AudioAnalyzer::AudioAnalyzer() - invalid argument: bandCount");
+        
+        // Hann window
+        const double pi = 3.14159265358979323846;
+        for (unsigned int i = 0; i < WindowSize; i++)
+            m_window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2 * pi * i / (WindowSize - 1)));
+        
+        for (AudioSpectrum& snapshot : m_snapshots)
+            snapshot.bands.resize(bandCount);
+        
+        m_thread = std::thread(&AudioAnalyzer::run, this);
+    }
+    
+    AudioAnalyzer::~AudioAnalyzer()
+    {
+        m_shouldStop = true;
+        wakeUp();
+        m_thread.join();
+    }
+    
+    void AudioAnalyzer::didReceiveAudioSamples(const sf::Int16* samples, std::size_t sampleCount,
+                                               unsigned int channelCount, unsigned int sampleRate,
+                                               sf::Time position)
+    {
+        // sfeMovie always plays stereo audio
+        if (channelCount != 2 || sampleRate == 0)
+            return;
+        
+        std::size_t frameCount = sampleCount / 2;
+        
+        {
+            std::lock_guard<std::mutex> lock(m_historyMutex);
+            
+            if (sampleRate != m_sampleRate)
+            {
+                m_sampleRate = sampleRate;
+                m_history.assign(HistorySeconds * sampleRate * 2, 0);
+                m_writtenFrames = 0;
+                m_historyBasePosition = position;
+            }
+            
+            // Samples that do not follow the previous ones mean seeking happened: restart the history
+            const sf::Time expectedPosition = m_historyBasePosition + framesToTime(m_writtenFrames, m_sampleRate);
+            const sf::Time gap = position - expectedPosition;
+            if (gap > sf::milliseconds(5) || gap < sf::milliseconds(-5))
+            {
+                m_writtenFrames = 0;
+                m_historyBasePosition = position;
+            }
+            
+            const std::size_t capacity = m_history.size() / 2;
+            if (frameCount > capacity)
+            {
+                samples += (frameCount - capacity) * 2;
+                m_writtenFrames += frameCount - capacity;
+                frameCount = capacity;
+            }
+            
+            const std::size_t writeIndex = static_cast<std::size_t>(m_writtenFrames % capacity);
+            const std::size_t firstPart = std::min(frameCount, capacity - writeIndex);
+            std::memcpy(&m_history[writeIndex * 2], samples, firstPart * 2 * sizeof(sf::Int16));
+            std::memcpy(&m_history[0], samples + firstPart * 2, (frameCount - firstPart) * 2 * sizeof(sf::Int16));
+            m_writtenFrames += frameCount;
+        }
+        
+        m_hasPendingWork = true;
+        wakeUp();
+    }
+    
+    void AudioAnalyzer::setPlaybackPosition(sf::Time position)
+    {
+        if (m_requestedPosition.exchange(position.asMicroseconds()) != position.asMicroseconds())
+        {
+            m_hasPendingWork = true;
+            wakeUp();
+        }
+    }
+    
+    bool AudioAnalyzer::getSpectrum(AudioSpectrum& spectrum) const
+    {
+        if (!m_hasSnapshot)
+            return false;
+        
+        if (m_middleSnapshot.load() & DirtySnapshot)
+        {
+            const int previous = m_middleSnapshot.exchange(m_frontSnapshot);
+            m_frontSnapshot = previous & SnapshotIndexMask;
+        }
+        
+        spectrum = m_snapshots[m_frontSnapshot];
+        return true;
+    }
+    
+    void AudioAnalyzer::wakeUp()
+    {
+        // Once the lock is taken, the worker either waits or has not checked for work yet
+        {
+            std::lock_guard<std::mutex> lock(m_wakeUpMutex);
+        }
+        
+        m_wakeUpCondition.notify_one();
+    }
+    
+    void AudioAnalyzer::run()
+    {
+        while (!m_shouldStop)
+        {
+            {
+                // Sleep until samples or a new position arrive, a paused movie sends none
+                std::unique_lock<std::mutex> lock(m_wakeUpMutex);
+                m_wakeUpCondition.wait(lock, [this] { return m_shouldStop || m_hasPendingWork; });
+            }
+            
+            if (m_shouldStop || !m_hasPendingWork.exchange(false))
+                continue;
+            
+            if (analyze(m_snapshots[m_backSnapshot]))
+                publish();
+        }
+    }
+    
+    bool AudioAnalyzer::analyze(AudioSpectrum& spectrum)
+    {
+        const sf::Time position = sf::microseconds(m_requestedPosition.load());
+        unsigned int sampleRate = 0;
+        
+        {
+            std::lock_guard<std::mutex> lock(m_historyMutex);
+            
+            if (m_history.empty())
+                return false;
+            
+            sampleRate = m_sampleRate;
+            const sf::Int64 capacity = m_history.size() / 2;
+            
+            // When the requested position has not been decoded yet, the latest samples are the best guess
+            sf::Int64 endFrame = (position - m_historyBasePosition).asMicroseconds() * sampleRate / 1000000;
+            endFrame = std::min(endFrame, m_writtenFrames);
+            const sf::Int64 startFrame = endFrame - WindowSize;
+            
+            if (startFrame < 0 || startFrame < m_writtenFrames - capacity)
+                return false;
+            
+            const std::size_t readIndex = static_cast<std::size_t>(startFrame % capacity);
+            const std::size_t firstPart = std::min<std::size_t>(WindowSize, capacity - readIndex);
+            std::memcpy(&m_analyzedSamples[0], &m_history[readIndex * 2], firstPart * 2 * sizeof(sf::Int16));
+            std::memcpy(&m_analyzedSamples[firstPart * 2], &m_history[0],
+                        (WindowSize - firstPart) * 2 * sizeof(sf::Int16));
+        }
+        
+        AudioKernels::computeStereoLevels(m_analyzedSamples.data(), WindowSize, spectrum.peak, spectrum.rms);
+        AudioKernels::downmixStereoWindowed(m_analyzedSamples.data(), m_window.data(), WindowSize, m_real.data());
+        std::fill(m_imag.begin(), m_imag.end(), 0.f);
+        m_fft.transform(m_real.data(), m_imag.data());
+        
+        // A full scale sine wave reaches WindowSize / 4 once weighted by the Hann window
+        const float reference = WindowSize / 4.f;
+        const unsigned int binCount = WindowSize / 2;
+        const float highestFrequency = std::min(HighestBandFrequency, sampleRate / 2.f);
+        const float bandRatio = std::pow(highestFrequency / LowestBandFrequency, 1.f / m_bandCount);
+        float bandStart = LowestBandFrequency;
+        
+        for (unsigned int band = 0; band < m_bandCount; band++)
+        {
+            const float bandEnd = bandStart * bandRatio;
+            unsigned int firstBin = static_cast<unsigned int>(bandStart * WindowSize / sampleRate);
+            unsigned int lastBin = static_cast<unsigned int>(std::ceil(bandEnd * WindowSize / sampleRate));
+            firstBin = std::min(std::max(firstBin, 1u), binCount - 1);
+            lastBin = std::min(std::max(lastBin, firstBin + 1), binCount);
+            
+            float magnitude = 0;
+            for (unsigned int bin = firstBin; bin < lastBin; bin++)
+                magnitude = std::max(magnitude, m_real[bin] * m_real[bin] + m_imag[bin] * m_imag[bin]);
+            
+            const float decibels = 10.f * std::log10(magnitude / (reference * reference) + 1e-12f);
+            spectrum.bands[band] = std::min(std::max((decibels + DynamicRange) / DynamicRange, 0.f), 1.f);
+            bandStart = bandEnd;
+        }
+        
+        spectrum.position = position;
+        return true;
+    }
+    
+    void AudioAnalyzer::publish()
+    {
+        const int previous = m_middleSnapshot.exchange(m_backSnapshot | DirtySnapshot);
+        m_backSnapshot = previous & SnapshotIndexMask;
+        m_hasSnapshot = true;
+    }
+}
@@ -0,0 +1,134 @@
+
+/*
+ *  AudioAnalyzer.hpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef SFEMOVIE_AUDIO_ANALYZER_HPP
+#define SFEMOVIE_AUDIO_ANALYZER_HPP
+
+#include <sfeMovie/AudioAnalysis.hpp>
+#include "AudioKernels.hpp"
+#include <SFML/System.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sfe
+{
+    /** Computes peak, RMS and spectrum levels of the audio being played
+     *
+     * Three threads are involved:
+     * - the audio streaming thread gives the decoded samples, that are kept in a short history
+     * - a worker thread analyzes the history window matching the requested playback position
+     * - the render thread requests the playback position and reads the latest analysis result
+     *   without ever locking
+     */
+    class AudioAnalyzer : public AudioSampleObserver
+    {
+    public:
+        /** Create the analyzer and start its worker thread
+         *
+         * @param bandCount the count of frequency bands to compute
+         */
+        AudioAnalyzer(unsigned int bandCount);
+        
+        /** Stop the worker thread
+         */
+        ~AudioAnalyzer();
+        
+        /** @see AudioSampleObserver::didReceiveAudioSamples()
+         */
+        void didReceiveAudioSamples(const sf::Int16* samples, std::size_t sampleCount,
+                                    unsigned int channelCount, unsigned int sampleRate,
+                                    sf::Time position) override;
+        
+        /** Tell the analyzer which position is currently being heard, so that the next analysis
+         * matches it
+         *
+         * @param position the current playback position
+         */
+        void setPlaybackPosition(sf::Time position);
+        
+        /** Get the latest analysis result
+         *
+         * This never blocks. It must always be called from the same thread
+         *
+         * @param[out] spectrum the latest analysis result, unmodified if none is available yet
+         * @return true if an analysis result was available, false otherwise
+         */
+        bool getSpectrum(AudioSpectrum& spectrum) const;
+    
+    private:
+        /** Wake the worker thread up after giving it work or asking it to stop
+         */
+        void wakeUp();
+        
+        /** Worker thread loop
+         */
+        void run();
+        
+        /** Analyze the history window that ends at the requested playback position
+         *
+         * @param[out] spectrum the analysis result
+         * @return true if enough samples were available for the analysis, false otherwise
+         */
+        bool analyze(AudioSpectrum& spectrum);
+        
+        /** Make the back snapshot slot the latest available result
+         */
+        void publish();
+        
+        unsigned int m_bandCount;
+        FFT m_fft;
+        std::vector<float> m_window;
+        std::vector<float> m_real;
+        std::vector<float> m_imag;
+        std::vector<sf::Int16> m_analyzedSamples;
+        
+        // Samples history, shared between the audio thread and the worker thread
+        std::mutex m_historyMutex;
+        std::vector<sf::Int16> m_history;
+        sf::Int64 m_writtenFrames;
+        sf::Time m_historyBasePosition;
+        unsigned int m_sampleRate;
+        
+        // Worker
+        std::mutex m_wakeUpMutex;
+        std::condition_variable m_wakeUpCondition;
+        std::atomic<bool> m_shouldStop;
+        std::atomic<sf::Int64> m_requestedPosition;
+        
+        // Triple buffered results: the worker fills the back slot while the reader owns the front slot
+        AudioSpectrum m_snapshots[3];
+        int m_backSnapshot;
+        mutable int m_frontSnapshot;
+        mutable std::atomic<int> m_middleSnapshot;
+        std::atomic<bool> m_hasSnapshot;
+        std::atomic<bool> m_hasPendingWork;
+        
+        std::thread m_thread;
+    };
+}
+
+#endif
@@ -0,0 +1,73 @@
+
+/*
+ *  AudioClip.cpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#include <sfeMovie/AudioClip.hpp>
+#include "AudioClipImpl.hpp"
+
+namespace sfe
+{
+    AudioClip::AudioClip() :
+    m_impl(new AudioClipImpl())
+    {
+    }
+    
+    AudioClip::~AudioClip()
+    {
+    }
+    
+    bool AudioClip::loadFromFile(const std::string& filename, unsigned int segmentCount)
+    {
+        return m_impl->loadFromFile(filename, segmentCount);
+    }
+    
+    const sf::SoundBuffer& AudioClip::getBuffer() const
+    {
+        return m_impl->getBuffer();
+    }
+    
+    const sf::Int16* AudioClip::getSamples() const
+    {
+        return m_impl->getBuffer().getSampleCount() > 0 ? m_impl->getBuffer().getSamples() : nullptr;
+    }
+    
+    std::size_t AudioClip::getSampleCount() const
+    {
+        return static_cast<std::size_t>(m_impl->getBuffer().getSampleCount());
+    }
+    
+    unsigned int AudioClip::getChannelCount() const
+    {
+        return m_impl->getBuffer().getSampleCount() > 0 ? m_impl->getBuffer().getChannelCount() : 0;
+    }
+    
+    unsigned int AudioClip::getSampleRate() const
+    {
+        return m_impl->getBuffer().getSampleCount() > 0 ? m_impl->getBuffer().getSampleRate() : 0;
+    }
+    
+    sf::Time AudioClip::getDuration() const
+    {
+        return m_impl->getBuffer().getDuration();
+    }
+}
@@ -0,0 +1,243 @@
+
+/*
+ *  AudioClipImpl.cpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#include "AudioClipImpl.hpp"
+#include "AudioSegmentDecoder.hpp"
+#include "Log.hpp"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace sfe
+{
+    namespace
+    {
+        // Each segment costs a seek and a decoder, don't split the media into tiny parts
+        const float MinimumSegmentDuration = 10.f; // seconds
+        
+        // Values of Segment::startFrame when the first kept frame is not known yet, and when
+        // the segment has nothing to give so that the previous one must decode up to the end
+        const sf::Int64 UnknownFrame = -1;
+        const sf::Int64 EndFrame = std::numeric_limits<sf::Int64>::max();
+        
+        sf::Int64 timeToFrames(sf::Time time, unsigned int sampleRate)
+        {
+            return time.asMicroseconds() * sampleRate / 1000000;
+        }
+    }
+    
+    AudioClipImpl::Segment::Segment(sf::Time begin) :
+    begin(begin),
+    samples(),
+    firstFrame(0),
+    startFrame(UnknownFrame)
+    {
+    }
+    
+    AudioClipImpl::AudioClipImpl() :
+    m_buffer()
+    {
+    }
+    
+    bool AudioClipImpl::loadFromFile(const std::string& filename, unsigned int segmentCount)
+    {
+        // Open the media synchronously so that errors can be reported, this decoder is
+        // then used for the first segment
+        std::shared_ptr<AudioSegmentDecoder> firstDecoder;
+        
+        try
+        {
+            firstDecoder = std::make_shared<AudioSegmentDecoder>(filename);
+        }
+        catch (std::runtime_error& e)
+        {
+            sfeLogError("AudioClip::loadFromFile() - " + std::string(e.what()));
+            return false;
+        }
+        
+        const unsigned int sampleRate = firstDecoder->getSampleRate();
+        const unsigned int channelCount = firstDecoder->getChannelCount();
+        const sf::Int64 duration = firstDecoder->getDuration().asMicroseconds();
+        
+        if (segmentCount == 0)
+            segmentCount = std::max(std::thread::hardware_concurrency(), 1u);
+        
+        const unsigned int maxSegmentCount = std::max(static_cast<unsigned int>(duration / 1000000.f /
+                                                                                MinimumSegmentDuration), 1u);
+        segmentCount = std::min(segmentCount, maxSegmentCount);
+        
+        std::vector<std::unique_ptr<Segment> > segments;
+        std::vector<std::thread> workers;
+        
+        for (unsigned int i = 0; i < segmentCount; i++)
+            segments.push_back(std::unique_ptr<Segment>(new Segment(sf::microseconds(duration * i / segmentCount))));
+        
+        for (unsigned int i = 0; i < segmentCount; i++)
+        {
+            workers.push_back(std::thread(&AudioClipImpl::decodeSegment, (i == 0) ? firstDecoder : nullptr,
+                                          std::cref(filename), sampleRate, std::ref(*segments[i]),
+                                          (i + 1 < segmentCount) ? segments[i + 1].get() : nullptr));
+        }
+        
+        firstDecoder.reset();
+        
+        for (std::thread& worker : workers)
+            worker.join();
+        
+        if (segments[0]->samples.empty())
+        {
+            sfeLogError("AudioClip::loadFromFile() - could not decode any audio from " + filename);
+            return false;
+        }
+        
+        // Each segment gives its frames up to the first frame of the next segment that could be decoded
+        const sf::Int64 origin = segments[0]->firstFrame;
+        std::vector<sf::Int64> keptFrames(segmentCount, 0);
+        sf::Int64 frameCount = 0;
+        
+        for (unsigned int i = 0; i < segmentCount; i++)
+        {
+            const Segment& segment = *segments[i];
+            
+            if (segment.samples.empty() || segment.firstFrame < origin)
+                continue;
+            
+            keptFrames[i] = segment.samples.size() / channelCount;
+            
+            for (unsigned int j = i + 1; j < segmentCount; j++)
+            {
+                if (!segments[j]->samples.empty())
+                {
+                    keptFrames[i] = std::min(keptFrames[i], std::max<sf::Int64>(segments[j]->firstFrame -
+                                                                                segment.firstFrame, 0));
+                    break;
+                }
+            }
+            
+            frameCount = std::max(frameCount, segment.firstFrame - origin + keptFrames[i]);
+        }
+        
+        // Parts that no segment could decode are left silent
+        std::vector<sf::Int16> samples(static_cast<std::size_t>(frameCount * channelCount), 0);
+        
+        for (unsigned int i = 0; i < segmentCount; i++)
+        {
+            Segment& segment = *segments[i];
+            
+            if (keptFrames[i] > 0)
+            {
+                std::copy(segment.samples.begin(), segment.samples.begin() + keptFrames[i] * channelCount,
+                          samples.begin() + (segment.firstFrame - origin) * channelCount);
+            }
+            
+            std::vector<sf::Int16>().swap(segment.samples);
+        }
+        
+        if (!m_buffer.loadFromSamples(samples.data(), samples.size(), channelCount, sampleRate))
+        {
+            sfeLogError("AudioClip::loadFromFile() - could not create the sound buffer for " + filename);
+            return false;
+        }
+        
+        sfeLogDebug("AudioClip - decoded " + s(m_buffer.getDuration().asSeconds()) + "s of audio from "
+                    + filename + " in " + s(segmentCount) + " segment(s)");
+        return true;
+    }
+    
+    const sf::SoundBuffer& AudioClipImpl::getBuffer() const
+    {
+        return m_buffer;
+    }
+    
+    void AudioClipImpl::decodeSegment(std::shared_ptr<AudioSegmentDecoder> decoder, const std::string& filename,
+                                      unsigned int sampleRate, Segment& segment, const Segment* nextSegment)
+    {
+        try
+        {
+            if (!decoder)
+                decoder = std::make_shared<AudioSegmentDecoder>(filename);
+            
+            if (segment.begin > sf::Time::Zero && !decoder->seek(segment.begin))
+            {
+                sfeLogError("AudioClip - could not seek to " + s(segment.begin.asSeconds())
+                            + "s, the previous segment will be decoded further");
+            }
+            else
+            {
+                const unsigned int channelCount = decoder->getChannelCount();
+                bool shouldDropChunk = segment.begin > sf::Time::Zero;
+                bool hasMoreData = true;
+                
+                while (hasMoreData)
+                {
+                    const sf::Int16* samples = nullptr;
+                    std::size_t sampleCount = 0;
+                    sf::Time position;
+                    
+                    hasMoreData = decoder->decodeSamples(samples, sampleCount, position);
+                    
+                    const std::size_t chunkFrameCount = sampleCount / channelCount;
+                    
+                    if (chunkFrameCount == 0)
+                        continue;
+                    
+                    if (shouldDropChunk)
+                    {
+                        shouldDropChunk = false;
+                        continue;
+                    }
+                    
+                    const sf::Int64 chunkFirstFrame = timeToFrames(position, sampleRate);
+                    
+                    if (segment.samples.empty())
+                    {
+                        segment.firstFrame = chunkFirstFrame;
+                        segment.startFrame = chunkFirstFrame;
+                    }
+                    
+                    segment.samples.insert(segment.samples.end(), samples, samples + chunkFrameCount * channelCount);
+                    
+                    // Stop once the next segment has taken over
+                    if (nextSegment)
+                    {
+                        const sf::Int64 nextStartFrame = nextSegment->startFrame;
+                        
+                        if (nextStartFrame != UnknownFrame &&
+                            chunkFirstFrame + static_cast<sf::Int64>(chunkFrameCount) >= nextStartFrame)
+                            break;
+                    }
+                }
+            }
+        }
+        catch (std::runtime_error& e)
+        {
+            sfeLogError("AudioClip - decoding failure: " + std::string(e.what()));
+        }
+        
+        if (segment.samples.empty())
+            segment.startFrame = EndFrame;
+    }
+}
@@ -0,0 +1,86 @@
+
+/*
+ *  AudioClipImpl.hpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef SFEMOVIE_AUDIO_CLIP_IMPL_HPP
+#define SFEMOVIE_AUDIO_CLIP_IMPL_HPP
+
+#include <SFML/Audio.hpp>
+#include <SFML/System.hpp>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sfe
+{
+    class AudioSegmentDecoder;
+    
+    class AudioClipImpl
+    {
+    public:
+        AudioClipImpl();
+        
+        /** @see AudioClip::loadFromFile()
+         */
+        bool loadFromFile(const std::string& filename, unsigned int segmentCount);
+        
+        /** @see AudioClip::getBuffer()
+         */
+        const sf::SoundBuffer& getBuffer() const;
+    
+    private:
+        /** Samples decoded by one worker thread
+         *
+         * Seeking does not give sample accurate positions, so the segments are not cut at fixed
+         * positions: each segment but the first one drops its first decoded chunk, in case the decoder
+         * needed preceding packets to decode it properly, then publishes the position of the chunk
+         * it really starts with. The previous segment decodes up to that position, so that
+         * segments are stitched at packet boundaries.
+         */
+        struct Segment
+        {
+            Segment(sf::Time begin);
+            
+            sf::Time begin;                     //!< Position to seek to before decoding
+            std::vector<sf::Int16> samples;     //!< Interleaved decoded samples
+            sf::Int64 firstFrame;               //!< Position of the first decoded frame, in frames
+            std::atomic<sf::Int64> startFrame;  //!< Published value of firstFrame, see UnknownFrame and EndFrame
+        };
+        
+        /** Decode the given segment, run by the worker threads
+         *
+         * @param decoder the decoder to use, or nullptr to open a new one
+         * @param filename the path of the media to decode
+         * @param sampleRate the sample rate of the decoded samples
+         * @param segment the segment to fill
+         * @param nextSegment the following segment, or nullptr if @a segment is the last one
+         */
+        static void decodeSegment(std::shared_ptr<AudioSegmentDecoder> decoder, const std::string& filename,
+                                  unsigned int sampleRate, Segment& segment, const Segment* nextSegment);
+        
+        sf::SoundBuffer m_buffer;
+    };
+}
+
+#endif
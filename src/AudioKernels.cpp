@@ -0,0 +1,339 @@
+
+/*
+ *  AudioKernels.cpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#include "AudioKernels.hpp"
+#include "Macros.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#if SFEMOVIE_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace sfe
+{
+    namespace
+    {
+        sf::Int16 saturate(float value)
+        {
+            const float rounded = value < 0 ? value - 0.5f : value + 0.5f;
+            return static_cast<sf::Int16>(std::min(std::max(rounded, -32768.f), 32767.f));
+        }
+
+#if SFEMOVIE_HAS_SSE2
+        // Sign extend 8 signed 16 bits samples to two vectors of 4 floats
+        void widen(__m128i v, __m128& low, __m128& high)
+        {
+            low = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+            high = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+        }
+        
+        // Round two vectors of 4 floats back to 8 saturated signed 16 bits samples
+        __m128i narrow(__m128 low, __m128 high)
+        {
+            return _mm_packs_epi32(_mm_cvtps_epi32(low), _mm_cvtps_epi32(high));
+        }
+#endif
+    }
+    
+    namespace AudioKernels
+    {
+        void computeStereoLevels(const sf::Int16* samples, std::size_t frameCount, float peak[2], float rms[2])
+        {
+            const std::size_t sampleCount = frameCount * 2;
+            int maxLeft = 0;
+            int maxRight = 0;
+            double sumLeft = 0;
+            double sumRight = 0;
+            std::size_t i = 0;
+
+#if SFEMOVIE_HAS_SSE2
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i leftMask = _mm_set1_epi32(0x0000FFFF);
+            __m128i maxAbs = zero;
+            __m128 leftSquares = _mm_setzero_ps();
+            __m128 rightSquares = _mm_setzero_ps();
+            
+            for (; i + 8 <= sampleCount; i += 8)
+            {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i));
+                
+                // Saturating negation so that -32768 doesn't wrap around
+                maxAbs = _mm_max_epi16(maxAbs, _mm_max_epi16(v, _mm_subs_epi16(zero, v)));
+                
+                // Samples are interleaved: the low half of each 32 bits lane is a left sample,
+                // the high half is a right sample. Masking out one of them lets madd compute x²
+                const __m128i left = _mm_and_si128(v, leftMask);
+                const __m128i right = _mm_andnot_si128(leftMask, v);
+                leftSquares = _mm_add_ps(leftSquares, _mm_cvtepi32_ps(_mm_madd_epi16(left, left)));
+                rightSquares = _mm_add_ps(rightSquares, _mm_cvtepi32_ps(_mm_madd_epi16(right, right)));
+            }
+            
+            sf::Int16 maxLanes[8];
+            float leftLanes[4];
+            float rightLanes[4];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(maxLanes), maxAbs);
+            _mm_storeu_ps(leftLanes, leftSquares);
+            _mm_storeu_ps(rightLanes, rightSquares);
+            
+            for (int lane = 0; lane < 4; lane++)
+            {
+                maxLeft = std::max<int>(maxLeft, maxLanes[2 * lane]);
+                maxRight = std::max<int>(maxRight, maxLanes[2 * lane + 1]);
+                sumLeft += leftLanes[lane];
+                sumRight += rightLanes[lane];
+            }
+#endif
+            
+            for (; i + 1 < sampleCount; i += 2)
+            {
+                const int left = samples[i];
+                const int right = samples[i + 1];
+                maxLeft = std::max(maxLeft, std::min(std::abs(left), 32767));
+                maxRight = std::max(maxRight, std::min(std::abs(right), 32767));
+                sumLeft += left * left;
+                sumRight += right * right;
+            }
+            
+            peak[0] = maxLeft / 32767.f;
+            peak[1] = maxRight / 32767.f;
+            
+            if (frameCount > 0)
+            {
+                rms[0] = static_cast<float>(std::sqrt(sumLeft / frameCount) / 32768.);
+                rms[1] = static_cast<float>(std::sqrt(sumRight / frameCount) / 32768.);
+            }
+            else
+            {
+                rms[0] = rms[1] = 0;
+            }
+        }
+        
+        void downmixStereoWindowed(const sf::Int16* samples, const float* window, std::size_t frameCount, float* output)
+        {
+            // (left + right) / 2 normalized to [-1, 1]
+            const float scale = 1.f / 65536.f;
+            std::size_t frame = 0;
+
+#if SFEMOVIE_HAS_SSE2
+            const __m128i ones = _mm_set1_epi16(1);
+            const __m128 vscale = _mm_set1_ps(scale);
+            
+            for (; frame + 4 <= frameCount; frame += 4)
+            {
+                // madd against ones sums each left/right pair into a 32 bits lane
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + 2 * frame));
+                const __m128 mono = _mm_mul_ps(_mm_cvtepi32_ps(_mm_madd_epi16(v, ones)), vscale);
+                _mm_storeu_ps(output + frame, _mm_mul_ps(mono, _mm_loadu_ps(window + frame)));
+            }
+#endif
+            
+            for (; frame < frameCount; frame++)
+            {
+                const int sum = samples[2 * frame] + samples[2 * frame + 1];
+                output[frame] = sum * scale * window[frame];
+            }
+        }
+        
+        void accumulateMinMax(const sf::Int16* samples, std::size_t sampleCount, sf::Int16& minimum, sf::Int16& maximum)
+        {
+            std::size_t i = 0;
+
+#if SFEMOVIE_HAS_SSE2
+            if (sampleCount >= 8)
+            {
+                __m128i vmin = _mm_set1_epi16(minimum);
+                __m128i vmax = _mm_set1_epi16(maximum);
+                
+                for (; i + 8 <= sampleCount; i += 8)
+                {
+                    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i));
+                    vmin = _mm_min_epi16(vmin, v);
+                    vmax = _mm_max_epi16(vmax, v);
+                }
+                
+                sf::Int16 minLanes[8];
+                sf::Int16 maxLanes[8];
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(minLanes), vmin);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(maxLanes), vmax);
+                
+                for (int lane = 0; lane < 8; lane++)
+                {
+                    minimum = std::min(minimum, minLanes[lane]);
+                    maximum = std::max(maximum, maxLanes[lane]);
+                }
+            }
+#endif
+            
+            for (; i < sampleCount; i++)
+            {
+                minimum = std::min(minimum, samples[i]);
+                maximum = std::max(maximum, samples[i]);
+            }
+        }
+        
+        void applyGain(sf::Int16* samples, std::size_t sampleCount, float gain)
+        {
+            std::size_t i = 0;
+
+#if SFEMOVIE_HAS_SSE2
+            const __m128 vgain = _mm_set1_ps(gain);
+            
+            for (; i + 8 <= sampleCount; i += 8)
+            {
+                __m128 low, high;
+                widen(_mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i)), low, high);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(samples + i),
+                                 narrow(_mm_mul_ps(low, vgain), _mm_mul_ps(high, vgain)));
+            }
+#endif
+            
+            for (; i < sampleCount; i++)
+                samples[i] = saturate(samples[i] * gain);
+        }
+        
+        void mixWithGain(sf::Int16* destination, const sf::Int16* source, std::size_t sampleCount, float gain)
+        {
+            std::size_t i = 0;
+
+#if SFEMOVIE_HAS_SSE2
+            const __m128 vgain = _mm_set1_ps(gain);
+            
+            for (; i + 8 <= sampleCount; i += 8)
+            {
+                __m128 destinationLow, destinationHigh, sourceLow, sourceHigh;
+                widen(_mm_loadu_si128(reinterpret_cast<const __m128i*>(destination + i)), destinationLow, destinationHigh);
+                widen(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i)), sourceLow, sourceHigh);
+                
+                const __m128 low = _mm_add_ps(destinationLow, _mm_mul_ps(sourceLow, vgain));
+                const __m128 high = _mm_add_ps(destinationHigh, _mm_mul_ps(sourceHigh, vgain));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), narrow(low, high));
+            }
+#endif
+            
+            for (; i < sampleCount; i++)
+                destination[i] = saturate(destination[i] + source[i] * gain);
+        }
+    }
+    
+    FFT::FFT(unsigned int size) :
+    m_size(size),
+    m_bitReversal(size),
+    m_twiddlesReal(size - 1),
+    m_twiddlesImag(size - 1)
+    {
+        CHECK(size >= 4 && (size & (size - 1)) == 0, "FFT::FFT() - size must be a power of two");
+        
+        unsigned int bits = 0;
+        while ((1u << bits) < size)
+            bits++;
+        
+        for (unsigned int i = 0; i < size; i++)
+        {
+            unsigned int reversed = 0;
+            for (unsigned int b = 0; b < bits; b++)
+            {
+                if (i & (1u << b))
+                    reversed |= 1u << (bits - 1 - b);
+            }
+            m_bitReversal[i] = reversed;
+        }
+        
+        const double pi = 3.14159265358979323846;
+        for (unsigned int half = 1; half < size; half <<= 1)
+        {
+            for (unsigned int j = 0; j < half; j++)
+            {
+                const double angle = -pi * j / half;
+                m_twiddlesReal[half - 1 + j] = static_cast<float>(std::cos(angle));
+                m_twiddlesImag[half - 1 + j] = static_cast<float>(std::sin(angle));
+            }
+        }
+    }
+    
+    unsigned int FFT::getSize() const
+    {
+        return m_size;
+    }
+    
+    void FFT::transform(float* real, float* imag) const
+    {
+        for (unsigned int i = 0; i < m_size; i++)
+        {
+            const unsigned int j = m_bitReversal[i];
+            if (j > i)
+            {
+                std::swap(real[i], real[j]);
+                std::swap(imag[i], imag[j]);
+            }
+        }
+        
+        for (unsigned int half = 1; half < m_size; half <<= 1)
+        {
+            const float* wr = &m_twiddlesReal[half - 1];
+            const float* wi = &m_twiddlesImag[half - 1];
+            
+            for (unsigned int start = 0; start < m_size; start += 2 * half)
+            {
+                float* ar = real + start;
+                float* ai = imag + start;
+                float* br = ar + half;
+                float* bi = ai + half;
+                unsigned int j = 0;
+
+#if SFEMOVIE_HAS_SSE2
+                for (; j + 4 <= half; j += 4)
+                {
+                    const __m128 twr = _mm_loadu_ps(wr + j);
+                    const __m128 twi = _mm_loadu_ps(wi + j);
+                    const __m128 vr = _mm_loadu_ps(br + j);
+                    const __m128 vi = _mm_loadu_ps(bi + j);
+                    const __m128 ur = _mm_loadu_ps(ar + j);
+                    const __m128 ui = _mm_loadu_ps(ai + j);
+                    
+                    const __m128 tr = _mm_sub_ps(_mm_mul_ps(vr, twr), _mm_mul_ps(vi, twi));
+                    const __m128 ti = _mm_add_ps(_mm_mul_ps(vr, twi), _mm_mul_ps(vi, twr));
+                    
+                    _mm_storeu_ps(ar + j, _mm_add_ps(ur, tr));
+                    _mm_storeu_ps(ai + j, _mm_add_ps(ui, ti));
+                    _mm_storeu_ps(br + j, _mm_sub_ps(ur, tr));
+                    _mm_storeu_ps(bi + j, _mm_sub_ps(ui, ti));
+                }
+#endif
+                
+                for (; j < half; j++)
+                {
+                    const float tr = br[j] * wr[j] - bi[j] * wi[j];
+                    const float ti = br[j] * wi[j] + bi[j] * wr[j];
+                    
+                    br[j] = ar[j] - tr;
+                    bi[j] = ai[j] - ti;
+                    ar[j] += tr;
+                    ai[j] += ti;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,115 @@
+
+/*
+ *  AudioKernels.hpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef SFEMOVIE_AUDIO_KERNELS_HPP
+#define SFEMOVIE_AUDIO_KERNELS_HPP
+
+#include <SFML/Config.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace sfe
+{
+    namespace AudioKernels
+    {
+        /** Compute the peak and RMS levels of each channel of interleaved stereo samples
+         *
+         * @param samples the interleaved left/right signed 16 bits samples
+         * @param frameCount the count of stereo frames (ie. half the count of samples)
+         * @param[out] peak the left and right peak levels, in range [0, 1]
+         * @param[out] rms the left and right RMS levels, in range [0, 1]
+         */
+        void computeStereoLevels(const sf::Int16* samples, std::size_t frameCount, float peak[2], float rms[2]);
+        
+        /** Convert interleaved stereo samples to mono floating point samples, weighted by the given window
+         *
+         * @param samples the interleaved left/right signed 16 bits samples
+         * @param window the weight of each frame, must contain @a frameCount values
+         * @param frameCount the count of stereo frames to convert
+         * @param[out] output the mono samples in range [-1, 1], must be able to hold @a frameCount values
+         */
+        void downmixStereoWindowed(const sf::Int16* samples, const float* window, std::size_t frameCount, float* output);
+        
+        /** Find the lowest and highest values of the given samples, whatever channel they belong to
+         *
+         * @param samples the signed 16 bits samples
+         * @param sampleCount the count of samples in @a samples
+         * @param[in,out] minimum the lowest sample value, only lowered by this call
+         * @param[in,out] maximum the highest sample value, only raised by this call
+         */
+        void accumulateMinMax(const sf::Int16* samples, std::size_t sampleCount, sf::Int16& minimum, sf::Int16& maximum);
+        
+        /** Scale samples in place, saturating the results
+         *
+         * @param samples the signed 16 bits samples to scale
+         * @param sampleCount the count of samples in @a samples
+         * @param gain the factor to apply
+         */
+        void applyGain(sf::Int16* samples, std::size_t sampleCount, float gain);
+        
+        /** Add scaled samples to other samples, saturating the results
+         *
+         * @param[in,out] destination the samples to which @a source is added
+         * @param source the samples to scale and add
+         * @param sampleCount the count of samples in @a destination and @a source
+         * @param gain the factor to apply to @a source
+         */
+        void mixWithGain(sf::Int16* destination, const sf::Int16* source, std::size_t sampleCount, float gain);
+    }
+    
+    /** Radix-2 complex Fast Fourier Transform working on split real/imaginary arrays
+     *
+     * The split layout lets each butterfly stage process several butterflies per instruction
+     */
+    class FFT
+    {
+    public:
+        /** Prepare the twiddle factors and bit reversal table for transforms of the given size
+         *
+         * @param size the count of complex values per transform, must be a power of two >= 4
+         */
+        FFT(unsigned int size);
+        
+        /** @return the count of complex values per transform
+         */
+        unsigned int getSize() const;
+        
+        /** Compute the forward transform in place
+         *
+         * @param real the real parts, of getSize() values
+         * @param imag the imaginary parts, of getSize() values
+         */
+        void transform(float* real, float* imag) const;
+    
+    private:
+        unsigned int m_size;
+        std::vector<unsigned int> m_bitReversal;
+        
+        // Per-stage twiddles stored contiguously: the stage with half size h starts at index h - 1
+        std::vector<float> m_twiddlesReal;
+        std::vector<float> m_twiddlesImag;
+    };
+}
+
+#endif
@@ -0,0 +1,103 @@
+
+/*
+ *  AudioMixer.cpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+
+#include "AudioMixer.hpp"
+#include "AudioStream.hpp"
+#include "AudioKernels.hpp"
+#include <algorithm>
+
+namespace sfe
+{
+    AudioMixer::AudioMixer() :
+    m_mutex(),
+    m_inputs(),
+    m_mixedInputs(),
+    m_inputSamples()
+    {
+    }
+    
+    void AudioMixer::addInput(std::shared_ptr<AudioStream> stream)
+    {
+        sf::Lock l(m_mutex);
+        
+        if (std::find(m_inputs.begin(), m_inputs.end(), stream) == m_inputs.end())
+            m_inputs.push_back(stream);
+    }
+    
+    void AudioMixer::removeInput(std::shared_ptr<AudioStream> stream)
+    {
+        sf::Lock l(m_mutex);
+        m_inputs.erase(std::remove(m_inputs.begin(), m_inputs.end(), stream), m_inputs.end());
+    }
+    
+    void AudioMixer::removeAllInputs()
+    {
+        sf::Lock l(m_mutex);
+        m_inputs.clear();
+    }
+    
+    bool AudioMixer::hasInput(const Stream* stream) const
+    {
+        sf::Lock l(m_mutex);
+        
+        for (const std::shared_ptr<AudioStream>& input : m_inputs)
+        {
+            if (static_cast<const Stream*>(input.get()) == stream)
+                return true;
+        }
+        
+        return false;
+    }
+    
+    std::vector<std::shared_ptr<AudioStream> > AudioMixer::getInputs() const
+    {
+        sf::Lock l(m_mutex);
+        return m_inputs;
+    }
+    
+    void AudioMixer::mix(sf::Int16* samples, std::size_t sampleCount)
+    {
+        // Don't hold the lock while decoding: the inputs request data from the demuxer,
+        // which checks the inputs when routing packets from other threads. The inputs are copied
+        // to storage kept between the chunks, so that mixing doesn't allocate once the inputs are set
+        {
+            sf::Lock l(m_mutex);
+            m_mixedInputs.assign(m_inputs.begin(), m_inputs.end());
+        }
+        
+        if (m_inputSamples.size() < sampleCount)
+            m_inputSamples.resize(sampleCount);
+        
+        for (std::shared_ptr<AudioStream>& input : m_mixedInputs)
+        {
+            // Inputs that ended early are mixed as silence
+            const std::size_t readCount = input->readSamples(m_inputSamples.data(), sampleCount);
+            AudioKernels::mixWithGain(samples, m_inputSamples.data(), readCount, input->getGain());
+        }
+        
+        // Don't keep the removed inputs alive until the next chunk
+        m_mixedInputs.clear();
+    }
+}
@@ -0,0 +1,92 @@
+
+/*
+ *  AudioMixer.hpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+
+#ifndef SFEMOVIE_AUDIO_MIXER_HPP
+#define SFEMOVIE_AUDIO_MIXER_HPP
+
+#include <SFML/System.hpp>
+#include <memory>
+#include <vector>
+
+namespace sfe
+{
+    class AudioStream;
+    class Stream;
+    
+    /** Adds the samples of several audio streams to the samples played by another audio stream
+     *
+     * This lets several audio tracks be played through a single sound output. The inputs are pulled
+     * from the audio streaming thread of the playing stream, they must produce samples at the same
+     * rate as the playing stream.
+     */
+    class AudioMixer
+    {
+    public:
+        /** Default constructor
+         */
+        AudioMixer();
+        
+        /** Add an audio stream to the mix
+         *
+         * @param stream the audio stream whose samples are to be mixed
+         */
+        void addInput(std::shared_ptr<AudioStream> stream);
+        
+        /** Remove an audio stream from the mix
+         *
+         * @param stream the audio stream to remove
+         */
+        void removeInput(std::shared_ptr<AudioStream> stream);
+        
+        /** Remove all the audio streams from the mix
+         */
+        void removeAllInputs();
+        
+        /** @return true if the given stream is mixed, false otherwise
+         */
+        bool hasInput(const Stream* stream) const;
+        
+        /** @return the audio streams that are mixed
+         */
+        std::vector<std::shared_ptr<AudioStream> > getInputs() const;
+        
+        /** Add the samples of all the inputs, scaled by their gain, to the given samples
+         *
+         * @param[in,out] samples the stereo signed 16 bits samples to mix into
+         * @param sampleCount the count of samples in @a samples
+         */
+        void mix(sf::Int16* samples, std::size_t sampleCount);
+    
+    private:
+        mutable sf::Mutex m_mutex;
+        std::vector<std::shared_ptr<AudioStream> > m_inputs;
+        
+        // Only used by mix(), on the audio streaming thread
+        std::vector<std::shared_ptr<AudioStream> > m_mixedInputs;
+        std::vector<sf::Int16> m_inputSamples;
+    };
+}
+
+#endif
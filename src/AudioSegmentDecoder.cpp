@@ -0,0 +1,104 @@
+
+/*
+ *  AudioSegmentDecoder.cpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+
+#include "AudioSegmentDecoder.hpp"
+#include "Demuxer.hpp"
+#include "Timer.hpp"
+#include "Log.hpp"
+#include <mutex>
+
+namespace sfe
+{
+    namespace
+    {
+        // FFmpeg global initialization and codecs opening/closing are not safe
+        // to run concurrently from several decoding threads
+        std::mutex g_openingMutex;
+    }
+    
+    AudioSegmentDecoder::AudioSegmentDecoder(const std::string& sourceFile) :
+    m_timer(nullptr),
+    m_demuxer(nullptr),
+    m_audioStream(nullptr)
+    {
+        std::lock_guard<std::mutex> lock(g_openingMutex);
+        VideoStream::Delegate& videoDelegate = *this;
+        SubtitleStream::Delegate& subtitleDelegate = *this;
+        
+        m_timer = std::make_shared<Timer>();
+        m_demuxer = std::make_shared<Demuxer>(sourceFile, m_timer, videoDelegate, subtitleDelegate);
+        m_demuxer->selectFirstAudioStream();
+        m_audioStream = m_demuxer->getSelectedAudioStream();
+        
+        CHECK(m_audioStream, "AudioSegmentDecoder::AudioSegmentDecoder() - no audio stream in " + sourceFile);
+    }
+    
+    AudioSegmentDecoder::~AudioSegmentDecoder()
+    {
+        std::lock_guard<std::mutex> lock(g_openingMutex);
+        
+        m_audioStream.reset();
+        m_demuxer.reset();
+    }
+    
+    unsigned int AudioSegmentDecoder::getSampleRate() const
+    {
+        return m_audioStream->getSampleRate();
+    }
+    
+    unsigned int AudioSegmentDecoder::getChannelCount() const
+    {
+        return m_audioStream->getChannelCount();
+    }
+    
+    sf::Time AudioSegmentDecoder::getDuration() const
+    {
+        return m_demuxer->getDuration();
+    }
+    
+    bool AudioSegmentDecoder::seek(sf::Time position)
+    {
+        return m_timer->seek(position);
+    }
+    
+    bool AudioSegmentDecoder::decodeSamples(const sf::Int16*& samples, std::size_t& sampleCount, sf::Time& position)
+    {
+        return m_audioStream->decodeSamples(samples, sampleCount, position);
+    }
+    
+    void AudioSegmentDecoder::didUpdateVideo(const VideoStream& sender, const sf::Texture& image)
+    {
+    }
+    
+    void AudioSegmentDecoder::didUpdateSubtitle(const SubtitleStream& sender,
+                                                const sf::VertexArray& vertices,
+                                                std::shared_ptr<const sf::Texture> texture)
+    {
+    }
+    
+    void AudioSegmentDecoder::didWipeOutSubtitles(const SubtitleStream& sender)
+    {
+    }
+}
@@ -0,0 +1,97 @@
+
+/*
+ *  AudioSegmentDecoder.hpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+
+#ifndef SFEMOVIE_AUDIO_SEGMENT_DECODER_HPP
+#define SFEMOVIE_AUDIO_SEGMENT_DECODER_HPP
+
+#include "AudioStream.hpp"
+#include "VideoStream.hpp"
+#include "SubtitleStream.hpp"
+#include <SFML/System.hpp>
+#include <memory>
+#include <string>
+
+namespace sfe
+{
+    class Demuxer;
+    class Timer;
+    
+    /** Decodes the first audio stream of a media as fast as possible, without playing it
+     *
+     * It owns its demuxer and timer so that several decoders can work on the same media from
+     * different threads, each of them on its own part of the media.
+     */
+    class AudioSegmentDecoder : private VideoStream::Delegate, private SubtitleStream::Delegate
+    {
+    public:
+        /** Open the media and select its first audio stream
+         *
+         * @param sourceFile the path of the media to decode
+         * @throw std::runtime_error if the media cannot be opened or has no audio stream
+         */
+        AudioSegmentDecoder(const std::string& sourceFile);
+        
+        /** Default destructor
+         */
+        ~AudioSegmentDecoder();
+        
+        /** @return the amount of samples per second and per channel of the decoded samples
+         */
+        unsigned int getSampleRate() const;
+        
+        /** @return the count of interleaved channels of the decoded samples
+         */
+        unsigned int getChannelCount() const;
+        
+        /** @return the duration of the media, or zero if it is unknown
+         */
+        sf::Time getDuration() const;
+        
+        /** Move the decoding position
+         *
+         * @param position the media position of the next samples to decode
+         * @return true on success, false otherwise
+         */
+        bool seek(sf::Time position);
+        
+        /** @see AudioStream::decodeSamples()
+         */
+        bool decodeSamples(const sf::Int16*& samples, std::size_t& sampleCount, sf::Time& position);
+    
+    private:
+        // VideoStream::Delegate and SubtitleStream::Delegate interfaces, nothing is displayed
+        void didUpdateVideo(const VideoStream& sender, const sf::Texture& image) override;
+        void didUpdateSubtitle(const SubtitleStream& sender,
+                               const sf::VertexArray& vertices,
+                               std::shared_ptr<const sf::Texture> texture) override;
+        void didWipeOutSubtitles(const SubtitleStream& sender) override;
+        
+        std::shared_ptr<Timer> m_timer;
+        std::shared_ptr<Demuxer> m_demuxer;
+        std::shared_ptr<AudioStream> m_audioStream;
+    };
+}
+
+#endif
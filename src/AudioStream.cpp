@@ -32,28 +32,31 @@ extern "C"
 #include <libswresample/swresample.h>
 }
 
+#include <chrono>
 #include <cstring>
 #include <iostream>
 #include "AudioStream.hpp"
+#include "AudioMixer.hpp"
+#include "AudioKernels.hpp"
 #include "Log.hpp"
+#include "TraceSpan.hpp"
 #include <sfeMovie/Movie.hpp>
 
 namespace sfe
 {
     namespace
     {
-        void waitForStatusUpdate(const sf::SoundStream& stream, sf::SoundStream::Status expectedStatus)
+        const int BytesPerSample = sizeof(sf::Int16); // Signed 16 bits audio sample
+        const std::chrono::seconds StatusUpdateTimeout(5);
+        
+        /** @return the size in bytes of the two seconds stereo samples buffer at the given rate
+         */
+        std::size_t samplesBufferSize(unsigned int sampleRate)
         {
-            // Wait for status to update
-            sf::Clock timeout;
-            while (stream.getStatus() != expectedStatus && timeout.getElapsedTime() < sf::seconds(5))
-                sf::sleep(sf::microseconds(10));
-            CHECK(timeout.getElapsedTime() < sf::seconds(5), "Audio did not reach state " + s(expectedStatus) + " within 5 seconds");
+            return sizeof(sf::Int16) * av_get_channel_layout_nb_channels(AV_CH_LAYOUT_STEREO) * sampleRate * 2;
         }
-        
-        const int BytesPerSample = sizeof(sf::Int16); // Signed 16 bits audio sample
     }
-
+    
     AudioStream::AudioStream(AVFormatContext*& formatCtx, AVStream*& stream, DataSource& dataSource,
                              std::shared_ptr<Timer> timer) :
     Stream(formatCtx, stream, dataSource, timer),
@@ -64,6 +67,12 @@ namespace sfe
     // Private data
     m_samplesBuffer(nullptr),
     m_audioFrame(nullptr),
+    m_gain(1.f),
+    m_mixer(nullptr),
+    m_pendingSamples(nullptr),
+    m_pendingSamplesCount(0),
+    m_reachedEndOfStream(false),
+    m_queuedLastChunk(false),
     
     // Resampling
     m_swrCtx(nullptr),
@@ -73,28 +82,54 @@ namespace sfe
     m_dstLinesize(0),
     m_dstData(nullptr)
     {
-        m_audioFrame = av_frame_alloc();
-        CHECK(m_audioFrame, "AudioStream::AudioStream() - out of memory");
-        
         // Get some audio informations
         m_sampleRatePerChannel = m_stream->codec->sample_rate;
         
-        // Alloc a two seconds buffer
-        m_samplesBuffer = (sf::Int16*)av_malloc(sizeof(sf::Int16) * av_get_channel_layout_nb_channels(AV_CH_LAYOUT_STEREO)
-                                                * m_sampleRatePerChannel * 2); // * 2 is for 2 seconds
-        CHECK(m_samplesBuffer, "AudioStream::AudioStream() - out of memory");
-        
         // Initialize the sf::SoundStream
         // Whatever the channel count is, it'll we resampled to stereo
         sf::SoundStream::initialize(av_get_channel_layout_nb_channels(AV_CH_LAYOUT_STEREO), m_sampleRatePerChannel);
-        
-        // Initialize resampler to be able to give signed 16 bits samples to SFML
-        initResampler();
     }
     
     /** Default destructor
      */
     AudioStream::~AudioStream()
+    {
+        releaseBuffers();
+    }
+    
+    void AudioStream::didOpenDecoder()
+    {
+        try
+        {
+            allocateBuffers();
+        }
+        catch (...)
+        {
+            releaseBuffers();
+            throw;
+        }
+    }
+    
+    void AudioStream::willCloseDecoder()
+    {
+        releaseBuffers();
+    }
+    
+    void AudioStream::allocateBuffers()
+    {
+        m_audioFrame = av_frame_alloc();
+        CHECK(m_audioFrame, "AudioStream::allocateBuffers() - out of memory");
+        
+        // Alloc a two seconds buffer
+        m_samplesBuffer = (sf::Int16*)av_malloc(samplesBufferSize(m_sampleRatePerChannel));
+        CHECK(m_samplesBuffer, "AudioStream::allocateBuffers() - out of memory");
+        m_memoryAccount.add(MemoryAccount::AudioSamples, samplesBufferSize(m_sampleRatePerChannel));
+        
+        // Initialize resampler to be able to give signed 16 bits samples to SFML
+        initResampler();
+    }
+    
+    void AudioStream::releaseBuffers()
     {
         if (m_audioFrame)
         {
@@ -103,7 +138,8 @@ namespace sfe
         
         if (m_samplesBuffer)
         {
-            av_free(m_samplesBuffer);
+            av_freep(&m_samplesBuffer);
+            m_memoryAccount.remove(MemoryAccount::AudioSamples, samplesBufferSize(m_sampleRatePerChannel));
         }
         
         if (m_dstData)
@@ -113,6 +149,7 @@ namespace sfe
         av_freep(&m_dstData);
         
         swr_free(&m_swrCtx);
+        m_pendingSamplesCount = 0;
     }
     
     void AudioStream::flushBuffers()
@@ -125,6 +162,9 @@ namespace sfe
             sf::SoundStream::stop();
         
         m_extraAudioTime = sf::Time::Zero;
+        m_samplesPosition = sf::Time::Zero;
+        m_pendingSamplesCount = 0;
+        m_reachedEndOfStream = false;
         Stream::flushBuffers();
     }
     
@@ -192,6 +232,7 @@ namespace sfe
                                   + s((currentPosition - targetPosition).asMicroseconds()) + "us");
                 
                 m_extraAudioTime = sf::Time::Zero;
+                m_samplesPosition = currentPosition;
                 
                 // Reinsert, we don't want to decode now
                 prependEncodedData(packet);
@@ -201,6 +242,7 @@ namespace sfe
                 // Reinsert, we don't want to decode now
                 prependEncodedData(packet);
                 m_extraAudioTime = targetPosition - currentPosition;
+                m_samplesPosition = targetPosition;
                 
                 sfeLogDebug("Extra audio time to be discarded at decoding time: "
                             + s(m_extraAudioTime.asMicroseconds()) + "us");
@@ -219,7 +261,124 @@ namespace sfe
         return true;
     }
     
+    void AudioStream::addSampleObserver(AudioSampleObserver& observer)
+    {
+        sf::Lock l(m_sampleObserversMutex);
+        m_sampleObservers.insert(&observer);
+    }
+    
+    void AudioStream::removeSampleObserver(AudioSampleObserver& observer)
+    {
+        sf::Lock l(m_sampleObserversMutex);
+        m_sampleObservers.erase(&observer);
+    }
+    
+    bool AudioStream::decodeSamples(const sf::Int16*& samples, std::size_t& sampleCount, sf::Time& position)
+    {
+        sf::SoundStream::Chunk chunk;
+        chunk.samples = nullptr;
+        chunk.sampleCount = 0;
+        position = m_samplesPosition;
+        
+        bool hasMoreData = onGetData(chunk);
+        samples = chunk.samples;
+        sampleCount = chunk.sampleCount;
+        
+        return hasMoreData;
+    }
+    
+    void AudioStream::setGain(float gain)
+    {
+        m_gain = gain;
+    }
+    
+    float AudioStream::getGain() const
+    {
+        return m_gain;
+    }
+    
+    void AudioStream::setMixer(std::shared_ptr<AudioMixer> mixer)
+    {
+        m_mixer = mixer;
+    }
+    
+    void AudioStream::setOutputSampleRate(unsigned int sampleRate)
+    {
+        if (sampleRate == m_sampleRatePerChannel)
+            return;
+        
+        CHECK(sf::SoundStream::getStatus() == sf::SoundStream::Stopped,
+              "AudioStream::setOutputSampleRate() - cannot change the sample rate while playing");
+        
+        // Already decoded samples are at the previous rate
+        const bool hadBuffers = isDecoderOpen();
+        releaseBuffers();
+        
+        m_sampleRatePerChannel = sampleRate;
+        sf::SoundStream::initialize(av_get_channel_layout_nb_channels(AV_CH_LAYOUT_STEREO), m_sampleRatePerChannel);
+        
+        if (hadBuffers)
+            allocateBuffers();
+    }
+    
+    std::size_t AudioStream::readSamples(sf::Int16* output, std::size_t sampleCount)
+    {
+        std::size_t readCount = 0;
+        
+        while (readCount < sampleCount)
+        {
+            if (m_pendingSamplesCount == 0)
+            {
+                if (m_reachedEndOfStream)
+                    break;
+                
+                sf::SoundStream::Chunk chunk;
+                chunk.samples = nullptr;
+                chunk.sampleCount = 0;
+                
+                m_reachedEndOfStream = !decodeChunk(chunk);
+                m_pendingSamples = chunk.samples;
+                m_pendingSamplesCount = chunk.sampleCount;
+                continue;
+            }
+            
+            const std::size_t count = std::min(sampleCount - readCount, m_pendingSamplesCount);
+            std::memcpy(output + readCount, m_pendingSamples, count * BytesPerSample);
+            m_pendingSamples += count;
+            m_pendingSamplesCount -= count;
+            readCount += count;
+        }
+        
+        return readCount;
+    }
+    
     bool AudioStream::onGetData(sf::SoundStream::Chunk& data)
+    {
+        SFE_TRACE_THREAD_NAME("sfeMovie audio streaming");
+        bool hasMoreData = decodeChunk(data);
+        
+        if (data.sampleCount > 0)
+        {
+            if (m_gain != 1.f)
+                AudioKernels::applyGain(m_samplesBuffer, data.sampleCount, m_gain);
+            
+            if (m_mixer)
+                m_mixer->mix(m_samplesBuffer, data.sampleCount);
+            
+            notifySampleObservers(data.samples, data.sampleCount);
+            m_samplesPosition += samplesToTime(static_cast<int>(data.sampleCount));
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(m_streamingMutex);
+            m_queuedLastChunk = !hasMoreData;
+        }
+        m_streamingCondition.notify_all();
+        
+        return hasMoreData;
+    }
+    
+    bool AudioStream::decodeChunk(sf::SoundStream::Chunk& data)
     {
         AVPacket* packet = nullptr;
         data.samples = m_samplesBuffer;
@@ -234,7 +393,9 @@ namespace sfe
             
             do
             {
+                sf::Clock clock;
                 needsMoreDecoding = decodePacket(packet, m_audioFrame, gotFrame);
+                const sf::Time decodeTime = clock.restart();
                 
                 if (gotFrame)
                 {
@@ -242,6 +403,14 @@ namespace sfe
                     int samplesCount = 0;
                     
                     resampleFrame(m_audioFrame, samplesBuffer, samplesCount);
+                    
+                    {
+                        std::lock_guard<std::mutex> lock(m_statsMutex);
+                        m_stats.framesDecoded++;
+                        m_stats.decodeTime.add(decodeTime);
+                        m_stats.convertTime.add(clock.getElapsedTime());
+                    }
+                    
                     CHECK(samplesBuffer, "AudioStream::onGetData() - resampleFrame() error");
                     CHECK(samplesCount > 0, "AudioStream::onGetData() - resampleFrame() error");
                     CHECK(samplesToTime(data.sampleCount + samplesCount) < sf::seconds(2),
@@ -302,6 +471,7 @@ namespace sfe
     
     bool AudioStream::decodePacket(AVPacket* packet, AVFrame* outputFrame, bool& gotFrame)
     {
+        SFE_TRACE_SCOPE("AudioStream::decodePacket");
         bool needsMoreDecoding = false;
         int igotFrame = 0;
         
@@ -340,7 +510,7 @@ namespace sfe
         av_opt_set_int        (m_swrCtx, "in_sample_rate",     m_stream->codec->sample_rate,    0);
         av_opt_set_sample_fmt (m_swrCtx, "in_sample_fmt",      m_stream->codec->sample_fmt,     0);
         av_opt_set_int        (m_swrCtx, "out_channel_layout", AV_CH_LAYOUT_STEREO,             0);
-        av_opt_set_int        (m_swrCtx, "out_sample_rate",    m_stream->codec->sample_rate,    0);
+        av_opt_set_int        (m_swrCtx, "out_sample_rate",    m_sampleRatePerChannel,          0);
         av_opt_set_sample_fmt (m_swrCtx, "out_sample_fmt",     AV_SAMPLE_FMT_S16,               0);
         
         /* initialize the resampling context */
@@ -363,9 +533,11 @@ namespace sfe
     {
         CHECK(m_swrCtx, "AudioStream::resampleFrame() - resampler is not initialized, call AudioStream::initResamplerFirst() !");
         CHECK(frame, "AudioStream::resampleFrame() - invalid argument");
+        SFE_TRACE_SCOPE("AudioStream::resampleFrame");
         
         int src_rate, dst_rate, err, dst_bufsize;
-        src_rate = dst_rate = frame->sample_rate;
+        src_rate = frame->sample_rate;
+        dst_rate = m_sampleRatePerChannel;
         
         /* compute destination number of samples */
         m_dstNbSamples = av_rescale_rnd(swr_get_delay(m_swrCtx, src_rate) +
@@ -415,29 +587,92 @@ namespace sfe
         return sf::microseconds(microseconds);
     }
     
+    void AudioStream::notifySampleObservers(const sf::Int16* samples, std::size_t sampleCount)
+    {
+        sf::Lock l(m_sampleObserversMutex);
+        
+        for (AudioSampleObserver* observer : m_sampleObservers)
+        {
+            observer->didReceiveAudioSamples(samples, sampleCount, sf::SoundStream::getChannelCount(),
+                                             m_sampleRatePerChannel, m_samplesPosition);
+        }
+    }
+    
+    bool AudioStream::waitForPlaybackStart(sf::Time initialOffset)
+    {
+        std::unique_lock<std::mutex> lock(m_streamingMutex);
+        
+        // The streaming thread queues more samples each time the device played a buffer, which
+        // moves the playing offset. Once it queued the last samples it won't wake this up anymore,
+        // and short sounds may already be over, so don't wait for the device then
+        return m_streamingCondition.wait_for(lock, StatusUpdateTimeout, [this, initialOffset]
+        {
+            return m_queuedLastChunk || sf::SoundStream::getPlayingOffset() != initialOffset;
+        });
+    }
+    
+    bool AudioStream::waitForStatus(sf::SoundStream::Status expectedStatus)
+    {
+        std::unique_lock<std::mutex> lock(m_streamingMutex);
+        
+        // SFML changes the status before returning from play(), pause() and stop(), so this usually
+        // returns right away, and the streaming thread wakes this up otherwise
+        return m_streamingCondition.wait_for(lock, StatusUpdateTimeout, [this, expectedStatus]
+        {
+            return sf::SoundStream::getStatus() == expectedStatus;
+        });
+    }
+    
+    void AudioStream::recordTransition(sfe::Status status, sf::Time startTime)
+    {
+        const sf::Time latency = m_latencyClock.getElapsedTime() - startTime;
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        
+        switch (status)
+        {
+            case sfe::Playing:
+                m_stats.playLatency.add(latency);
+                break;
+            case sfe::Paused:
+                m_stats.pauseLatency.add(latency);
+                break;
+            default:
+                m_stats.stopLatency.add(latency);
+                break;
+        }
+        
+        sfeLogDebug("Audio stream reached status " + s(status) + " in " + s(latency.asMicroseconds()) + "us");
+    }
+    
     void AudioStream::willPlay(const Timer &timer)
     {
+        const sf::Time startTime = m_latencyClock.getElapsedTime();
         Stream::willPlay(timer);
         
         if (Stream::getStatus() == sfe::Stopped)
         {
+            {
+                // The streaming thread isn't running, it starts again from the current position
+                std::lock_guard<std::mutex> lock(m_streamingMutex);
+                m_queuedLastChunk = false;
+            }
+            
             sf::Time initialTime = sf::SoundStream::getPlayingOffset();
-            sf::Clock timeout;
             sf::SoundStream::play();
             
             // Some audio drivers take time before the sound is actually played
             // To avoid desynchronization with the timer, we don't return
             // until the audio stream is actually started
-            while (sf::SoundStream::getPlayingOffset() == initialTime && timeout.getElapsedTime() < sf::seconds(5))
-                sf::sleep(sf::microseconds(10));
-            
-            CHECK(sf::SoundStream::getPlayingOffset() != initialTime, "is your audio device broken? Audio did not start within 5 seconds");
+            CHECK(waitForPlaybackStart(initialTime), "is your audio device broken? Audio did not start within 5 seconds");
         }
         else
         {
             sf::SoundStream::play();
-            waitForStatusUpdate(*this, sf::SoundStream::Playing);
+            CHECK(waitForStatus(sf::SoundStream::Playing), "Audio did not reach state "
+                  + s(sf::SoundStream::Playing) + " within 5 seconds");
         }
+        
+        recordTransition(sfe::Playing, startTime);
     }
     
     void AudioStream::didPlay(const Timer& timer, sfe::Status previousStatus)
@@ -448,20 +683,28 @@ namespace sfe
     
     void AudioStream::didPause(const Timer& timer, sfe::Status previousStatus)
     {
+        const sf::Time startTime = m_latencyClock.getElapsedTime();
+        
         if (sf::SoundStream::getStatus() == sf::SoundStream::Playing)
         {
             sf::SoundStream::pause();
-            waitForStatusUpdate(*this, sf::SoundStream::Paused);
+            CHECK(waitForStatus(sf::SoundStream::Paused), "Audio did not reach state "
+                  + s(sf::SoundStream::Paused) + " within 5 seconds");
         }
         
+        recordTransition(sfe::Paused, startTime);
         Stream::didPause(timer, previousStatus);
     }
     
     void AudioStream::didStop(const Timer& timer, sfe::Status previousStatus)
     {
+        const sf::Time startTime = m_latencyClock.getElapsedTime();
+        
         sf::SoundStream::stop();
-        waitForStatusUpdate(*this, sf::SoundStream::Stopped);
+        CHECK(waitForStatus(sf::SoundStream::Stopped), "Audio did not reach state "
+              + s(sf::SoundStream::Stopped) + " within 5 seconds");
         
+        recordTransition(sfe::Stopped, startTime);
         Stream::didStop(timer, previousStatus);
     }
 }
@@ -28,17 +28,25 @@
 
 #include <SFML/Audio.hpp>
 #include "Stream.hpp"
+#include <sfeMovie/AudioAnalysis.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <set>
 #include <stdint.h>
 
 namespace sfe
 {
+    class AudioMixer;
+    
     class AudioStream : public Stream, private sf::SoundStream
     {
     public:
         /** Create an audio stream from the given FFmpeg stream
          *
          * At the end of the constructor, the stream is guaranteed
-         * to have all of its fields set and the decoder loaded
+         * to have all of its fields set, the decoder is loaded
+         * once the stream is connected
          */
         AudioStream(AVFormatContext*& formatCtx, AVStream*& stream, DataSource& dataSource,
                     std::shared_ptr<Timer> timer);
@@ -65,6 +73,69 @@ namespace sfe
          */
         bool fastForward(sf::Time targetPosition) override;
         
+        /** Register an observer that will receive the audio samples as they are queued for playback
+         *
+         * @param observer the observer to notify from the audio streaming thread
+         */
+        void addSampleObserver(AudioSampleObserver& observer);
+        
+        /** Unregister an observer previously registered with addSampleObserver()
+         *
+         * Once this returns, the observer is guaranteed not to be notified anymore
+         *
+         * @param observer the observer to unregister
+         */
+        void removeSampleObserver(AudioSampleObserver& observer);
+        
+        /** Decode the next samples without playing them, for processing the audio as fast as possible
+         *
+         * The stream must not be played through the timer at the same time
+         *
+         * @param[out] samples the decoded stereo signed 16 bits samples, valid until the next call
+         * @param[out] sampleCount the count of samples in @a samples
+         * @param[out] position the media position of the first sample
+         * @return true if more samples can be decoded after these ones, false if the end of the stream
+         * has been reached
+         */
+        bool decodeSamples(const sf::Int16*& samples, std::size_t& sampleCount, sf::Time& position);
+        
+        /** Set the factor applied to the samples of this stream, unlike the volume it is also
+         * applied when this stream is mixed into another one
+         *
+         * @param gain the factor to apply to the samples, 1 leaves them unchanged
+         */
+        void setGain(float gain);
+        
+        /** @return the factor applied to the samples of this stream
+         */
+        float getGain() const;
+        
+        /** Set the mixer whose inputs are added to the samples played by this stream
+         *
+         * @param mixer the mixer to use, or nullptr to play this stream alone
+         */
+        void setMixer(std::shared_ptr<AudioMixer> mixer);
+        
+        /** Change the sample rate of the decoded samples, so that they can be mixed with samples of
+         * another stream
+         *
+         * @warning This can only be done while the stream is stopped
+         *
+         * @param sampleRate the amount of samples per second and per channel to produce
+         */
+        void setOutputSampleRate(unsigned int sampleRate);
+        
+        /** Decode exactly the given amount of samples, for mixing this stream into another one
+         *
+         * The gain is not applied and the sample observers are not notified
+         *
+         * @param output the buffer receiving the stereo signed 16 bits samples
+         * @param sampleCount the count of samples to read
+         * @return the count of samples read, lower than @a sampleCount once the end of the
+         * stream is reached
+         */
+        std::size_t readSamples(sf::Int16* output, std::size_t sampleCount);
+        
         using sf::SoundStream::setVolume;
         using sf::SoundStream::getVolume;
         using sf::SoundStream::getSampleRate;
@@ -73,6 +144,13 @@ namespace sfe
         bool onGetData(sf::SoundStream::Chunk& data) override;
         void onSeek(sf::Time timeOffset) override;
         
+        /** Decode up to one second of samples into the samples buffer
+         *
+         * @param data the chunk pointing to the decoded samples
+         * @return true if there is still data to decode, false if the end of the stream has been reached
+         */
+        bool decodeChunk(sf::SoundStream::Chunk& data);
+        
         /** Decode the encoded data @a packet into @a outputFrame
          *
          * gotFrame being set to false means that decoding should still continue:
@@ -92,6 +170,15 @@ namespace sfe
          */
         void initResampler();
         
+        /** Allocate the decoded frame, the samples buffer and the resampler for the current output
+         * sample rate
+         */
+        void allocateBuffers();
+        
+        /** Release the decoded frame, the samples buffer and the resampler
+         */
+        void releaseBuffers();
+        
         /** Resample the decoded audio frame @a frame into signed 16 bits audio samples
          *
          * @param frame the audio samples to convert
@@ -110,12 +197,40 @@ namespace sfe
          */
         sf::Time samplesToTime(int nbSamples) const;
         
+        /** Give the samples about to be queued for playback to the registered observers
+         *
+         * @param samples the interleaved signed 16 bits samples
+         * @param sampleCount the count of samples in @a samples
+         */
+        void notifySampleObservers(const sf::Int16* samples, std::size_t sampleCount);
+        
+        /** Wait until the audio device actually started playing, ie. the playing offset moved
+         * from @a initialOffset, or until all the samples were queued for playback
+         *
+         * @return true if playback started, false if it did not within the timeout
+         */
+        bool waitForPlaybackStart(sf::Time initialOffset);
+        
+        /** Wait until the SFML stream reaches the given status
+         *
+         * @return true if the status was reached, false if it was not within the timeout
+         */
+        bool waitForStatus(sf::SoundStream::Status expectedStatus);
+        
+        /** Account for a transition to @a status that started at @a startTime in the stream statistics
+         */
+        void recordTransition(sfe::Status status, sf::Time startTime);
+        
         // Timer::Observer interface
         void willPlay(const Timer &timer) override;
         void didPlay(const Timer& timer, sfe::Status previousStatus) override;
         void didPause(const Timer& timer, sfe::Status previousStatus) override;
         void didStop(const Timer& timer, sfe::Status previousStatus) override;
         
+        // Stream interface
+        void didOpenDecoder() override;
+        void willCloseDecoder() override;
+        
         // Public properties
         unsigned m_sampleRatePerChannel;
         
@@ -123,6 +238,26 @@ namespace sfe
         sf::Int16* m_samplesBuffer;
         AVFrame* m_audioFrame;
         sf::Time m_extraAudioTime;
+        sf::Time m_samplesPosition;
+        std::atomic<float> m_gain;
+        
+        // Mixing
+        std::shared_ptr<AudioMixer> m_mixer;
+        const sf::Int16* m_pendingSamples;
+        std::size_t m_pendingSamplesCount;
+        bool m_reachedEndOfStream;
+        
+        // Samples observers, notified from the audio streaming thread
+        std::set<AudioSampleObserver*> m_sampleObservers;
+        sf::Mutex m_sampleObserversMutex;
+        
+        // Signaled by the audio streaming thread each time it queued samples for playback
+        std::mutex m_streamingMutex;
+        std::condition_variable m_streamingCondition;
+        bool m_queuedLastChunk;
+        
+        // Measures the status transitions, see StreamStats::playLatency
+        sf::Clock m_latencyClock;
         
         // Resampling
         struct SwrContext* m_swrCtx;
@@ -0,0 +1,263 @@
+
+/*
+ *  DecodeScheduler.cpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#include "DecodeScheduler.hpp"
+#include "TraceSpan.hpp"
+#include <sfeMovie/DecodeThreads.hpp>
+#include <algorithm>
+#include <iterator>
+
+namespace sfe
+{
+    namespace
+    {
+        // Index of the worker running on the current thread, so that it queues its own tasks locally
+        thread_local std::size_t t_workerIndex = static_cast<std::size_t>(-1);
+    }
+    
+    bool DecodeScheduler::isMoreUrgent(const Task& task, const Task& otherTask)
+    {
+        if (task.priority != otherTask.priority)
+            return task.priority > otherTask.priority;
+        
+        return task.deadline < otherTask.deadline;
+    }
+    
+    namespace DecodeThreads
+    {
+        void setWorkerCount(unsigned int count)
+        {
+            DecodeScheduler::getInstance().setWorkerCount(count);
+        }
+        
+        unsigned int getWorkerCount()
+        {
+            return DecodeScheduler::getInstance().getWorkerCount();
+        }
+    }
+    
+    DecodeScheduler& DecodeScheduler::getInstance()
+    {
+        static DecodeScheduler instance;
+        return instance;
+    }
+    
+    DecodeScheduler::DecodeScheduler() :
+    m_configurationMutex(),
+    m_workers(),
+    m_nextWorker(0),
+    m_stateMutex(),
+    m_wakeUpCondition(),
+    m_taskDoneCondition(),
+    m_runningOwners(),
+    m_queuedCount(0),
+    m_shouldStop(false)
+    {
+    }
+    
+    DecodeScheduler::~DecodeScheduler()
+    {
+        std::lock_guard<std::mutex> lock(m_configurationMutex);
+        stopWorkers();
+    }
+    
+    void DecodeScheduler::setWorkerCount(unsigned int count)
+    {
+        std::lock_guard<std::mutex> lock(m_configurationMutex);
+        
+        if (count == m_workers.size())
+            return;
+        
+        std::vector<Task> queuedTasks = stopWorkers();
+        std::stable_sort(queuedTasks.begin(), queuedTasks.end(), isMoreUrgent);
+        
+        for (unsigned int i = 0; i < count; i++)
+            m_workers.push_back(std::unique_ptr<Worker>(new Worker));
+        
+        for (std::size_t i = 0; i < queuedTasks.size(); i++)
+        {
+            if (count == 0)
+                queuedTasks[i].run();
+            else
+                m_workers[i % count]->tasks.push_back(std::move(queuedTasks[i]));
+        }
+        
+        {
+            std::lock_guard<std::mutex> stateLock(m_stateMutex);
+            m_shouldStop = false;
+            m_queuedCount = (count == 0) ? 0 : queuedTasks.size();
+        }
+        
+        for (unsigned int i = 0; i < count; i++)
+            m_workers[i]->thread = std::thread(&DecodeScheduler::run, this, i);
+    }
+    
+    unsigned int DecodeScheduler::getWorkerCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_configurationMutex);
+        return static_cast<unsigned int>(m_workers.size());
+    }
+    
+    void DecodeScheduler::submit(const void* owner, int priority, Clock::time_point deadline, std::function<void()> task)
+    {
+        std::unique_lock<std::mutex> lock(m_configurationMutex);
+        
+        if (m_workers.empty())
+        {
+            lock.unlock();
+            task();
+            return;
+        }
+        
+        Task queuedTask = {owner, priority, deadline, std::move(task)};
+        std::size_t index = t_workerIndex;
+        
+        if (index >= m_workers.size())
+            index = m_nextWorker++ % m_workers.size();
+        
+        {
+            std::lock_guard<std::mutex> workerLock(m_workers[index]->mutex);
+            m_workers[index]->tasks.push_back(std::move(queuedTask));
+            
+            std::lock_guard<std::mutex> stateLock(m_stateMutex);
+            m_queuedCount++;
+        }
+        
+        m_wakeUpCondition.notify_one();
+    }
+    
+    void DecodeScheduler::cancel(const void* owner)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_configurationMutex);
+            std::size_t removedCount = 0;
+            
+            for (std::unique_ptr<Worker>& worker : m_workers)
+            {
+                std::lock_guard<std::mutex> workerLock(worker->mutex);
+                const std::size_t sizeBefore = worker->tasks.size();
+                worker->tasks.erase(std::remove_if(worker->tasks.begin(), worker->tasks.end(),
+                                                   [owner](const Task& task) { return task.owner == owner; }),
+                                    worker->tasks.end());
+                removedCount += sizeBefore - worker->tasks.size();
+            }
+            
+            std::lock_guard<std::mutex> stateLock(m_stateMutex);
+            m_queuedCount -= removedCount;
+        }
+        
+        // Tasks are marked as running before they leave their queue, so none can be missed here.
+        // The other movies can keep submitting tasks while this one waits
+        std::unique_lock<std::mutex> stateLock(m_stateMutex);
+        m_taskDoneCondition.wait(stateLock, [this, owner] { return m_runningOwners.count(owner) == 0; });
+    }
+    
+    void DecodeScheduler::run(std::size_t workerIndex)
+    {
+        SFE_TRACE_THREAD_NAME("sfeMovie decoding");
+        t_workerIndex = workerIndex;
+        const std::size_t workerCount = m_workers.size();
+        
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_stateMutex);
+                
+                // Both are only changed under lock, idle workers don't need to wake up until then
+                m_wakeUpCondition.wait(lock, [this] { return m_shouldStop || m_queuedCount > 0; });
+                
+                if (m_shouldStop)
+                    return;
+            }
+            
+            // Own queue first, then steal from the next workers
+            Task task;
+            bool gotTask = false;
+            
+            for (std::size_t i = 0; i < workerCount && !gotTask; i++)
+                gotTask = take(*m_workers[(workerIndex + i) % workerCount], task);
+            
+            if (!gotTask)
+            {
+                // Another worker took the queued task first
+                std::this_thread::yield();
+                continue;
+            }
+            
+            task.run();
+            
+            {
+                std::lock_guard<std::mutex> lock(m_stateMutex);
+                m_runningOwners.erase(m_runningOwners.find(task.owner));
+            }
+            
+            m_taskDoneCondition.notify_all();
+        }
+    }
+    
+    bool DecodeScheduler::take(Worker& worker, Task& task)
+    {
+        std::lock_guard<std::mutex> workerLock(worker.mutex);
+        
+        if (worker.tasks.empty())
+            return false;
+        
+        std::vector<Task>::iterator mostUrgent = worker.tasks.begin();
+        
+        for (std::vector<Task>::iterator it = worker.tasks.begin() + 1; it != worker.tasks.end(); ++it)
+        {
+            if (isMoreUrgent(*it, *mostUrgent))
+                mostUrgent = it;
+        }
+        
+        task = std::move(*mostUrgent);
+        worker.tasks.erase(mostUrgent);
+        
+        std::lock_guard<std::mutex> stateLock(m_stateMutex);
+        m_runningOwners.insert(task.owner);
+        m_queuedCount--;
+        return true;
+    }
+    
+    std::vector<DecodeScheduler::Task> DecodeScheduler::stopWorkers()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_stateMutex);
+            m_shouldStop = true;
+        }
+        
+        m_wakeUpCondition.notify_all();
+        std::vector<Task> queuedTasks;
+        
+        // Workers steal from each other, so no queue is safe to read before they are all stopped
+        for (std::unique_ptr<Worker>& worker : m_workers)
+            worker->thread.join();
+        
+        for (std::unique_ptr<Worker>& worker : m_workers)
+            std::move(worker->tasks.begin(), worker->tasks.end(), std::back_inserter(queuedTasks));
+        
+        m_workers.clear();
+        return queuedTasks;
+    }
+}
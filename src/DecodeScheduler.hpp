@@ -0,0 +1,137 @@
+
+/*
+ *  DecodeScheduler.hpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef SFEMOVIE_DECODE_SCHEDULER_HPP
+#define SFEMOVIE_DECODE_SCHEDULER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace sfe
+{
+    /** Runs decoding tasks on a capped count of worker threads shared by all the movies
+     *
+     * Each worker has its own queue and takes the most urgent task from it: the one of highest
+     * priority, then of earliest deadline. Idle workers steal tasks from the others. Tasks are
+     * identified by an owner so that they can be cancelled before their owner is destroyed.
+     */
+    class DecodeScheduler
+    {
+    public:
+        typedef std::chrono::steady_clock Clock;
+        
+        /** @return the scheduler shared by the whole process
+         */
+        static DecodeScheduler& getInstance();
+        
+        /** Stop the worker threads, the queued tasks are dropped
+         */
+        ~DecodeScheduler();
+        
+        /** @see DecodeThreads::setWorkerCount()
+         */
+        void setWorkerCount(unsigned int count);
+        
+        /** @see DecodeThreads::getWorkerCount()
+         */
+        unsigned int getWorkerCount() const;
+        
+        /** Queue a task for a worker thread
+         *
+         * Without worker threads, the task is run right away on the calling thread
+         *
+         * @param owner the object the task works on, for cancelling it
+         * @param priority tasks of higher priority run first
+         * @param deadline among tasks of the same priority, the ones of earliest deadline run first
+         * @param task the work to run
+         */
+        void submit(const void* owner, int priority, Clock::time_point deadline, std::function<void()> task);
+        
+        /** Remove the queued tasks of the given owner and wait for its running tasks to finish
+         *
+         * @param owner the owner given to submit()
+         */
+        void cancel(const void* owner);
+    
+    private:
+        struct Task
+        {
+            const void* owner;
+            int priority;
+            Clock::time_point deadline;
+            std::function<void()> run;
+        };
+        
+        struct Worker
+        {
+            std::mutex mutex;
+            std::vector<Task> tasks;
+            std::thread thread;
+        };
+        
+        DecodeScheduler();
+        
+        /** @return true if @a task must run before @a otherTask
+         */
+        static bool isMoreUrgent(const Task& task, const Task& otherTask);
+        
+        /** Worker thread loop
+         */
+        void run(std::size_t workerIndex);
+        
+        /** Take the most urgent task of a worker queue and mark its owner as running
+         *
+         * @return true if a task was taken, false if the queue was empty
+         */
+        bool take(Worker& worker, Task& task);
+        
+        /** Stop and join the worker threads
+         *
+         * @return the tasks that were still queued
+         */
+        std::vector<Task> stopWorkers();
+        
+        // Guards the workers list and serializes submit(), setWorkerCount() and the queue cleanup of cancel()
+        mutable std::mutex m_configurationMutex;
+        std::vector<std::unique_ptr<Worker> > m_workers;
+        std::size_t m_nextWorker;
+        
+        // Sleeping workers and running tasks
+        std::mutex m_stateMutex;
+        std::condition_variable m_wakeUpCondition;
+        std::condition_variable m_taskDoneCondition;
+        std::multiset<const void*> m_runningOwners;
+        std::size_t m_queuedCount;
+        bool m_shouldStop;
+    };
+}
+
+#endif
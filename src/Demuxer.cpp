@@ -26,6 +26,7 @@ extern "C"
 {
 #include <libavformat/avformat.h>
 #include <libavcodec/avcodec.h>
+#include <libavutil/channel_layout.h>
 #include <libswscale/swscale.h>
 #include <stdint.h>
 }
@@ -36,6 +37,8 @@ extern "C"
 #include "Log.hpp"
 #include "Utilities.hpp"
 #include "TimerPriorities.hpp"
+#include "TraceSpan.hpp"
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 
@@ -51,6 +54,76 @@ namespace sfe
         ONCE(Log::initialize());
     }
     
+    /** @return true if the container header gave the properties needed to decode each stream, so that
+     * the streams don't need to be analyzed
+     */
+    static bool headerDescribesAllStreams(const AVFormatContext* formatCtx)
+    {
+        if (formatCtx->nb_streams == 0)
+            return false;
+        
+        for (unsigned int i = 0; i < formatCtx->nb_streams; i++)
+        {
+            const AVCodecContext* codecCtx = formatCtx->streams[i]->codec;
+            
+            if (codecCtx->codec_id == AV_CODEC_ID_NONE)
+                return false;
+            
+            if (codecCtx->codec_type == AVMEDIA_TYPE_VIDEO && (codecCtx->width <= 0 || codecCtx->height <= 0))
+                return false;
+            
+            if (codecCtx->codec_type == AVMEDIA_TYPE_AUDIO && (codecCtx->sample_rate <= 0 || codecCtx->channels <= 0))
+                return false;
+        }
+        
+        return true;
+    }
+    
+    /** Open the given media and find the properties of its streams, without loading their decoders
+     *
+     * @return the format context of the media, to be closed with avformat_close_input()
+     */
+    static AVFormatContext* openFormatContext(const std::string& sourceFile, const OpenOptions& options)
+    {
+        AVFormatContext* formatCtx = nullptr;
+        int err = 0;
+        
+        // Bound the amount of data read to find the streams properties
+        AVDictionary* formatOptions = nullptr;
+        
+        if (options.probeSize > 0)
+            av_dict_set_int(&formatOptions, "probesize", options.probeSize, 0);
+        
+        if (options.analyzeDuration > sf::Time::Zero)
+            av_dict_set_int(&formatOptions, "analyzeduration", options.analyzeDuration.asMicroseconds(), 0);
+        
+        if (options.fpsProbeSize >= 0)
+            av_dict_set_int(&formatOptions, "fpsprobesize", options.fpsProbeSize, 0);
+        
+        // Open the movie file
+        err = avformat_open_input(&formatCtx, sourceFile.c_str(), nullptr, &formatOptions);
+        av_dict_free(&formatOptions);
+        CHECK0(err, "Demuxer::Demuxer() - error while opening media: " + sourceFile);
+        CHECK(formatCtx, "Demuxer() - inconsistency: media context cannot be nullptr");
+        
+        // Read the general movie informations
+        if (options.trustContainerHeader && headerDescribesAllStreams(formatCtx))
+        {
+            sfeLogDebug("Streams analysis skipped, the container header describes all the streams");
+        }
+        else
+        {
+            err = avformat_find_stream_info(formatCtx, nullptr);
+            
+            if (err < 0)
+                avformat_close_input(&formatCtx);
+            
+            CHECK0(err, "Demuxer::Demuxer() - error while retreiving media information");
+        }
+        
+        return formatCtx;
+    }
+    
     static MediaType AVMediaTypeToMediaType(AVMediaType type)
     {
         switch (type)
@@ -107,35 +180,116 @@ namespace sfe
         return g_availableDecoders;
     }
     
+    MediaInfo Demuxer::probe(const std::string& sourceFile, const OpenOptions& options)
+    {
+        loadFFmpeg();
+        
+        AVFormatContext* formatCtx = openFormatContext(sourceFile, options);
+        MediaInfo info;
+        info.isValid = true;
+        info.format = formatCtx->iformat->name;
+        info.bitRate = formatCtx->bit_rate;
+        
+        if (formatCtx->duration != AV_NOPTS_VALUE)
+            info.duration = sf::microseconds(formatCtx->duration);
+        
+        for (unsigned int i = 0; i < formatCtx->nb_streams; i++)
+        {
+            AVStream* ffstream = formatCtx->streams[i];
+            AVCodecContext* codecCtx = ffstream->codec;
+            MediaType type = AVMediaTypeToMediaType(codecCtx->codec_type);
+            
+            if (type == Unknown)
+                continue;
+            
+            StreamInfo stream;
+            stream.descriptor.type = type;
+            stream.descriptor.identifier = ffstream->index;
+            stream.codec = avcodec_get_name(codecCtx->codec_id);
+            stream.isDecodable = (avcodec_find_decoder(codecCtx->codec_id) != nullptr);
+            stream.bitRate = codecCtx->bit_rate;
+            
+            AVDictionaryEntry* entry = av_dict_get(ffstream->metadata, "language", nullptr, 0);
+            if (entry)
+                stream.descriptor.language = entry->value;
+            
+            // Like the demuxer, fall back to the streams duration
+            if (formatCtx->duration == AV_NOPTS_VALUE && ffstream->duration != AV_NOPTS_VALUE && type != Subtitle)
+            {
+                sf::Time duration = sf::microseconds(av_rescale_q(ffstream->duration, ffstream->time_base, AV_TIME_BASE_Q));
+                info.duration = std::max(info.duration, duration);
+            }
+            
+            switch (type)
+            {
+                case Video:
+                    stream.frameSize = sf::Vector2i(codecCtx->width, codecCtx->height);
+                    stream.frameRate = static_cast<float>(av_q2d(av_guess_frame_rate(formatCtx, ffstream, nullptr)));
+                    break;
+                    
+                case Audio:
+                {
+                    char layoutName[64];
+                    uint64_t layout = codecCtx->channel_layout;
+                    
+                    if (layout == 0)
+                        layout = av_get_default_channel_layout(codecCtx->channels);
+                    
+                    av_get_channel_layout_string(layoutName, sizeof(layoutName), codecCtx->channels, layout);
+                    stream.sampleRate = codecCtx->sample_rate;
+                    stream.channelCount = codecCtx->channels;
+                    stream.channelLayout = layoutName;
+                    break;
+                }
+                    
+                case Subtitle:
+                {
+#ifndef SFEMOVIE_ENABLE_ASS_SUBTITLES
+                    // Text subtitles are rendered with libass
+                    const AVCodecDescriptor* desc = av_codec_get_codec_descriptor(codecCtx);
+                    
+                    if (!desc || (desc->props & AV_CODEC_PROP_BITMAP_SUB) == 0)
+                        stream.isDecodable = false;
+#endif
+                    break;
+                }
+                    
+                default:
+                    break;
+            }
+            
+            info.streams.push_back(stream);
+        }
+        
+        avformat_close_input(&formatCtx);
+        return info;
+    }
+    
     Demuxer::Demuxer(const std::string& sourceFile, std::shared_ptr<Timer> timer,
-                     VideoStream::Delegate& videoDelegate, SubtitleStream::Delegate& subtitleDelegate) :
+                     VideoStream::Delegate& videoDelegate, SubtitleStream::Delegate& subtitleDelegate,
+                     const OpenOptions& options) :
     m_formatCtx(nullptr),
     m_eofReached(false),
+    m_memoryAccount(),
     m_streams(),
     m_ignoredStreams(),
     m_synchronized(),
     m_timer(timer),
     m_connectedAudioStream(nullptr),
+    m_audioMixer(std::make_shared<AudioMixer>()),
     m_connectedVideoStream(nullptr),
     m_connectedSubtitleStream(nullptr),
-    m_duration(sf::Time::Zero)
+    m_duration(sf::Time::Zero),
+    m_pendingDataForActiveStreams(),
+    m_pendingDataSize(0)
     {
         CHECK(sourceFile.size(), "Demuxer::Demuxer() - invalid argument: sourceFile");
         CHECK(timer, "Inconsistency error: null timer");
         
-        int err = 0;
-        
         // Load all the decoders
         loadFFmpeg();
         
-        // Open the movie file
-        err = avformat_open_input(&m_formatCtx, sourceFile.c_str(), nullptr, nullptr);
-        CHECK0(err, "Demuxer::Demuxer() - error while opening media: " + sourceFile);
-        CHECK(m_formatCtx, "Demuxer() - inconsistency: media context cannot be nullptr");
-        
-        // Read the general movie informations
-        err = avformat_find_stream_info(m_formatCtx, nullptr);
-        CHECK0(err, "Demuxer::Demuxer() - error while retreiving media information");
+        m_formatCtx = openFormatContext(sourceFile, options);
         
         // Get the media duration if possible (otherwise rely on the streams)
         if (m_formatCtx->duration != AV_NOPTS_VALUE)
@@ -229,6 +383,9 @@ namespace sfe
             }
         }
         
+        // No stream is selected yet
+        updateStreamsRouting();
+        
         m_timer->addObserver(*this, DemuxerTimerPriority);
     }
     
@@ -241,6 +398,9 @@ namespace sfe
         
         // NB: these manual cleaning are important for the AVFormatContext to be deleted last, otherwise
         // the streams lose their connection to the codec and leak
+        m_audioMixer->removeAllInputs();
+        m_packetRoutes.clear();
+        m_updatedStreams.clear();
         m_streams.clear();
         m_connectedAudioStream.reset();
         m_connectedSubtitleStream.reset();
@@ -293,6 +453,35 @@ namespace sfe
         return entries;
     }
     
+    std::shared_ptr<Stream> Demuxer::openFirstStreamOfType(MediaType type)
+    {
+        std::set< std::shared_ptr<Stream> > streams = getStreamsOfType(type);
+        
+        for (std::shared_ptr<Stream> stream : streams)
+        {
+            try
+            {
+                stream->openDecoder();
+                return stream;
+            }
+            catch (std::runtime_error& e)
+            {
+                // Forget the stream so that it is not listed as selectable anymore
+                std::map<int, std::shared_ptr<Stream> >::iterator it = m_streams.begin();
+                while (it != m_streams.end() && it->second != stream)
+                    it++;
+                
+                CHECK(it != m_streams.end(), "Internal inconcistency error: unknown stream");
+                m_ignoredStreams[it->first] = stream->description();
+                sfeLogError("error while loading " + stream->description() + ": " + e.what());
+                m_streams.erase(it);
+                updateStreamsRouting();
+            }
+        }
+        
+        return nullptr;
+    }
+    
     void Demuxer::selectAudioStream(std::shared_ptr<AudioStream> stream)
     {
         Status oldStatus = m_timer->getStatus();
@@ -304,15 +493,37 @@ namespace sfe
         
         if (stream != m_connectedAudioStream)
         {
+            // Fail before changing the selection if the decoder cannot be loaded
+            if (stream)
+                stream->openDecoder();
+            
             if (m_connectedAudioStream)
             {
                 m_connectedAudioStream->disconnect();
+                getSelectedAudioStream()->setMixer(nullptr);
             }
             
             if (stream)
+            {
+                // A stream cannot be mixed into itself
+                if (m_audioMixer->hasInput(stream.get()))
+                    m_audioMixer->removeInput(stream);
+                
+                for (std::shared_ptr<AudioStream> mixedStream : m_audioMixer->getInputs())
+                    mixedStream->setOutputSampleRate(stream->getSampleRate());
+                
                 stream->connect();
+                stream->setMixer(m_audioMixer);
+            }
+            else
+            {
+                // Nothing to mix into
+                for (std::shared_ptr<AudioStream> mixedStream : m_audioMixer->getInputs())
+                    removeMixedAudioStream(mixedStream);
+            }
             
             m_connectedAudioStream = stream;
+            updateStreamsRouting();
         }
         
         if (oldStatus == Playing)
@@ -321,9 +532,9 @@ namespace sfe
     
     void Demuxer::selectFirstAudioStream()
     {
-        std::set< std::shared_ptr<Stream> > audioStreams = getStreamsOfType(Audio);
-        if (audioStreams.size())
-            selectAudioStream(std::dynamic_pointer_cast<AudioStream>(*audioStreams.begin()));
+        std::shared_ptr<Stream> stream = openFirstStreamOfType(Audio);
+        if (stream)
+            selectAudioStream(std::dynamic_pointer_cast<AudioStream>(stream));
     }
     
     std::shared_ptr<AudioStream> Demuxer::getSelectedAudioStream() const
@@ -331,6 +542,49 @@ namespace sfe
         return std::dynamic_pointer_cast<AudioStream>(m_connectedAudioStream);
     }
     
+    void Demuxer::addMixedAudioStream(std::shared_ptr<AudioStream> stream)
+    {
+        CHECK(stream, "Demuxer::addMixedAudioStream() - invalid argument: stream");
+        CHECK(m_timer->getStatus() == Stopped, "Changing the mixed audio streams after starting "
+              "the movie playback isn't supported yet");
+        CHECK(stream != m_connectedAudioStream, "Demuxer::addMixedAudioStream() - "
+              "the selected audio stream cannot be mixed into itself");
+        CHECK(m_connectedAudioStream, "Demuxer::addMixedAudioStream() - no selected audio stream to mix into");
+        
+        stream->setOutputSampleRate(getSelectedAudioStream()->getSampleRate());
+        stream->openDecoder();
+        m_audioMixer->addInput(stream);
+        updateStreamsRouting();
+    }
+    
+    void Demuxer::removeMixedAudioStream(std::shared_ptr<AudioStream> stream)
+    {
+        CHECK(m_timer->getStatus() == Stopped, "Changing the mixed audio streams after starting "
+              "the movie playback isn't supported yet");
+        
+        if (m_audioMixer->hasInput(stream.get()))
+        {
+            m_audioMixer->removeInput(stream);
+            
+            sf::Lock l(m_synchronized);
+            stream->flushBuffers();
+            stream->closeDecoder();
+            updateStreamsRouting();
+            
+            AVPacket* packet = nullptr;
+            while (nullptr != (packet = gatherQueuedPacketForStream(*stream)))
+            {
+                av_free_packet(packet);
+                av_free(packet);
+            }
+        }
+    }
+    
+    std::vector<std::shared_ptr<AudioStream> > Demuxer::getMixedAudioStreams() const
+    {
+        return m_audioMixer->getInputs();
+    }
+    
     void Demuxer::selectVideoStream(std::shared_ptr<VideoStream> stream)
     {
         Status oldStatus = m_timer->getStatus();
@@ -342,6 +596,10 @@ namespace sfe
         
         if (stream != m_connectedVideoStream)
         {
+            // Fail before changing the selection if the decoder cannot be loaded
+            if (stream)
+                stream->openDecoder();
+            
             if (m_connectedVideoStream)
             {
                 m_connectedVideoStream->disconnect();
@@ -351,6 +609,7 @@ namespace sfe
                 stream->connect();
             
             m_connectedVideoStream = stream;
+            updateStreamsRouting();
         }
         
         if (oldStatus == Playing)
@@ -359,9 +618,9 @@ namespace sfe
     
     void Demuxer::selectFirstVideoStream()
     {
-        std::set< std::shared_ptr<Stream> > videoStreams = getStreamsOfType(Video);
-        if (videoStreams.size())
-            selectVideoStream(std::dynamic_pointer_cast<VideoStream>(*videoStreams.begin()));
+        std::shared_ptr<Stream> stream = openFirstStreamOfType(Video);
+        if (stream)
+            selectVideoStream(std::dynamic_pointer_cast<VideoStream>(stream));
     }
     
     std::shared_ptr<VideoStream> Demuxer::getSelectedVideoStream() const
@@ -378,6 +637,10 @@ namespace sfe
         
         if (stream != m_connectedSubtitleStream)
         {
+            // Fail before changing the selection if the decoder cannot be loaded
+            if (stream)
+                stream->openDecoder();
+            
             if (m_connectedSubtitleStream)
                 m_connectedSubtitleStream->disconnect();
             
@@ -385,6 +648,7 @@ namespace sfe
                 stream->connect();
             
             m_connectedSubtitleStream = stream;
+            updateStreamsRouting();
         }
         
         if (oldStatus == Playing)
@@ -393,9 +657,9 @@ namespace sfe
     
     void Demuxer::selectFirstSubtitleStream()
     {
-        std::set< std::shared_ptr<Stream> > subtitleStreams = getStreamsOfType(Subtitle);
-        if (subtitleStreams.size())
-            selectSubtitleStream(std::dynamic_pointer_cast<SubtitleStream>(*subtitleStreams.begin()));
+        std::shared_ptr<Stream> stream = openFirstStreamOfType(Subtitle);
+        if (stream)
+            selectSubtitleStream(std::dynamic_pointer_cast<SubtitleStream>(stream));
     }
     
     std::shared_ptr<SubtitleStream> Demuxer::getSelectedSubtitleStream() const
@@ -407,6 +671,7 @@ namespace sfe
     {
         CHECK(! stream.isPassive(), "Internal inconcistency - Cannot feed a passive stream");
         
+        SFE_TRACE_SCOPE("Demuxer::feedStream");
         sf::Lock l(m_synchronized);
         
         while ((!didReachEndOfFile() || hasPendingDataForStream(stream)) && stream.needsMoreData())
@@ -446,17 +711,36 @@ namespace sfe
         if (m_connectedSubtitleStream)
             set.insert(m_connectedSubtitleStream);
         
+        for (std::shared_ptr<AudioStream> mixedStream : m_audioMixer->getInputs())
+            set.insert(mixedStream);
+        
         return set;
     }
     
     void Demuxer::update()
     {
-        std::map<int, std::shared_ptr<Stream> > streams = getStreams();
+        // The selection changes on this thread, so the list is stable while visiting it
+        for (Stream* stream : m_updatedStreams)
+        {
+            stream->update();
+        }
+    }
+    
+    bool Demuxer::getTimeUntilNextUpdate(sf::Time& delay) const
+    {
+        bool isScheduled = false;
         
-        for(std::pair<int, std::shared_ptr<Stream> > pair : streams)
+        for (const Stream* stream : m_updatedStreams)
         {
-            pair.second->update();
+            sf::Time streamDelay;
+            if (stream->getTimeUntilNextUpdate(streamDelay) && (!isScheduled || streamDelay < delay))
+            {
+                delay = streamDelay;
+                isScheduled = true;
+            }
         }
+        
+        return isScheduled;
     }
     
     bool Demuxer::didReachEndOfFile() const
@@ -469,8 +753,14 @@ namespace sfe
         return m_duration;
     }
     
+    MemoryUsage Demuxer::getMemoryUsage() const
+    {
+        return m_memoryAccount.getUsage();
+    }
+    
     AVPacket* Demuxer::readPacket()
     {
+        SFE_TRACE_SCOPE("Demuxer::readPacket");
         sf::Lock l(m_synchronized);
         
         AVPacket *pkt = nullptr;
@@ -500,33 +790,45 @@ namespace sfe
         {
             for (AVPacket* packet : pair.second)
             {
+                m_memoryAccount.remove(MemoryAccount::EncodedPackets, Stream::packetMemory(packet));
                 av_free_packet(packet);
                 av_free(packet);
             }
         }
         
         m_pendingDataForActiveStreams.clear();
+        m_pendingDataSize = 0;
     }
     
-    void Demuxer::queueEncodedData(AVPacket* packet)
+    void Demuxer::queueEncodedData(AVPacket* packet, const Stream& targetStream)
     {
         sf::Lock l(m_synchronized);
         
-        std::set<std::shared_ptr<Stream>> connectedStreams = getSelectedStreams();
+        std::list<AVPacket*>& packets = m_pendingDataForActiveStreams[&targetStream];
+        packets.push_back(packet);
+        m_pendingDataSize += Stream::packetMemory(packet);
+        m_memoryAccount.add(MemoryAccount::EncodedPackets, Stream::packetMemory(packet));
         
-        for (std::shared_ptr<Stream> stream : connectedStreams)
+        // The stream requesting data may keep reading while the target stream doesn't consume its packets,
+        // don't let them pile up beyond the budget
+        if (MemoryAccount::exceedsBudget(m_pendingDataSize))
         {
-            if (stream->canUsePacket(packet))
+            std::size_t droppedCount = 0;
+            
+            while (!packets.empty() && (droppedCount == 0 || !(packets.front()->flags & AV_PKT_FLAG_KEY)))
             {
-                std::list<AVPacket*>& packets = m_pendingDataForActiveStreams[stream.get()];
-                packets.push_back(packet);
-                return;
+                AVPacket* droppedPacket = packets.front();
+                packets.pop_front();
+                m_pendingDataSize -= Stream::packetMemory(droppedPacket);
+                m_memoryAccount.remove(MemoryAccount::EncodedPackets, Stream::packetMemory(droppedPacket));
+                av_free_packet(droppedPacket);
+                av_free(droppedPacket);
+                droppedCount++;
             }
+            
+            sfeLogDebug("Memory budget exceeded, dropped " + s(droppedCount) + " queued packets of "
+                        + targetStream.description());
         }
-        
-        sfeLogError("No stream can use the packet, destroying it");
-        av_free_packet(packet);
-        av_free(packet);
     }
     
     bool Demuxer::hasPendingDataForStream(const Stream& stream) const
@@ -557,6 +859,8 @@ namespace sfe
             {
                 AVPacket* packet = pendingPackets.front();
                 pendingPackets.pop_front();
+                m_pendingDataSize -= Stream::packetMemory(packet);
+                m_memoryAccount.remove(MemoryAccount::EncodedPackets, Stream::packetMemory(packet));
                 return packet;
             }
         }
@@ -569,29 +873,43 @@ namespace sfe
         sf::Lock l(m_synchronized);
         CHECK(packet, "Demuxer::distributePacket() - invalid argument");
         
-        bool distributed = false;
-        std::map<int, std::shared_ptr<Stream> >::iterator it = m_streams.find(packet->stream_index);
+        // We don't want to store the packets for inactive streams, let them be freed
+        const unsigned int streamIndex = static_cast<unsigned int>(packet->stream_index);
+        Stream* targetStream = (streamIndex < m_packetRoutes.size()) ? m_packetRoutes[streamIndex] : nullptr;
+        
+        if (!targetStream)
+            return false;
+        
+        if (targetStream == &stream || targetStream->isPassive())
+            targetStream->pushEncodedData(packet);
+        else
+            queueEncodedData(packet, *targetStream);
+        
+        return true;
+    }
+    
+    void Demuxer::updateStreamsRouting()
+    {
+        sf::Lock l(m_synchronized);
+        std::set< std::shared_ptr<Stream> > selectedStreams = getSelectedStreams();
+        
+        m_packetRoutes.assign(m_formatCtx->nb_streams, nullptr);
+        m_updatedStreams.clear();
         
-        if (it != m_streams.end())
+        for (unsigned int i = 0; i < m_formatCtx->nb_streams; i++)
         {
-             std::shared_ptr<Stream>  targetStream = it->second;
+            std::map<int, std::shared_ptr<Stream> >::const_iterator it = m_streams.find(m_formatCtx->streams[i]->index);
+            const bool isSelected = (it != m_streams.end() && selectedStreams.count(it->second) > 0);
             
-            // We don't want to store the packets for inactive streams,
-            // let them be freed
-            if (targetStream == getSelectedVideoStream() ||
-                targetStream == getSelectedAudioStream() ||
-                targetStream == getSelectedSubtitleStream())
+            // The packets of the other streams are skipped by libavformat instead of being read and freed
+            m_formatCtx->streams[i]->discard = isSelected ? AVDISCARD_DEFAULT : AVDISCARD_ALL;
+            
+            if (isSelected)
             {
-                if (targetStream.get() == &stream || targetStream->isPassive())
-                    targetStream->pushEncodedData(packet);
-                else
-                    queueEncodedData(packet);
-                
-                distributed = true;
+                m_packetRoutes[m_formatCtx->streams[i]->index] = it->second.get();
+                m_updatedStreams.push_back(it->second.get());
             }
         }
-        
-        return distributed;
     }
     
     void Demuxer::extractDurationFromStream(const AVStream* stream)
@@ -601,10 +919,8 @@ namespace sfe
         
         if (stream->duration != AV_NOPTS_VALUE)
         {
-            int64_t secs, us;
-            secs = stream->duration / AV_TIME_BASE;
-            us = stream->duration % AV_TIME_BASE;
-            m_duration = sf::seconds(secs + (float)us / AV_TIME_BASE);
+            // The stream duration is expressed in the stream time base
+            m_duration = sf::microseconds(av_rescale_q(stream->duration, stream->time_base, AV_TIME_BASE_Q));
         }
     }
     
@@ -621,18 +937,16 @@ namespace sfe
         m_eofReached = false;
     }
     
+    MemoryAccount& Demuxer::getMemoryAccount()
+    {
+        return m_memoryAccount;
+    }
+    
     bool Demuxer::didSeek(const Timer &timer, sf::Time oldPosition)
     {
         resetEndOfFileStatus();
         sf::Time newPosition = timer.getOffset();
-        std::set< std::shared_ptr<Stream> > connectedStreams;
-        
-        if (m_connectedVideoStream)
-            connectedStreams.insert(m_connectedVideoStream);
-        if (m_connectedAudioStream)
-            connectedStreams.insert(m_connectedAudioStream);
-        if (m_connectedSubtitleStream)
-            connectedStreams.insert(m_connectedSubtitleStream);
+        std::set< std::shared_ptr<Stream> > connectedStreams = getSelectedStreams();
         
         CHECK(!connectedStreams.empty(), "Inconcistency error: seeking with no active stream");
         
@@ -780,6 +1094,14 @@ namespace sfe
                 CHECK(!(didReseekBackward && didReseekForward), "infinitely seeking backward and forward");
             }
             while (tooEarlyCount != 0 || tooLateCount != 0);
+            
+            // Mixed audio streams are not timer observers, so they're not told to fast forward
+            // like the other streams
+            for (std::shared_ptr<AudioStream> mixedStream : m_audioMixer->getInputs())
+            {
+                if (!mixedStream->fastForward(newPosition))
+                    return false;
+            }
         }
         
         return true;
@@ -28,14 +28,18 @@
 #include <SFML/System.hpp>
 #include "Stream.hpp"
 #include "AudioStream.hpp"
+#include "AudioMixer.hpp"
 #include "VideoStream.hpp"
 #include "SubtitleStream.hpp"
 #include "Timer.hpp"
+#include <sfeMovie/MediaInfo.hpp>
+#include <sfeMovie/OpenOptions.hpp>
 #include <map>
 #include <string>
 #include <set>
 #include <list>
 #include <utility>
+#include <vector>
 #include <memory>
 
 namespace sfe
@@ -74,6 +78,16 @@ namespace sfe
          */
         static const std::list<DecoderInfo>& getAvailableDecoders();
         
+        /** Read the properties of the given media and of its streams, without loading any decoder
+         *
+         * An exception is thrown if the media cannot be opened
+         *
+         * @param sourceFile the path of the media to probe
+         * @param options the limits of the work done to find the streams properties
+         * @return the properties of the media
+         */
+        static MediaInfo probe(const std::string& sourceFile, const OpenOptions& options);
+        
         /** Default constructor
          *
          * Open a media file and find its streams
@@ -81,8 +95,10 @@ namespace sfe
          * @param sourceFile the path of the media to open and play
          * @param timer the timer with which the media streams will be synchronized
          * @param videoDelegate the delegate that will handle the images produced by the VideoStreams
+         * @param options the limits of the work done to find the streams properties
          */
-        Demuxer(const std::string& sourceFile, std::shared_ptr<Timer> timer, VideoStream::Delegate& videoDelegate, SubtitleStream::Delegate& subtitleDelegate);
+        Demuxer(const std::string& sourceFile, std::shared_ptr<Timer> timer, VideoStream::Delegate& videoDelegate,
+                SubtitleStream::Delegate& subtitleDelegate, const OpenOptions& options = OpenOptions());
         
         /** Default destructor
          */
@@ -112,13 +128,14 @@ namespace sfe
         /** Enable the given audio stream and connect it to the reference timer
          *
          * If another stream of the same kind is already enabled, it is first disabled and disconnected
-         * so that only one stream of the same kind can be enabled at the same time.
+         * so that only one stream of the same kind can be enabled at the same time. Only the enabled
+         * streams have their decoder loaded.
          *
          * @param stream the audio stream to enable and connect for playing, or nullptr to disable audio
          */
         void selectAudioStream(std::shared_ptr<AudioStream> stream);
         
-        /** Enable the first found audio stream, if it exists
+        /** Enable the first found audio stream that can be decoded, if it exists
          *
          * @see selectAudioStream
          */
@@ -130,16 +147,40 @@ namespace sfe
          */
         std::shared_ptr<AudioStream> getSelectedAudioStream() const;
         
+        /** Mix the given audio stream into the selected audio stream, so that both are played together
+         *
+         * The mixed stream is decoded at the sample rate of the selected audio stream and is fed with
+         * packets like the selected streams. Its decoder is loaded until it is removed from the mix.
+         *
+         * @warning This can only be done while the timer is stopped
+         *
+         * @param stream the audio stream to mix, it must not be the selected audio stream
+         */
+        void addMixedAudioStream(std::shared_ptr<AudioStream> stream);
+        
+        /** Stop mixing the given audio stream into the selected audio stream
+         *
+         * @warning This can only be done while the timer is stopped
+         *
+         * @param stream the audio stream to remove from the mix
+         */
+        void removeMixedAudioStream(std::shared_ptr<AudioStream> stream);
+        
+        /** @return the audio streams mixed into the selected audio stream
+         */
+        std::vector<std::shared_ptr<AudioStream> > getMixedAudioStreams() const;
+        
         /** Enable the given video stream and connect it to the reference timer
          *
          * If another stream of the same kind is already enabled, it is first disabled and disconnected
-         * so that only one stream of the same kind can be enabled at the same time.
+         * so that only one stream of the same kind can be enabled at the same time. Only the enabled
+         * streams have their decoder loaded.
          *
          * @param stream the video stream to enable and connect for playing, or nullptr to disable video
          */
         void selectVideoStream(std::shared_ptr<VideoStream> stream);
         
-        /** Enable the first found video stream, if it exists
+        /** Enable the first found video stream that can be decoded, if it exists
          *
          * @see selectAudioStream
          */
@@ -154,13 +195,14 @@ namespace sfe
         /** Enable the given subtitle stream and connect it to the reference timer
          *
          * If another stream of the same kind is already enabled, it is first disabled and disconnected
-         * so that only one stream of the same kind can be enabled at the same time.
+         * so that only one stream of the same kind can be enabled at the same time. Only the enabled
+         * streams have their decoder loaded.
          *
          * @param stream the video stream to enable and connect for playing, or nullptr to disable video
          */
         void selectSubtitleStream(std::shared_ptr<SubtitleStream> stream);
         
-        /** Enable the first found video stream, if it exists
+        /** Enable the first found subtitle stream that can be decoded, if it exists
          *
          * @see selectAudioStream
          */
@@ -179,7 +221,7 @@ namespace sfe
          */
         void feedStream(Stream& stream);
         
-        /** @return a list of all the active streams
+        /** @return a list of all the active streams, including the mixed audio streams
          */
         std::set<std::shared_ptr<Stream>> getSelectedStreams() const;
         
@@ -187,6 +229,13 @@ namespace sfe
          */
         void update();
         
+        /** Tell when update() will next have something to show for the selected streams
+         *
+         * @param[out] delay the time left before the earliest change, unmodified if nothing is scheduled
+         * @return true if an update is scheduled, false otherwise
+         */
+        bool getTimeUntilNextUpdate(sf::Time& delay) const;
+        
         /** Tell whether the demuxer has reached the end of the file and can no more feed the streams
          *
          * @return whether the end of the media file has been reached
@@ -199,6 +248,10 @@ namespace sfe
          */
         sf::Time getDuration() const;
         
+        /** @return the memory used by the buffers of the streams and of the demuxer
+         */
+        MemoryUsage getMemoryUsage() const;
+        
     private:
         /** Read a encoded packet from the media file
          *
@@ -213,10 +266,14 @@ namespace sfe
         void flushBuffers();
         
         /** Queue a packet that has been read and is to be used by an active stream in near future
+         *
+         * If the queued packets exceed the memory budget, the oldest packets of @a targetStream are
+         * dropped up to its next keyframe, as this stream doesn't consume them fast enough
          *
          * @param packet the packet to temporarily store
+         * @param targetStream the stream that will use the packet
          */
-        void queueEncodedData(AVPacket* packet);
+        void queueEncodedData(AVPacket* packet, const Stream& targetStream);
         
         /** Check whether data that should be distributed to the given stream is currently pending
          * in the demuxer's temporary queue
@@ -245,28 +302,54 @@ namespace sfe
          */
         bool distributePacket(AVPacket* packet, Stream& stream);
         
+        /** Open the decoder of the first stream of the given type that can be decoded
+         *
+         * The streams whose decoder cannot be opened are removed from the available streams.
+         *
+         * @param type the type of the stream to open
+         * @return the opened stream, or nullptr if no stream of this type can be decoded
+         */
+        std::shared_ptr<Stream> openFirstStreamOfType(MediaType type);
+        
         /** Try to extract the media duration from the given stream
          */
         void extractDurationFromStream(const AVStream* stream);
         
+        /** Rebuild the packet routing table from the selected streams, and make libavformat skip
+         * the packets of the streams that are not selected
+         */
+        void updateStreamsRouting();
+        
         // Data source interface
         void requestMoreData(Stream& starvingStream) override;
         void resetEndOfFileStatus() override;
+        MemoryAccount& getMemoryAccount() override;
         
         // Timer interface
         bool didSeek(const Timer& timer, sf::Time oldPosition) override;
         
         AVFormatContext* m_formatCtx;
         bool m_eofReached;
+        
+        // Declared before the streams that count their buffers in it
+        MemoryAccount m_memoryAccount;
         std::map<int, std::shared_ptr<Stream> > m_streams;
         std::map<int, std::string> m_ignoredStreams;
         mutable sf::Mutex m_synchronized;
         std::shared_ptr<Timer> m_timer;
         std::shared_ptr<Stream> m_connectedAudioStream;
+        std::shared_ptr<AudioMixer> m_audioMixer;
         std::shared_ptr<Stream> m_connectedVideoStream;
         std::shared_ptr<Stream> m_connectedSubtitleStream;
         sf::Time m_duration;
         std::map<const Stream*, std::list<AVPacket*> > m_pendingDataForActiveStreams;
+        std::size_t m_pendingDataSize;
+        
+        // Selected stream of each stream index, null for the other streams
+        std::vector<Stream*> m_packetRoutes;
+        
+        // Selected streams in stream index order, only used by the thread that selects streams
+        std::vector<Stream*> m_updatedStreams;
         
         static std::list<DemuxerInfo> g_availableDemuxers;
         static std::list<DecoderInfo> g_availableDecoders;
@@ -0,0 +1,150 @@
+
+/*
+ *  ImageKernels.cpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#include "ImageKernels.hpp"
+#include "Macros.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if SFEMOVIE_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace sfe
+{
+#if SFEMOVIE_HAS_SSE2
+    namespace
+    {
+        // divideBy255() on each unsigned 16 bits lane
+        __m128i divideLanesBy255(__m128i value)
+        {
+            const __m128i rounded = _mm_add_epi16(value, _mm_set1_epi16(128));
+            return _mm_srli_epi16(_mm_add_epi16(rounded, _mm_srli_epi16(rounded, 8)), 8);
+        }
+    }
+#endif
+    
+    namespace ImageKernels
+    {
+        void blendCoverage(const sf::Uint8* coverage, std::size_t pixelCount, const sf::Uint8 color[4],
+                           sf::Uint8* destination)
+        {
+            std::size_t i = 0;
+
+#if SFEMOVIE_HAS_SSE2
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i full = _mm_set1_epi16(255);
+            const __m128i colorAlpha = _mm_set1_epi16(color[3]);
+            
+            // Alpha lanes are multiplied by 255 so that they end up being the source alpha
+            const __m128i colorLanes = _mm_set_epi16(255, color[2], color[1], color[0],
+                                                     255, color[2], color[1], color[0]);
+            
+            for (; i + 4 <= pixelCount; i += 4)
+            {
+                int coverageBytes;
+                std::memcpy(&coverageBytes, coverage + i, sizeof(coverageBytes));
+                
+                // Source alpha of the 4 pixels, then spread over the 4 lanes of each pixel
+                const __m128i coverage16 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(coverageBytes), zero);
+                const __m128i alpha = divideLanesBy255(_mm_mullo_epi16(coverage16, colorAlpha));
+                const __m128i alphaPairs = _mm_unpacklo_epi16(alpha, alpha);
+                const __m128i alphaLow = _mm_unpacklo_epi32(alphaPairs, alphaPairs);
+                const __m128i alphaHigh = _mm_unpackhi_epi32(alphaPairs, alphaPairs);
+                
+                const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(destination + 4 * i));
+                const __m128i pixelsLow = _mm_unpacklo_epi8(pixels, zero);
+                const __m128i pixelsHigh = _mm_unpackhi_epi8(pixels, zero);
+                
+                // source * alpha + destination * (1 - alpha)
+                const __m128i low = _mm_add_epi16(divideLanesBy255(_mm_mullo_epi16(colorLanes, alphaLow)),
+                                                  divideLanesBy255(_mm_mullo_epi16(pixelsLow,
+                                                                                   _mm_sub_epi16(full, alphaLow))));
+                const __m128i high = _mm_add_epi16(divideLanesBy255(_mm_mullo_epi16(colorLanes, alphaHigh)),
+                                                   divideLanesBy255(_mm_mullo_epi16(pixelsHigh,
+                                                                                    _mm_sub_epi16(full, alphaHigh))));
+                
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + 4 * i), _mm_packus_epi16(low, high));
+            }
+#endif
+            
+            for (; i < pixelCount; i++)
+            {
+                const unsigned int alpha = divideBy255(coverage[i] * color[3]);
+                const unsigned int inverseAlpha = 255 - alpha;
+                sf::Uint8* pixel = destination + 4 * i;
+                
+                for (int channel = 0; channel < 3; channel++)
+                {
+                    const unsigned int value = divideBy255(color[channel] * alpha) +
+                                               divideBy255(pixel[channel] * inverseAlpha);
+                    pixel[channel] = static_cast<sf::Uint8>(std::min(value, 255u));
+                }
+                
+                pixel[3] = static_cast<sf::Uint8>(std::min(alpha + divideBy255(pixel[3] * inverseAlpha), 255u));
+            }
+        }
+        
+        void expandPalette(const sf::Uint8* indices, std::size_t pixelCount, const sf::Uint32 palette[256],
+                           sf::Uint8* destination)
+        {
+            std::size_t i = 0;
+
+#if SFEMOVIE_HAS_SSE2
+            for (; i + 16 <= pixelCount; i += 16)
+            {
+                const sf::Uint8* block = indices + i;
+                __m128i* output = reinterpret_cast<__m128i*>(destination + 4 * i);
+                const __m128i blockIndices = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+                const __m128i firstIndex = _mm_set1_epi8(static_cast<char>(block[0]));
+                
+                // Subtitle bitmaps are mostly made of long runs of the transparent color
+                if (_mm_movemask_epi8(_mm_cmpeq_epi8(blockIndices, firstIndex)) == 0xFFFF)
+                {
+                    const __m128i color = _mm_set1_epi32(static_cast<int>(palette[block[0]]));
+                    _mm_storeu_si128(output, color);
+                    _mm_storeu_si128(output + 1, color);
+                    _mm_storeu_si128(output + 2, color);
+                    _mm_storeu_si128(output + 3, color);
+                }
+                else
+                {
+                    // SSE2 has no gather instruction, only the stores are vectorized
+                    for (int j = 0; j < 4; j++)
+                    {
+                        const sf::Uint8* quad = block + 4 * j;
+                        _mm_storeu_si128(output + j, _mm_set_epi32(static_cast<int>(palette[quad[3]]),
+                                                                   static_cast<int>(palette[quad[2]]),
+                                                                   static_cast<int>(palette[quad[1]]),
+                                                                   static_cast<int>(palette[quad[0]])));
+                    }
+                }
+            }
+#endif
+            
+            for (; i < pixelCount; i++)
+                std::memcpy(destination + 4 * i, &palette[indices[i]], sizeof(sf::Uint32));
+        }
+    }
+}
@@ -0,0 +1,64 @@
+
+/*
+ *  ImageKernels.hpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef SFEMOVIE_IMAGE_KERNELS_HPP
+#define SFEMOVIE_IMAGE_KERNELS_HPP
+
+#include <SFML/Config.hpp>
+#include <cstddef>
+
+namespace sfe
+{
+    namespace ImageKernels
+    {
+        /** Divide by 255 with rounding to the nearest integer, exact for values up to 255 * 255
+         */
+        inline unsigned int divideBy255(unsigned int value)
+        {
+            return (value + 128 + ((value + 128) >> 8)) >> 8;
+        }
+        
+        /** Composite a row of a single color coverage map over premultiplied RGBA pixels
+         *
+         * @param coverage how much of each pixel is covered by the color, in range [0, 255]
+         * @param pixelCount the count of pixels in @a coverage and @a destination
+         * @param color the red, green, blue and alpha components of the color, not premultiplied
+         * @param[in,out] destination the premultiplied RGBA pixels to composite over
+         */
+        void blendCoverage(const sf::Uint8* coverage, std::size_t pixelCount, const sf::Uint8 color[4],
+                           sf::Uint8* destination);
+        
+        /** Convert a row of paletted pixels to RGBA pixels
+         *
+         * @param indices the palette index of each pixel
+         * @param pixelCount the count of pixels in @a indices
+         * @param palette the 256 colors of the palette, as RGBA bytes in memory order
+         * @param[out] destination the RGBA pixels, must be able to hold 4 * @a pixelCount bytes
+         */
+        void expandPalette(const sf::Uint8* indices, std::size_t pixelCount, const sf::Uint32 palette[256],
+                           sf::Uint8* destination);
+    }
+}
+
+#endif
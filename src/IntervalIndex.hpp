@@ -0,0 +1,347 @@
+
+/*
+ *  IntervalIndex.hpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef SFEMOVIE_INTERVAL_INDEX_HPP
+#define SFEMOVIE_INTERVAL_INDEX_HPP
+
+#include <SFML/System.hpp>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace sfe
+{
+    /** Time intervals that can be searched by the time they cover
+     *
+     * Intervals are kept sorted by start time, along with two trees giving the highest and lowest end
+     * time of any range of intervals. Finding the intervals that cover a given time or that ended before it
+     * only visits the branches that contain such intervals: it takes O(log n + k log n) for k results.
+     *
+     * Inserting intervals in start time order is cheap, as it happens when decoding media.
+     * Inserting an interval before the last one costs a rebuild.
+     */
+    template <typename T>
+    class IntervalIndex
+    {
+    public:
+        struct Interval
+        {
+            sf::Time start; //!< First time covered by the interval
+            sf::Time end;   //!< First time after the interval
+            T value;
+        };
+        
+        IntervalIndex();
+        
+        /** Add an interval to the index
+         *
+         * @param start the first time covered by the interval
+         * @param end the first time after the interval
+         * @param value the value associated to the interval
+         */
+        void insert(sf::Time start, sf::Time end, const T& value);
+        
+        /** Find all the intervals that cover the given time, ie. start <= time < end
+         *
+         * @param time the time to look for
+         * @param[out] intervals the intervals covering @a time, sorted by start time. They're valid until
+         * the index is modified
+         */
+        void findOverlapping(sf::Time time, std::vector<const Interval*>& intervals) const;
+        
+        /** Find the earliest start time after the given time, ie. start > time
+         *
+         * @param time the time to look after
+         * @param[out] start the earliest start time found, unmodified if there is none
+         * @return true if an interval starts after @a time, false otherwise
+         */
+        bool findNextStart(sf::Time time, sf::Time& start) const;
+        
+        /** Remove all the intervals that end before the given time, ie. end <= time
+         *
+         * @param time the time before which intervals are removed
+         */
+        void eraseEndingBefore(sf::Time time);
+        
+        /** Remove all the intervals
+         */
+        void clear();
+        
+        /** @return the count of intervals in the index
+         */
+        std::size_t getSize() const;
+    
+    private:
+        /** Drop the erased intervals and compute the trees again
+         */
+        void rebuild();
+        
+        /** Compute the tree nodes above the given leaf again
+         */
+        void updateParents(std::size_t leaf);
+        
+        void findOverlapping(std::size_t node, std::size_t nodeBegin, std::size_t nodeEnd, std::size_t count,
+                             sf::Time time, std::vector<const Interval*>& intervals) const;
+        void findEndingBefore(std::size_t node, sf::Time time, std::vector<std::size_t>& leaves) const;
+        
+        static sf::Time lowestTime();
+        static sf::Time highestTime();
+        
+        // Sorted by start time, erased intervals are only dropped by rebuild()
+        std::vector<Interval> m_intervals;
+        std::size_t m_erasedCount;
+        
+        // Complete binary trees stored as arrays: node i has children 2i and 2i+1, the root is node 1
+        // and the leaves start at m_leafCount. Erased intervals have leaves that match no search
+        std::size_t m_leafCount;
+        std::vector<sf::Time> m_highestEnds;
+        std::vector<sf::Time> m_lowestEnds;
+    };
+    
+    template <typename T>
+    IntervalIndex<T>::IntervalIndex() :
+    m_intervals(),
+    m_erasedCount(0),
+    m_leafCount(0),
+    m_highestEnds(),
+    m_lowestEnds()
+    {
+    }
+    
+    template <typename T>
+    void IntervalIndex<T>::insert(sf::Time start, sf::Time end, const T& value)
+    {
+        Interval interval;
+        interval.start = start;
+        interval.end = end;
+        interval.value = value;
+        
+        if (m_intervals.empty() || start >= m_intervals.back().start)
+        {
+            m_intervals.push_back(interval);
+            
+            if (m_intervals.size() > m_leafCount)
+            {
+                rebuild();
+            }
+            else
+            {
+                const std::size_t leaf = m_leafCount + m_intervals.size() - 1;
+                m_highestEnds[leaf] = end;
+                m_lowestEnds[leaf] = end;
+                updateParents(leaf);
+            }
+        }
+        else
+        {
+            // The trees describe the current layout, erased intervals must be dropped before it changes
+            rebuild();
+            
+            typename std::vector<Interval>::iterator position =
+                std::upper_bound(m_intervals.begin(), m_intervals.end(), start,
+                                 [](sf::Time time, const Interval& other) { return time < other.start; });
+            m_intervals.insert(position, interval);
+            rebuild();
+        }
+    }
+    
+    template <typename T>
+    void IntervalIndex<T>::findOverlapping(sf::Time time, std::vector<const Interval*>& intervals) const
+    {
+        intervals.clear();
+        
+        if (m_intervals.empty())
+            return;
+        
+        // Only the intervals that start before the given time are candidates
+        const std::size_t count = std::upper_bound(m_intervals.begin(), m_intervals.end(), time,
+                                                   [](sf::Time value, const Interval& other)
+                                                   { return value < other.start; }) - m_intervals.begin();
+        
+        findOverlapping(1, 0, m_leafCount, count, time, intervals);
+    }
+    
+    template <typename T>
+    bool IntervalIndex<T>::findNextStart(sf::Time time, sf::Time& start) const
+    {
+        std::size_t index = std::upper_bound(m_intervals.begin(), m_intervals.end(), time,
+                                             [](sf::Time value, const Interval& other)
+                                             { return value < other.start; }) - m_intervals.begin();
+        
+        // Erased intervals are still in place until the next rebuild
+        while (index < m_intervals.size() && m_highestEnds[m_leafCount + index] == lowestTime())
+            index++;
+        
+        if (index == m_intervals.size())
+            return false;
+        
+        start = m_intervals[index].start;
+        return true;
+    }
+    
+    template <typename T>
+    void IntervalIndex<T>::eraseEndingBefore(sf::Time time)
+    {
+        if (m_intervals.empty())
+            return;
+        
+        std::vector<std::size_t> leaves;
+        findEndingBefore(1, time, leaves);
+        
+        for (std::size_t leaf : leaves)
+        {
+            m_highestEnds[leaf] = lowestTime();
+            m_lowestEnds[leaf] = highestTime();
+            updateParents(leaf);
+        }
+        
+        m_erasedCount += leaves.size();
+        
+        // Compacting costs O(n), only do it once it has been paid by as many erasures
+        if (m_erasedCount * 2 > m_intervals.size())
+            rebuild();
+    }
+    
+    template <typename T>
+    void IntervalIndex<T>::clear()
+    {
+        m_intervals.clear();
+        m_erasedCount = 0;
+        m_leafCount = 0;
+        m_highestEnds.clear();
+        m_lowestEnds.clear();
+    }
+    
+    template <typename T>
+    std::size_t IntervalIndex<T>::getSize() const
+    {
+        return m_intervals.size() - m_erasedCount;
+    }
+    
+    template <typename T>
+    void IntervalIndex<T>::rebuild()
+    {
+        if (m_erasedCount > 0)
+        {
+            std::size_t kept = 0;
+            
+            for (std::size_t i = 0; i < m_intervals.size(); i++)
+            {
+                // Intervals appended since the last rebuild have no leaf yet, and are not erased
+                const bool isErased = i < m_leafCount && m_highestEnds[m_leafCount + i] == lowestTime();
+                
+                if (!isErased)
+                {
+                    if (kept != i)
+                        m_intervals[kept] = m_intervals[i];
+                    kept++;
+                }
+            }
+            
+            m_intervals.erase(m_intervals.begin() + kept, m_intervals.end());
+            m_erasedCount = 0;
+        }
+        
+        // Leave room for appending as many intervals before the next rebuild
+        m_leafCount = 1;
+        while (m_leafCount < m_intervals.size() * 2)
+            m_leafCount <<= 1;
+        
+        m_highestEnds.assign(m_leafCount * 2, lowestTime());
+        m_lowestEnds.assign(m_leafCount * 2, highestTime());
+        
+        for (std::size_t i = 0; i < m_intervals.size(); i++)
+        {
+            m_highestEnds[m_leafCount + i] = m_intervals[i].end;
+            m_lowestEnds[m_leafCount + i] = m_intervals[i].end;
+        }
+        
+        for (std::size_t node = m_leafCount - 1; node > 0; node--)
+        {
+            m_highestEnds[node] = std::max(m_highestEnds[2 * node], m_highestEnds[2 * node + 1]);
+            m_lowestEnds[node] = std::min(m_lowestEnds[2 * node], m_lowestEnds[2 * node + 1]);
+        }
+    }
+    
+    template <typename T>
+    void IntervalIndex<T>::updateParents(std::size_t leaf)
+    {
+        for (std::size_t node = leaf / 2; node > 0; node /= 2)
+        {
+            m_highestEnds[node] = std::max(m_highestEnds[2 * node], m_highestEnds[2 * node + 1]);
+            m_lowestEnds[node] = std::min(m_lowestEnds[2 * node], m_lowestEnds[2 * node + 1]);
+        }
+    }
+    
+    template <typename T>
+    void IntervalIndex<T>::findOverlapping(std::size_t node, std::size_t nodeBegin, std::size_t nodeEnd,
+                                           std::size_t count, sf::Time time,
+                                           std::vector<const Interval*>& intervals) const
+    {
+        if (nodeBegin >= count || m_highestEnds[node] <= time)
+            return;
+        
+        if (node >= m_leafCount)
+        {
+            intervals.push_back(&m_intervals[node - m_leafCount]);
+        }
+        else
+        {
+            const std::size_t middle = (nodeBegin + nodeEnd) / 2;
+            findOverlapping(2 * node, nodeBegin, middle, count, time, intervals);
+            findOverlapping(2 * node + 1, middle, nodeEnd, count, time, intervals);
+        }
+    }
+    
+    template <typename T>
+    void IntervalIndex<T>::findEndingBefore(std::size_t node, sf::Time time, std::vector<std::size_t>& leaves) const
+    {
+        if (m_lowestEnds[node] > time)
+            return;
+        
+        if (node >= m_leafCount)
+        {
+            leaves.push_back(node);
+        }
+        else
+        {
+            findEndingBefore(2 * node, time, leaves);
+            findEndingBefore(2 * node + 1, time, leaves);
+        }
+    }
+    
+    template <typename T>
+    sf::Time IntervalIndex<T>::lowestTime()
+    {
+        return sf::microseconds(std::numeric_limits<sf::Int64>::min());
+    }
+    
+    template <typename T>
+    sf::Time IntervalIndex<T>::highestTime()
+    {
+        return sf::microseconds(std::numeric_limits<sf::Int64>::max());
+    }
+}
+
+#endif
@@ -24,8 +24,14 @@
 
 #include "Log.hpp"
 #include "Macros.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdlib>
 #include <iostream>
-#include <SFML/System.hpp>
+#include <mutex>
+#include <thread>
+#include <vector>
 extern "C"
 {
 #include <libavutil/avutil.h>
@@ -35,11 +41,222 @@ namespace sfe
 {
     namespace Log
     {
-        static int g_logLevel = ErrorLogLevel;
-        static sf::Mutex g_synchronized;
+        std::atomic<int> g_logLevel(ErrorLogLevel);
+        
+        namespace
+        {
+            const std::size_t QueueCapacity = 4096; // must be a power of two
+            const std::chrono::milliseconds FlushTimeout(100);
+            
+            std::string filename(const char* filepath)
+            {
+                const std::string path(filepath);
+                size_t pos = path.find_last_of("/");
+                
+                if (pos != std::string::npos && pos+1 != path.size())
+                    return path.substr(pos+1);
+                else
+                    return path;
+            }
+            
+            /** Writes the log messages from a background thread, so that logging threads never wait
+             * for the output or for each other
+             *
+             * The messages go through a bounded multiple producers / single consumer queue where each slot
+             * has a sequence number telling whether it is free for the producer of a given position or
+             * ready for the consumer. Messages that don't fit in a full queue are counted and dropped.
+             */
+            class AsyncLogger
+            {
+            public:
+                AsyncLogger() :
+                m_slots(QueueCapacity),
+                m_enqueuePosition(0),
+                m_dequeuePosition(0),
+                m_droppedCount(0),
+                m_shouldStop(false),
+                m_wakeUpMutex(),
+                m_wakeUpCondition(),
+                m_drainedCondition(),
+                m_thread()
+                {
+                    for (std::size_t i = 0; i < QueueCapacity; i++)
+                        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+                    
+                    m_thread = std::thread(&AsyncLogger::run, this);
+                }
+                
+                ~AsyncLogger()
+                {
+                    m_shouldStop = true;
+                    m_wakeUpCondition.notify_one();
+                    m_thread.join();
+                }
+                
+                void push(const char* prefix, std::string&& text)
+                {
+                    std::size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+                    Slot* slot = nullptr;
+                    
+                    while (true)
+                    {
+                        slot = &m_slots[position & (QueueCapacity - 1)];
+                        const std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+                        const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence - position);
+                        
+                        if (difference == 0)
+                        {
+                            if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                                break;
+                        }
+                        else if (difference < 0)
+                        {
+                            m_droppedCount++;
+                            return;
+                        }
+                        else
+                        {
+                            position = m_enqueuePosition.load(std::memory_order_relaxed);
+                        }
+                    }
+                    
+                    slot->prefix = prefix;
+                    slot->text = std::move(text);
+                    slot->sequence.store(position + 1, std::memory_order_release);
+                    
+                    // Not notified under m_wakeUpMutex so that logging never waits for the writing thread,
+                    // a wake-up missed while it is not waiting yet is caught up by its timed wait
+                    m_wakeUpCondition.notify_one();
+                }
+                
+                /** Wait until the messages logged so far are written, or until FlushTimeout elapsed so that
+                 * a stuck output doesn't prevent the process from exiting
+                 */
+                void flush()
+                {
+                    const std::size_t position = m_enqueuePosition.load();
+                    std::unique_lock<std::mutex> lock(m_wakeUpMutex);
+                    
+                    m_wakeUpCondition.notify_one();
+                    m_drainedCondition.wait_for(lock, FlushTimeout, [this, position]
+                    {
+                        return m_dequeuePosition.load() >= position;
+                    });
+                }
+            
+            private:
+                struct Slot
+                {
+                    std::atomic<std::size_t> sequence;
+                    const char* prefix;
+                    std::string text;
+                };
+                
+                void run()
+                {
+                    while (!m_shouldStop)
+                    {
+                        {
+                            // Wake-ups are not sent under lock by push(), so don't rely on them only
+                            std::unique_lock<std::mutex> lock(m_wakeUpMutex);
+                            m_wakeUpCondition.wait_for(lock, std::chrono::milliseconds(50));
+                        }
+                        
+                        drain();
+                    }
+                    
+                    drain();
+                }
+                
+                void drain()
+                {
+                    const std::size_t droppedCount = m_droppedCount.exchange(0);
+                    if (droppedCount > 0)
+                        std::cerr << "Warning: " << droppedCount << " log messages were dropped" << std::endl;
+                    
+                    std::size_t position = m_dequeuePosition.load(std::memory_order_relaxed);
+                    
+                    while (true)
+                    {
+                        Slot& slot = m_slots[position & (QueueCapacity - 1)];
+                        
+                        if (slot.sequence.load(std::memory_order_acquire) != position + 1)
+                            break;
+                        
+                        std::cerr << slot.prefix << slot.text << '\n';
+                        slot.text.clear();
+                        slot.sequence.store(position + QueueCapacity, std::memory_order_release);
+                        m_dequeuePosition.store(++position);
+                    }
+                    
+                    std::cerr.flush();
+                    
+                    {
+                        std::lock_guard<std::mutex> lock(m_wakeUpMutex);
+                    }
+                    m_drainedCondition.notify_all();
+                }
+                
+                std::vector<Slot> m_slots;
+                std::atomic<std::size_t> m_enqueuePosition;
+                std::atomic<std::size_t> m_dequeuePosition;
+                std::atomic<std::size_t> m_droppedCount;
+                std::atomic<bool> m_shouldStop;
+                std::mutex m_wakeUpMutex;
+                std::condition_variable m_wakeUpCondition;
+                std::condition_variable m_drainedCondition;
+                std::thread m_thread;
+            };
+            
+            AsyncLogger& logger()
+            {
+                // Leaked on purpose: the worker threads, the audio thread and FFmpeg can still log while the
+                // static objects are destroyed. The pending messages are written at exit instead
+                static AsyncLogger& instance = *new AsyncLogger;
+                static const int flushRegistration = std::atexit([] { logger().flush(); });
+                (void)flushRegistration;
+                return instance;
+            }
+            
+            void log(const char* prefix, const char* file, int line, const char* function, const std::string& message)
+            {
+                logger().push(prefix, filename(file) + ":" + s(line) + ": " + function + "() - " + message);
+            }
+            
+            /** Route the FFmpeg messages to the sfeMovie log, once av_log_set_level() filtered them
+             */
+            void ffmpegLogCallback(void* context, int level, const char* format, va_list arguments)
+            {
+                if (level > av_log_get_level())
+                    return;
+                
+                // FFmpeg may log a single line in several calls, which must be joined
+                static thread_local std::string pendingLine;
+                static thread_local int printPrefix = 1;
+                char buffer[1024];
+                av_log_format_line(context, level, format, arguments, buffer, sizeof(buffer), &printPrefix);
+                pendingLine += buffer;
+                
+                if (pendingLine.empty() || pendingLine[pendingLine.size() - 1] != '\n')
+                    return;
+                
+                pendingLine.erase(pendingLine.size() - 1);
+                
+                if (level <= AV_LOG_ERROR)
+                    logger().push("Error: FFmpeg: ", std::move(pendingLine));
+                else if (level <= AV_LOG_WARNING)
+                    logger().push("Warning: FFmpeg: ", std::move(pendingLine));
+                else
+                    logger().push("Debug: FFmpeg: ", std::move(pendingLine));
+                
+                pendingLine.clear();
+            }
+        }
         
         void initialize()
         {
+            av_log_set_callback(ffmpegLogCallback);
+            
 #if DEBUG
             setLogLevel(DebugLogLevel);
 #else
@@ -49,7 +266,6 @@ namespace sfe
         
         void setLogLevel(LogLevel level)
         {
-            sf::Lock l(g_synchronized);
             g_logLevel = level;
             
             switch (level)
@@ -62,44 +278,27 @@ namespace sfe
             }
         }
         
-        static std::string filename(const std::string& filepath)
+        void debug(const char* file, int line, const char* function, const std::string& message)
         {
-            size_t pos = filepath.find_last_of("/");
-            
-            if (pos != std::string::npos && pos+1 != filepath.size())
-                return filepath.substr(pos+1);
-            else
-                return filepath;
+            if (isEnabled(DebugLogLevel))
+                log("Debug: ", file, line, function, message);
         }
         
-        void debug(const std::string& file, const std::string& message)
+        void warning(const char* file, int line, const char* function, const std::string& message)
         {
-            sf::Lock l(g_synchronized);
-            
-            if (g_logLevel >= DebugLogLevel)
-            {
-                std::cerr << "Debug: " << filename(file) << message << std::endl;
-            }
+            if (isEnabled(WarningLogLevel))
+                log("Warning: ", file, line, function, message);
         }
         
-        void warning(const std::string& file, const std::string& message)
+        void error(const char* file, int line, const char* function, const std::string& message)
         {
-            sf::Lock l(g_synchronized);
-            
-            if (g_logLevel >= WarningLogLevel)
-            {
-                std::cerr << "Warning: " << filename(file) << message << std::endl;
-            }
+            if (isEnabled(ErrorLogLevel))
+                log("Error: ", file, line, function, message);
         }
         
-        void error(const std::string& file, const std::string& message)
+        void flush()
         {
-            sf::Lock l(g_synchronized);
-            
-            if (g_logLevel >= ErrorLogLevel)
-            {
-                std::cerr << "Error: " << filename(file) << message << std::endl;
-            }
+            logger().flush();
         }
     }
 }
@@ -25,6 +25,7 @@
 #ifndef SFEMOVIE_LOG_HPP
 #define SFEMOVIE_LOG_HPP
 
+#include <atomic>
 #include <string>
 #include <sstream>
 
@@ -34,9 +35,14 @@
 #define FUNC_NAME __func__
 #endif
 
-#define sfeLogDebug(message) sfe::Log::debug(__FILE__, std::string(":") + sfe::s(__LINE__) + ": " + std::string(FUNC_NAME) + "()" + " - " + message)
-#define sfeLogWarning(message) sfe::Log::warning(__FILE__, std::string(":") + sfe::s(__LINE__) + ": " + std::string(FUNC_NAME) + "()" + " - " + message)
-#define sfeLogError(message) sfe::Log::error(__FILE__, std::string(":") + sfe::s(__LINE__) + ": " + std::string(FUNC_NAME) + "()" + " - " + message)
+// The message is only built when its level is enabled. It is appended to a std::string so that
+// it can be a concatenation starting with string literals
+#define sfeLog(level, function, message) \
+do { if (sfe::Log::isEnabled(sfe::Log::level)) sfe::Log::function(__FILE__, __LINE__, FUNC_NAME, std::string() + message); } while (false)
+
+#define sfeLogDebug(message) sfeLog(DebugLogLevel, debug, message)
+#define sfeLogWarning(message) sfeLog(WarningLogLevel, warning, message)
+#define sfeLogError(message) sfeLog(ErrorLogLevel, error, message)
 
 namespace sfe
 {
@@ -50,7 +56,9 @@ namespace sfe
             DebugLogLevel = 3
         };
         
-        /** Set the initial log level
+        extern std::atomic<int> g_logLevel;
+        
+        /** Set the initial log level and route the FFmpeg messages to the sfeMovie log
          */
         void initialize();
         
@@ -60,23 +68,40 @@ namespace sfe
          */
         void setLogLevel(LogLevel level);
         
+        /** @return true if messages of the given @a level are currently logged
+         */
+        inline bool isEnabled(LogLevel level)
+        {
+            return g_logLevel.load(std::memory_order_relaxed) >= level;
+        }
+        
         /** Log a debug @a message if the currently set mask allows it
          *
+         * Messages are written to the standard error output by a background thread, in the order
+         * they were logged
+         *
+         * @param file the source file that logs the message
+         * @param line the line in @a file that logs the message
+         * @param function the function that logs the message
          * @param message the debug message to log
          */
-        void debug(const std::string& file, const std::string& message);
+        void debug(const char* file, int line, const char* function, const std::string& message);
         
         /** Log a warning @a message if the currently set mask allows it
          *
-         * @param message the warning message to log
+         * @see debug()
          */
-        void warning(const std::string& file, const std::string& message);
+        void warning(const char* file, int line, const char* function, const std::string& message);
         
         /** Log an error @a message if the currently set mask allows it
          *
-         * @param message the error message to log
+         * @see debug()
+         */
+        void error(const char* file, int line, const char* function, const std::string& message);
+        
+        /** Wait until all the messages logged so far have been written
          */
-        void error(const std::string& file, const std::string& message);
+        void flush();
     }
     
     /** Stringify any type of object supported by ostringstream
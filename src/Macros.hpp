@@ -44,6 +44,15 @@ extern "C"
 #define ONCE(sequence)\
 { static bool __done = false; if (!__done) { { sequence; } __done = true; } }
 
+/** Vectorized code paths are only compiled in when the target guarantees SSE2,
+ * a portable scalar version is used otherwise
+ */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SFEMOVIE_HAS_SSE2 1
+#else
+#define SFEMOVIE_HAS_SSE2 0
+#endif
+
 #define BENCH_START \
 { \
 sf::Clock __bench;
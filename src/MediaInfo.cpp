@@ -0,0 +1,109 @@
+
+/*
+ *  MediaInfo.cpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+
+#include <sfeMovie/MediaInfo.hpp>
+#include "Demuxer.hpp"
+#include "Log.hpp"
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+namespace sfe
+{
+    StreamInfo::StreamInfo() :
+    descriptor(StreamDescriptor::NoSelection(Unknown)),
+    codec(),
+    isDecodable(false),
+    bitRate(0),
+    frameSize(0, 0),
+    frameRate(0),
+    sampleRate(0),
+    channelCount(0),
+    channelLayout()
+    {
+    }
+    
+    MediaInfo::MediaInfo() :
+    isValid(false),
+    format(),
+    duration(sf::Time::Zero),
+    bitRate(0),
+    streams()
+    {
+    }
+    
+    MediaInfo probe(const std::string& filename, const OpenOptions& options)
+    {
+        try
+        {
+            return Demuxer::probe(filename, options);
+        }
+        catch (std::runtime_error& e)
+        {
+            sfeLogError("sfe::probe() - " + e.what());
+            return MediaInfo();
+        }
+    }
+    
+    std::vector<MediaInfo> probe(const std::vector<std::string>& filenames, const OpenOptions& options,
+                                 unsigned int threadCount)
+    {
+        std::vector<MediaInfo> results(filenames.size());
+        std::atomic<std::size_t> nextIndex(0);
+        
+        // Probing is mostly waiting for I/O, each thread takes the next file as soon as it is done
+        auto probeNextFiles = [&]()
+        {
+            std::size_t index;
+            
+            while ((index = nextIndex++) < filenames.size())
+                results[index] = probe(filenames[index], options);
+        };
+        
+        if (threadCount == 0)
+            threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+        
+        threadCount = static_cast<unsigned int>(std::min<std::size_t>(threadCount, filenames.size()));
+        
+        if (threadCount <= 1)
+        {
+            probeNextFiles();
+            return results;
+        }
+        
+        // FFmpeg is initialized once, before it is used concurrently
+        Demuxer::getAvailableDemuxers();
+        
+        std::vector<std::thread> threads;
+        for (unsigned int i = 0; i < threadCount; i++)
+            threads.push_back(std::thread(probeNextFiles));
+        
+        for (std::thread& thread : threads)
+            thread.join();
+        
+        return results;
+    }
+}
@@ -0,0 +1,117 @@
+
+/*
+ *  MemoryAccount.cpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#include "MemoryAccount.hpp"
+
+namespace sfe
+{
+    namespace
+    {
+        std::atomic<std::size_t> g_processBytes[MemoryAccount::CategoryCount];
+        std::atomic<std::size_t> g_processTotal(0);
+        std::atomic<std::size_t> g_limit(0);
+        
+        MemoryUsage makeUsage(const std::atomic<std::size_t> bytes[MemoryAccount::CategoryCount])
+        {
+            MemoryUsage usage;
+            usage.videoFrames = bytes[MemoryAccount::VideoFrames];
+            usage.audioSamples = bytes[MemoryAccount::AudioSamples];
+            usage.encodedPackets = bytes[MemoryAccount::EncodedPackets];
+            return usage;
+        }
+    }
+    
+    MemoryUsage::MemoryUsage() :
+    videoFrames(0),
+    audioSamples(0),
+    encodedPackets(0)
+    {
+    }
+    
+    std::size_t MemoryUsage::getTotal() const
+    {
+        return videoFrames + audioSamples + encodedPackets;
+    }
+    
+    namespace MemoryBudget
+    {
+        void setLimit(std::size_t bytes)
+        {
+            g_limit = bytes;
+        }
+        
+        std::size_t getLimit()
+        {
+            return g_limit;
+        }
+        
+        MemoryUsage getUsage()
+        {
+            return makeUsage(g_processBytes);
+        }
+    }
+    
+    MemoryAccount::MemoryAccount()
+    {
+        for (std::atomic<std::size_t>& bytes : m_bytes)
+            bytes = 0;
+    }
+    
+    MemoryAccount::~MemoryAccount()
+    {
+        for (int category = 0; category < CategoryCount; category++)
+            remove(static_cast<Category>(category), m_bytes[category]);
+    }
+    
+    void MemoryAccount::add(Category category, std::size_t bytes)
+    {
+        m_bytes[category] += bytes;
+        g_processBytes[category] += bytes;
+        g_processTotal += bytes;
+    }
+    
+    void MemoryAccount::remove(Category category, std::size_t bytes)
+    {
+        m_bytes[category] -= bytes;
+        g_processBytes[category] -= bytes;
+        g_processTotal -= bytes;
+    }
+    
+    MemoryUsage MemoryAccount::getUsage() const
+    {
+        return makeUsage(m_bytes);
+    }
+    
+    bool MemoryAccount::isOverBudget()
+    {
+        const std::size_t limit = g_limit.load(std::memory_order_relaxed);
+        return limit > 0 && g_processTotal.load(std::memory_order_relaxed) > limit;
+    }
+    
+    bool MemoryAccount::exceedsBudget(std::size_t bytes)
+    {
+        const std::size_t limit = g_limit.load(std::memory_order_relaxed);
+        return limit > 0 && bytes > limit;
+    }
+}
@@ -0,0 +1,89 @@
+
+/*
+ *  MemoryAccount.hpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef SFEMOVIE_MEMORY_ACCOUNT_HPP
+#define SFEMOVIE_MEMORY_ACCOUNT_HPP
+
+#include <sfeMovie/MemoryUsage.hpp>
+#include <atomic>
+#include <cstddef>
+
+namespace sfe
+{
+    /** Counts the bytes of the buffers of one media, and of the whole process for MemoryBudget
+     *
+     * Counting is lock free so that it can be done from the decoding and audio threads
+     */
+    class MemoryAccount
+    {
+    public:
+        enum Category
+        {
+            VideoFrames,
+            AudioSamples,
+            EncodedPackets,
+            CategoryCount
+        };
+        
+        MemoryAccount();
+        
+        /** Remove the bytes that are still counted from the process usage
+         */
+        ~MemoryAccount();
+        
+        /** Count allocated bytes
+         *
+         * @param category the kind of buffer that was allocated
+         * @param bytes the size of the allocation
+         */
+        void add(Category category, std::size_t bytes);
+        
+        /** Count released bytes
+         *
+         * @param category the kind of buffer that was released
+         * @param bytes the size of the released allocation, that was given to add()
+         */
+        void remove(Category category, std::size_t bytes);
+        
+        /** @return the bytes counted by this account
+         */
+        MemoryUsage getUsage() const;
+        
+        /** @return true if all the accounts together exceed the MemoryBudget limit
+         */
+        static bool isOverBudget();
+        
+        /** @return true if the given bytes alone exceed the MemoryBudget limit
+         */
+        static bool exceedsBudget(std::size_t bytes);
+    
+    private:
+        MemoryAccount(const MemoryAccount&);
+        MemoryAccount& operator=(const MemoryAccount&);
+        
+        std::atomic<std::size_t> m_bytes[CategoryCount];
+    };
+}
+
+#endif
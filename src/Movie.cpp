@@ -40,7 +40,12 @@ namespace sfe
     
     bool Movie::openFromFile(const std::string& filename)
     {
-        return m_impl->openFromFile(filename);
+        return m_impl->openFromFile(filename, OpenOptions());
+    }
+    
+    bool Movie::openFromFile(const std::string& filename, const OpenOptions& options)
+    {
+        return m_impl->openFromFile(filename, options);
     }
     
     const Streams& Movie::getStreams(MediaType type) const
@@ -53,6 +58,26 @@ namespace sfe
         return m_impl->selectStream(streamDescriptor);
     }
     
+    bool Movie::addSubtitleFile(const std::string& filename)
+    {
+        return m_impl->addSubtitleFile(filename);
+    }
+    
+    bool Movie::addMixedAudioStream(const StreamDescriptor& streamDescriptor)
+    {
+        return m_impl->addMixedAudioStream(streamDescriptor);
+    }
+    
+    bool Movie::removeMixedAudioStream(const StreamDescriptor& streamDescriptor)
+    {
+        return m_impl->removeMixedAudioStream(streamDescriptor);
+    }
+    
+    bool Movie::setAudioStreamGain(const StreamDescriptor& streamDescriptor, float gain)
+    {
+        return m_impl->setAudioStreamGain(streamDescriptor, gain);
+    }
+    
     void Movie::play()
     {
         m_impl->play();
@@ -76,6 +101,16 @@ namespace sfe
         m_impl->update();
     }
     
+    bool Movie::getTimeUntilNextUpdate(sf::Time& delay) const
+    {
+        return m_impl->getTimeUntilNextUpdate(delay);
+    }
+    
+    bool Movie::hasVisibleChanges() const
+    {
+        return m_impl->hasVisibleChanges();
+    }
+    
     
     void Movie::setVolume(float volume)
     {
@@ -154,6 +189,51 @@ namespace sfe
         return m_impl->getCurrentImage();
     }
     
+    void Movie::addAudioSampleObserver(AudioSampleObserver& observer)
+    {
+        m_impl->addAudioSampleObserver(observer);
+    }
+    
+    
+    void Movie::removeAudioSampleObserver(AudioSampleObserver& observer)
+    {
+        m_impl->removeAudioSampleObserver(observer);
+    }
+    
+    
+    void Movie::enableAudioAnalysis(unsigned int bandCount)
+    {
+        m_impl->enableAudioAnalysis(bandCount);
+    }
+    
+    
+    void Movie::disableAudioAnalysis()
+    {
+        m_impl->disableAudioAnalysis();
+    }
+    
+    
+    bool Movie::getAudioSpectrum(AudioSpectrum& spectrum) const
+    {
+        return m_impl->getAudioSpectrum(spectrum);
+    }
+    
+    PlaybackStats Movie::getPlaybackStats() const
+    {
+        return m_impl->getPlaybackStats();
+    }
+    
+    void Movie::setDecodePriority(int priority)
+    {
+        m_impl->setDecodePriority(priority);
+    }
+    
+    MemoryUsage Movie::getMemoryUsage() const
+    {
+        return m_impl->getMemoryUsage();
+    }
+    
+    
     void Movie::draw(sf::RenderTarget& target, sf::RenderStates states) const
     {
         states.transform *= getTransform();
@@ -24,9 +24,13 @@
 
 #include "MovieImpl.hpp"
 #include "Demuxer.hpp"
+#include "PlaybackClockImpl.hpp"
+#include "SubtitleFile.hpp"
 #include "Timer.hpp"
+#include "TraceSpan.hpp"
 #include "Log.hpp"
 #include "Utilities.hpp"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
@@ -38,32 +42,59 @@ namespace sfe
     m_movieView(movieView),
     m_demuxer(nullptr),
     m_timer(nullptr),
-    m_videoSprite()
+    m_playbackClock(nullptr),
+    m_subtitleFiles(),
+    m_videoSprite(),
+    m_subtitleVertices(sf::Quads),
+    m_subtitleTexture(nullptr),
+    m_subtitlesTransform(),
+    m_decodePriority(0),
+    m_hasPendingChanges(true),
+    m_hasVisibleChanges(true),
+    m_debugger(sf::Color::Red, &m_videoSprite)
     {
     }
     
     MovieImpl::~MovieImpl()
     {
+        // Only stop this movie, not the whole clock
+        if (m_playbackClock)
+            m_playbackClock->detach(*this);
+        
         if (m_timer && m_timer->getStatus() != Stopped)
             stop();
     }
     
-    bool MovieImpl::openFromFile(const std::string& filename)
+    bool MovieImpl::openFromFile(const std::string& filename, const OpenOptions& options)
     {
+        m_subtitleVertices.clear();
+        m_subtitleTexture.reset();
+        m_subtitleFiles.clear();
+        m_hasPendingChanges = true;
+        m_hasVisibleChanges = true;
+        
         try
         {
             m_timer = std::make_shared<Timer>();
-            m_demuxer = std::make_shared<Demuxer>(filename, m_timer, *this, *this);
+            m_demuxer = std::make_shared<Demuxer>(filename, m_timer, *this, *this, options);
+            
+            // Selecting drops the streams that cannot be decoded, describe the remaining ones only
+            m_demuxer->selectFirstAudioStream();
+            m_demuxer->selectFirstVideoStream();
+            
             m_audioStreamsDesc = m_demuxer->computeStreamDescriptors(Audio);
             m_videoStreamsDesc = m_demuxer->computeStreamDescriptors(Video);
             m_subtitleStreamsDesc = m_demuxer->computeStreamDescriptors(Subtitle);
             
             std::set< std::shared_ptr<Stream> > audioStreams = m_demuxer->getStreamsOfType(Audio);
             std::set< std::shared_ptr<Stream> > videoStreams = m_demuxer->getStreamsOfType(Video);
-            std::set< std::shared_ptr<Stream> > subtitleStreams = m_demuxer->getStreamsOfType(Subtitle);
+            setDecodePriority(m_decodePriority);
             
-            m_demuxer->selectFirstAudioStream();
-            m_demuxer->selectFirstVideoStream();
+            for (AudioSampleObserver* observer : m_audioSampleObservers)
+                setAudioSampleObserverRegistered(*observer, true);
+            
+            if (m_audioAnalyzer)
+                setAudioSampleObserverRegistered(*m_audioAnalyzer, true);
             
             if (audioStreams.empty() && videoStreams.empty())
             {
@@ -78,6 +109,9 @@ namespace sfe
                     m_displayFrame = sf::FloatRect(0, 0, size.x, size.y);
                 }
                 
+                if (m_playbackClock)
+                    m_playbackClock->synchronize(*this);
+                
                 return true;
             }
         }
@@ -122,27 +156,180 @@ namespace sfe
             streamToSelect = it->second;
         }
         
-        switch (streamDescriptor.type)
+        // Decoders are loaded when their stream gets selected, which may fail
+        m_hasPendingChanges = true;
+        
+        try
         {
-            case Audio:
-                m_demuxer->selectAudioStream(std::dynamic_pointer_cast<AudioStream>(streamToSelect));
-                return true;
-            case Video:
-                m_demuxer->selectVideoStream(std::dynamic_pointer_cast<VideoStream>(streamToSelect));
-                return true;
-            case Subtitle:
-                m_demuxer->selectSubtitleStream(std::dynamic_pointer_cast<SubtitleStream>(streamToSelect));
-                return true;
-            default:
-                sfeLogWarning("Movie::selectStream() - stream activation for stream of kind "
-                              + mediaTypeToString(it->second->getStreamKind()) + " is not supported");
-                return false;
+            switch (streamDescriptor.type)
+            {
+                case Audio:
+                    m_demuxer->selectAudioStream(std::dynamic_pointer_cast<AudioStream>(streamToSelect));
+                    return true;
+                case Video:
+                {
+                    std::shared_ptr<VideoStream> previousStream = m_demuxer->getSelectedVideoStream();
+                    m_demuxer->selectVideoStream(std::dynamic_pointer_cast<VideoStream>(streamToSelect));
+                    
+                    // The texture of the previous stream got released, stop drawing it
+                    if (previousStream && previousStream != streamToSelect)
+                    {
+                        m_videoSprite.setTextureRect(sf::IntRect());
+                        m_hasVisibleChanges = true;
+                    }
+                    
+                    return true;
+                }
+                case Subtitle:
+                {
+                    std::shared_ptr<SubtitleStream> previousStream = getSelectedSubtitleStream();
+                    
+                    for (std::pair<const int, std::shared_ptr<SubtitleFile> >& pair : m_subtitleFiles)
+                        pair.second->setSelected(pair.first == streamDescriptor.identifier);
+                    
+                    m_demuxer->selectSubtitleStream(std::dynamic_pointer_cast<SubtitleStream>(streamToSelect));
+                    
+                    // The previous stream is not updated anymore, so it won't wipe out its subtitles
+                    if (previousStream && previousStream != getSelectedSubtitleStream())
+                    {
+                        m_subtitleVertices.clear();
+                        m_hasVisibleChanges = true;
+                    }
+                    
+                    return true;
+                }
+                default:
+                    sfeLogWarning("Movie::selectStream() - stream activation for stream of kind "
+                                  + mediaTypeToString(it->second->getStreamKind()) + " is not supported");
+                    return false;
+            }
+        }
+        catch (std::runtime_error& e)
+        {
+            sfeLogError("Movie::selectStream() - " + e.what());
+            return false;
+        }
+    }
+    
+    bool MovieImpl::addSubtitleFile(const std::string& filename)
+    {
+        if (!m_demuxer || !m_timer)
+        {
+            sfeLogError("Movie::addSubtitleFile() - cannot add subtitles with no opened media");
+            return false;
+        }
+        
+        // Identifiers follow the ones of the media streams
+        const std::map<int, std::shared_ptr<Stream> >& streams = m_demuxer->getStreams();
+        int identifier = streams.empty() ? 0 : streams.rbegin()->first + 1;
+        if (!m_subtitleFiles.empty())
+            identifier = std::max(identifier, m_subtitleFiles.rbegin()->first + 1);
+        
+        try
+        {
+            std::shared_ptr<SubtitleFile> subtitleFile = std::make_shared<SubtitleFile>(filename, m_timer, *this);
+            std::shared_ptr<VideoStream> videoStream = m_demuxer->getSelectedVideoStream();
+            
+            if (videoStream)
+            {
+                sf::Vector2i frameSize = videoStream->getFrameSize();
+                subtitleFile->setRenderingFrame(frameSize.x, frameSize.y);
+            }
+            
+            m_subtitleFiles[identifier] = subtitleFile;
+            m_hasPendingChanges = true;
+        }
+        catch (std::runtime_error& e)
+        {
+            sfeLogError(e.what());
+            return false;
+        }
+        
+        StreamDescriptor descriptor;
+        descriptor.type = Subtitle;
+        descriptor.identifier = identifier;
+        m_subtitleStreamsDesc.push_back(descriptor);
+        
+        return true;
+    }
+    
+    bool MovieImpl::addMixedAudioStream(const StreamDescriptor& streamDescriptor)
+    {
+        if (!m_demuxer || !m_timer)
+        {
+            sfeLogError("Movie::addMixedAudioStream() - cannot mix a stream with no opened media");
+            return false;
+        }
+        
+        if (m_timer->getStatus() != Stopped)
+        {
+            sfeLogError("Movie::addMixedAudioStream() - cannot mix a stream while media is not stopped");
+            return false;
+        }
+        
+        std::shared_ptr<AudioStream> stream = findAudioStream(streamDescriptor);
+        
+        if (!stream || stream == m_demuxer->getSelectedAudioStream() || !m_demuxer->getSelectedAudioStream())
+        {
+            sfeLogError("Movie::addMixedAudioStream() - the stream must be an audio stream other than "
+                        "the active one, and an audio stream must be active");
+            return false;
+        }
+        
+        m_demuxer->addMixedAudioStream(stream);
+        m_hasPendingChanges = true;
+        return true;
+    }
+    
+    bool MovieImpl::removeMixedAudioStream(const StreamDescriptor& streamDescriptor)
+    {
+        if (!m_demuxer || !m_timer)
+        {
+            sfeLogError("Movie::removeMixedAudioStream() - cannot unmix a stream with no opened media");
+            return false;
+        }
+        
+        if (m_timer->getStatus() != Stopped)
+        {
+            sfeLogError("Movie::removeMixedAudioStream() - cannot unmix a stream while media is not stopped");
+            return false;
         }
+        
+        std::shared_ptr<AudioStream> stream = findAudioStream(streamDescriptor);
+        std::vector<std::shared_ptr<AudioStream> > mixedStreams = m_demuxer->getMixedAudioStreams();
+        
+        if (std::find(mixedStreams.begin(), mixedStreams.end(), stream) == mixedStreams.end())
+        {
+            sfeLogError("Movie::removeMixedAudioStream() - the stream is not mixed");
+            return false;
+        }
+        
+        m_demuxer->removeMixedAudioStream(stream);
+        m_hasPendingChanges = true;
+        return true;
+    }
+    
+    bool MovieImpl::setAudioStreamGain(const StreamDescriptor& streamDescriptor, float gain)
+    {
+        std::shared_ptr<AudioStream> stream = findAudioStream(streamDescriptor);
+        
+        if (!stream)
+        {
+            sfeLogError("Movie::setAudioStreamGain() - invalid audio stream");
+            return false;
+        }
+        
+        stream->setGain(gain);
+        return true;
     }
     
     void MovieImpl::play()
     {
-        if (m_demuxer && m_timer)
+        if (m_demuxer && m_timer && m_playbackClock)
+        {
+            m_playbackClock->play();
+        }
+        else if (m_demuxer && m_timer)
         {
             if (m_timer->getStatus() == Playing)
             {
@@ -161,7 +348,11 @@ namespace sfe
     
     void MovieImpl::pause()
     {
-        if (m_demuxer && m_timer)
+        if (m_demuxer && m_timer && m_playbackClock)
+        {
+            m_playbackClock->pause();
+        }
+        else if (m_demuxer && m_timer)
         {
             if (m_timer->getStatus() == Paused)
             {
@@ -170,6 +361,7 @@ namespace sfe
             }
             
             m_timer->pause();
+            m_hasPendingChanges = true;
             update();
         }
         else
@@ -180,7 +372,11 @@ namespace sfe
     
     void MovieImpl::stop()
     {
-        if (m_demuxer && m_timer)
+        if (m_demuxer && m_timer && m_playbackClock)
+        {
+            m_playbackClock->stop();
+        }
+        else if (m_demuxer && m_timer)
         {
             if (m_timer->getStatus() == Stopped)
             {
@@ -189,12 +385,9 @@ namespace sfe
             }
             
             m_timer->stop();
+            preloadVideo();
+            m_hasPendingChanges = true;
             update();
-            
-            std::shared_ptr<VideoStream> videoStream(m_demuxer->getSelectedVideoStream());
-            
-            if (videoStream)
-                videoStream->preload();
         }
         else
         {
@@ -204,34 +397,30 @@ namespace sfe
     
     void MovieImpl::update()
     {
+        SFE_TRACE_THREAD_NAME("sfeMovie update");
+        SFE_TRACE_SCOPE("Movie::update");
+        
         if (m_demuxer && m_timer)
         {
+            // Paused and stopped movies have nothing to update until something changes their state
+            sf::Time delay;
+            if (m_timer->getStatus() != Playing && !m_hasPendingChanges && !getTimeUntilNextUpdate(delay))
+                return;
+            
+            m_hasPendingChanges = false;
+            
+            for (std::pair<const int, std::shared_ptr<SubtitleFile> >& pair : m_subtitleFiles)
+                pair.second->update();
+            
             m_demuxer->update();
             
+            if (m_audioAnalyzer)
+                m_audioAnalyzer->setPlaybackPosition(m_timer->getOffset());
+            
             if (getStatus() == Stopped && m_timer->getStatus() != Stopped)
             {
                 m_timer->stop();
             }
-            
-            // Enable smoothing when the video is scaled
-            std::shared_ptr<VideoStream> vStream = m_demuxer->getSelectedVideoStream();
-            if (vStream)
-            {
-                sf::Vector2f movieScale = m_movieView.getScale();
-                sf::Vector2f subviewScale = m_videoSprite.getScale();
-                
-                if (std::fabs(movieScale.x - 1.f) < 0.00001 &&
-                    std::fabs(movieScale.y - 1.f) < 0.00001 &&
-                    std::fabs(subviewScale.x - 1.f) < 0.00001 &&
-                    std::fabs(subviewScale.y - 1.f) < 0.00001)
-                {
-                    vStream->getVideoTexture().setSmooth(false);
-                }
-                else
-                {
-                    vStream->getVideoTexture().setSmooth(true);
-                }
-            }
         }
         else
         {
@@ -239,6 +428,31 @@ namespace sfe
         }
     }
     
+    bool MovieImpl::getTimeUntilNextUpdate(sf::Time& delay) const
+    {
+        if (!m_demuxer || !m_timer)
+            return false;
+        
+        bool isScheduled = m_demuxer->getTimeUntilNextUpdate(delay);
+        
+        for (const std::pair<const int, std::shared_ptr<SubtitleFile> >& pair : m_subtitleFiles)
+        {
+            sf::Time fileDelay;
+            if (pair.second->getTimeUntilNextUpdate(fileDelay) && (!isScheduled || fileDelay < delay))
+            {
+                delay = fileDelay;
+                isScheduled = true;
+            }
+        }
+        
+        return isScheduled;
+    }
+    
+    bool MovieImpl::hasVisibleChanges() const
+    {
+        return m_hasVisibleChanges;
+    }
+    
     void MovieImpl::setVolume(float volume)
     {
         if (m_demuxer && m_timer)
@@ -345,26 +559,9 @@ namespace sfe
         m_movieView.setPosition(frame.left, frame.top);
         m_videoSprite.setScale((float)new_size.x / movie_size.x, (float)new_size.y / movie_size.y);
         m_displayFrame = frame;
+        m_hasVisibleChanges = true;
         
-        sf::Vector2f subtitlesCenter(m_displayFrame.left + m_displayFrame.width / 2,
-                                     m_displayFrame.top + m_displayFrame.height * 0.9f);
-        
-        for (sf::Sprite& subtitleSprite : m_subtitleSprites)
-        {
-            const sf::Vector2u& subSize = subtitleSprite.getTexture()->getSize();
-            subtitleSprite.setPosition(subtitlesCenter.x - (subSize.x * m_videoSprite.getScale().x / 2),
-                                       subtitlesCenter.y - (subSize.y * m_videoSprite.getScale().y / 2));
-            subtitleSprite.setScale(m_videoSprite.getScale().x, m_videoSprite.getScale().y);
-            
-            const float bottom = subtitleSprite.getPosition().y +
-                subtitleSprite.getLocalBounds().height * m_videoSprite.getScale().x;
-            if (bottom > m_displayFrame.height)
-            {
-                subtitleSprite.setPosition(subtitleSprite.getPosition().x,
-                                           m_displayFrame.height - subtitleSprite.getLocalBounds().height *
-                                           m_videoSprite.getScale().y -10);
-            }
-        }
+        updateSubtitlesTransform();
     }
     
     float MovieImpl::getFramerate() const
@@ -447,7 +644,11 @@ namespace sfe
     {
         bool seekingResult = false;
         
-        if (m_demuxer && m_timer)
+        if (m_demuxer && m_timer && m_playbackClock)
+        {
+            seekingResult = m_playbackClock->seek(targetSeekTime);
+        }
+        else if (m_demuxer && m_timer)
         {
             if (targetSeekTime < sf::Time::Zero || targetSeekTime >= getDuration())
             {
@@ -456,9 +657,13 @@ namespace sfe
             else
             {
                 seekingResult = m_timer->seek(targetSeekTime);
+                m_hasPendingChanges = true;
                 
+                // The new image is uploaded by updating
                 if (m_timer->getStatus() == Status::Stopped)
                     pause();
+                else
+                    update();
             }
         }
         else
@@ -483,71 +688,271 @@ namespace sfe
         }
     }
     
+    void MovieImpl::addAudioSampleObserver(AudioSampleObserver& observer)
+    {
+        if (m_audioSampleObservers.insert(&observer).second && m_demuxer)
+            setAudioSampleObserverRegistered(observer, true);
+    }
+    
+    void MovieImpl::removeAudioSampleObserver(AudioSampleObserver& observer)
+    {
+        if (m_audioSampleObservers.erase(&observer) && m_demuxer)
+            setAudioSampleObserverRegistered(observer, false);
+    }
+    
+    void MovieImpl::enableAudioAnalysis(unsigned int bandCount)
+    {
+        if (bandCount == 0)
+        {
+            sfeLogError("Movie::enableAudioAnalysis() - at least one frequency band is needed");
+            return;
+        }
+        
+        disableAudioAnalysis();
+        m_audioAnalyzer = std::make_shared<AudioAnalyzer>(bandCount);
+        
+        if (m_demuxer)
+            setAudioSampleObserverRegistered(*m_audioAnalyzer, true);
+    }
+    
+    void MovieImpl::disableAudioAnalysis()
+    {
+        if (m_audioAnalyzer)
+        {
+            if (m_demuxer)
+                setAudioSampleObserverRegistered(*m_audioAnalyzer, false);
+            
+            m_audioAnalyzer.reset();
+        }
+    }
+    
+    bool MovieImpl::getAudioSpectrum(AudioSpectrum& spectrum) const
+    {
+        if (!m_audioAnalyzer)
+            return false;
+        
+        if (m_timer)
+            m_audioAnalyzer->setPlaybackPosition(m_timer->getOffset());
+        
+        return m_audioAnalyzer->getSpectrum(spectrum);
+    }
+    
+    PlaybackStats MovieImpl::getPlaybackStats() const
+    {
+        PlaybackStats stats;
+        
+        if (m_demuxer)
+        {
+            for (std::shared_ptr<Stream> stream : m_demuxer->getSelectedStreams())
+                stats.streams.push_back(stream->getStats());
+        }
+        
+        for (const std::pair<const int, std::shared_ptr<SubtitleFile> >& pair : m_subtitleFiles)
+        {
+            std::shared_ptr<SubtitleStream> stream = pair.second->getStream();
+            
+            if (pair.second->isSelected() && stream)
+            {
+                stats.streams.push_back(stream->getStats());
+                stats.streams.back().stream.identifier = pair.first;
+            }
+        }
+        
+        return stats;
+    }
+    
+    void MovieImpl::setDecodePriority(int priority)
+    {
+        m_decodePriority = priority;
+        
+        if (m_demuxer)
+        {
+            for (std::shared_ptr<Stream> stream : m_demuxer->getStreamsOfType(Video))
+                std::static_pointer_cast<VideoStream>(stream)->setDecodePriority(priority);
+        }
+    }
+    
+    MemoryUsage MovieImpl::getMemoryUsage() const
+    {
+        MemoryUsage usage;
+        
+        if (m_demuxer)
+            usage = m_demuxer->getMemoryUsage();
+        
+        for (const std::pair<const int, std::shared_ptr<SubtitleFile> >& pair : m_subtitleFiles)
+        {
+            MemoryUsage fileUsage = pair.second->getMemoryUsage();
+            usage.videoFrames += fileUsage.videoFrames;
+            usage.audioSamples += fileUsage.audioSamples;
+            usage.encodedPackets += fileUsage.encodedPackets;
+        }
+        
+        return usage;
+    }
+    
+    void MovieImpl::setAudioSampleObserverRegistered(AudioSampleObserver& observer, bool registered)
+    {
+        std::set< std::shared_ptr<Stream> > audioStreams = m_demuxer->getStreamsOfType(Audio);
+        
+        for (std::shared_ptr<Stream> stream : audioStreams)
+        {
+            std::shared_ptr<AudioStream> audioStream = std::dynamic_pointer_cast<AudioStream>(stream);
+            
+            if (registered)
+                audioStream->addSampleObserver(observer);
+            else
+                audioStream->removeSampleObserver(observer);
+        }
+    }
+    
+    std::shared_ptr<AudioStream> MovieImpl::findAudioStream(const StreamDescriptor& streamDescriptor) const
+    {
+        if (!m_demuxer || streamDescriptor.type != Audio)
+            return nullptr;
+        
+        const std::map<int, std::shared_ptr<Stream> >& streams = m_demuxer->getStreams();
+        std::map<int, std::shared_ptr<Stream> >::const_iterator it = streams.find(streamDescriptor.identifier);
+        
+        if (it == streams.end())
+            return nullptr;
+        
+        return std::dynamic_pointer_cast<AudioStream>(it->second);
+    }
+    
+    std::shared_ptr<SubtitleStream> MovieImpl::getSelectedSubtitleStream() const
+    {
+        for (const std::pair<const int, std::shared_ptr<SubtitleFile> >& pair : m_subtitleFiles)
+        {
+            if (pair.second->isSelected())
+                return pair.second->getStream();
+        }
+        
+        return m_demuxer->getSelectedSubtitleStream();
+    }
+    
+    void MovieImpl::setPlaybackClock(PlaybackClockImpl* clock)
+    {
+        m_playbackClock = clock;
+    }
+    
+    PlaybackClockImpl* MovieImpl::getPlaybackClock() const
+    {
+        return m_playbackClock;
+    }
+    
+    std::shared_ptr<Timer> MovieImpl::getTimer() const
+    {
+        return m_demuxer ? m_timer : nullptr;
+    }
+    
+    sf::Time MovieImpl::getPresentationLateness() const
+    {
+        std::shared_ptr<VideoStream> videoStream = m_demuxer ? m_demuxer->getSelectedVideoStream() : nullptr;
+        
+        if (!videoStream || videoStream->getStatus() != Playing)
+            return sf::Time::Zero;
+        
+        return videoStream->getPresentationLateness();
+    }
+    
+    void MovieImpl::preloadVideo()
+    {
+        std::shared_ptr<VideoStream> videoStream(m_demuxer->getSelectedVideoStream());
+        
+        if (videoStream)
+            videoStream->preload();
+    }
+    
+    void MovieImpl::didChangeTimerState()
+    {
+        m_hasPendingChanges = true;
+        update();
+    }
+    
     void MovieImpl::draw(sf::RenderTarget& target, sf::RenderStates states) const
     {
+        updateSmoothing();
         target.draw(m_videoSprite, states);
-        for (const sf::Sprite& sprite : m_subtitleSprites)
+        
+        if (m_subtitleVertices.getVertexCount() > 0)
         {
-            target.draw(sprite, states);
+            sf::RenderStates subtitleStates(states);
+            subtitleStates.transform *= m_subtitlesTransform;
+            subtitleStates.texture = m_subtitleTexture.get();
+            subtitleStates.blendMode = SubtitleAtlas::getBlendMode();
+            target.draw(m_subtitleVertices, subtitleStates);
         }
-        
+
 #if LAYOUT_DEBUGGER_ENABLED
         target.draw(m_debugger, states);
 #endif
+        
+        m_hasVisibleChanges = false;
     }
     
     void MovieImpl::didUpdateVideo(const VideoStream& sender, const sf::Texture& image)
     {
-        if (m_videoSprite.getTexture() != &image)
-            m_videoSprite.setTexture(image);
+        // The texture rect is emptied when the texture of a deselected stream is released
+        if (m_videoSprite.getTexture() != &image || m_videoSprite.getTextureRect() == sf::IntRect())
+            m_videoSprite.setTexture(image, true);
+        
+        m_hasVisibleChanges = true;
+    }
+    
+    void MovieImpl::didUpdateSubtitle(const SubtitleStream& sender, const sf::VertexArray& vertices,
+                                      std::shared_ptr<const sf::Texture> texture)
+    {
+        m_subtitleVertices = vertices;
+        m_subtitleTexture = texture;
+        m_hasVisibleChanges = true;
+        updateSubtitlesTransform();
+    }
+    
+    void MovieImpl::didWipeOutSubtitles(const SubtitleStream& sender)
+    {
+        m_subtitleVertices.clear();
+        m_hasVisibleChanges = true;
+    }
+    
+    void MovieImpl::updateSubtitlesTransform()
+    {
+        const sf::Vector2f& position = m_videoSprite.getPosition();
+        const sf::Vector2f& scale = m_videoSprite.getScale();
+        
+        m_subtitlesTransform = sf::Transform::Identity;
+        m_subtitlesTransform.translate(position).scale(scale.x, scale.y);
+        
+        const sf::FloatRect bounds = m_subtitlesTransform.transformRect(m_subtitleVertices.getBounds());
+        const float bottom = bounds.top + bounds.height;
+        
+        if (bottom > m_displayFrame.height)
+        {
+            const float offset = m_displayFrame.height - bottom - 10;
+            m_subtitlesTransform = sf::Transform::Identity;
+            m_subtitlesTransform.translate(position.x, position.y + offset).scale(scale.x, scale.y);
+        }
     }
     
-    void MovieImpl::didUpdateSubtitle(const SubtitleStream& sender, const std::list<sf::Sprite>& subs, const std::list<sf::Vector2i>& positions)
+    void MovieImpl::updateSmoothing() const
     {
-        m_subtitleSprites = subs;
-        bool use_position = !positions.empty();
-        sf::Vector2f subtitlesCenter(m_displayFrame.left + m_displayFrame.width / 2,
-                                     m_displayFrame.top + m_displayFrame.height * 0.9f);
-        std::list<sf::Vector2i>::const_iterator pos_it = positions.begin();
+        std::shared_ptr<VideoStream> vStream = m_demuxer ? m_demuxer->getSelectedVideoStream() : nullptr;
         
-        for (sf::Sprite& subtitleSprite : m_subtitleSprites)
+        if (vStream)
         {
-            const sf::Vector2u& subSize = subtitleSprite.getTexture()->getSize();
+            sf::Vector2f movieScale = m_movieView.getScale();
+            sf::Vector2f subviewScale = m_videoSprite.getScale();
             
-            if (use_position)
+            if (std::fabs(movieScale.x - 1.f) < 0.00001 &&
+                std::fabs(movieScale.y - 1.f) < 0.00001 &&
+                std::fabs(subviewScale.x - 1.f) < 0.00001 &&
+                std::fabs(subviewScale.y - 1.f) < 0.00001)
             {
-                sf::Vector2i pos = *pos_it;
-                subtitleSprite.setPosition(m_videoSprite.getPosition().x + pos.x * m_videoSprite.getScale().x,
-                                           m_videoSprite.getPosition().y + pos.y * m_videoSprite.getScale().y);
-                ++pos_it;
+                vStream->getVideoTexture().setSmooth(false);
             }
             else
             {
-                subtitleSprite.setPosition(subtitlesCenter.x - (subSize.x * m_videoSprite.getScale().x / 2),
-                                           subtitlesCenter.y - (subSize.y * m_videoSprite.getScale().y / 2));
+                vStream->getVideoTexture().setSmooth(true);
             }
-            
-            subtitleSprite.setScale(m_videoSprite.getScale().x, m_videoSprite.getScale().y);
-            
-            const float bottom = subtitleSprite.getPosition().y +
-                subtitleSprite.getLocalBounds().height * m_videoSprite.getScale().y;
-            if (bottom > m_displayFrame.height)
-            {
-                subtitleSprite.setPosition(subtitleSprite.getPosition().x,
-                                           m_displayFrame.height - subtitleSprite.getLocalBounds().height *
-                                           m_videoSprite.getScale().y - 10);
-            }
-            
-            m_debugger.bind(&subtitleSprite);
         }
-        
-        if (m_subtitleSprites.empty())
-            m_debugger.bind(nullptr);
-    }
-    
-    void MovieImpl::didWipeOutSubtitles(const SubtitleStream& sender)
-    {
-        //if (m_subtitleSprites.size()>0) // disable this "fix" for now to let the bug appear
-            m_subtitleSprites.clear();
     }
 }
@@ -32,11 +32,16 @@
 #include <SFML/Config.hpp>
 #include "VideoStream.hpp"
 #include "SubtitleStream.hpp"
+#include "AudioAnalyzer.hpp"
 #include "DebugTools/LayoutDebugger.hpp"
 
 namespace sfe
 {
+    class AudioStream;
     class Demuxer;
+    class PlaybackClockImpl;
+    class SubtitleFile;
+    class Timer;
     
     class MovieImpl : public VideoStream::Delegate, public SubtitleStream::Delegate, public sf::Drawable
     {
@@ -46,7 +51,7 @@ namespace sfe
         
         /** @see Movie::openFromFile()
          */
-        bool openFromFile(const std::string& filename);
+        bool openFromFile(const std::string& filename, const OpenOptions& options);
         
         
         /** @see Movie::getStreams()
@@ -57,6 +62,22 @@ namespace sfe
          */
         bool selectStream(const StreamDescriptor& streamDescriptor);
         
+        /** @see Movie::addSubtitleFile()
+         */
+        bool addSubtitleFile(const std::string& filename);
+        
+        /** @see Movie::addMixedAudioStream()
+         */
+        bool addMixedAudioStream(const StreamDescriptor& streamDescriptor);
+        
+        /** @see Movie::removeMixedAudioStream()
+         */
+        bool removeMixedAudioStream(const StreamDescriptor& streamDescriptor);
+        
+        /** @see Movie::setAudioStreamGain()
+         */
+        bool setAudioStreamGain(const StreamDescriptor& streamDescriptor, float gain);
+        
         /** @see Movie::play()
          */
         void play();
@@ -76,6 +97,14 @@ namespace sfe
          */
         void update();
         
+        /** @see Movie::getTimeUntilNextUpdate()
+         */
+        bool getTimeUntilNextUpdate(sf::Time& delay) const;
+        
+        /** @see Movie::hasVisibleChanges()
+         */
+        bool hasVisibleChanges() const;
+        
         
         /** @see Movie::setVolume()
          */
@@ -139,23 +168,119 @@ namespace sfe
          */
         const sf::Texture& getCurrentImage() const;
         
+        /** @see Movie::addAudioSampleObserver()
+         */
+        void addAudioSampleObserver(AudioSampleObserver& observer);
+        
+        /** @see Movie::removeAudioSampleObserver()
+         */
+        void removeAudioSampleObserver(AudioSampleObserver& observer);
+        
+        /** @see Movie::enableAudioAnalysis()
+         */
+        void enableAudioAnalysis(unsigned int bandCount);
+        
+        /** @see Movie::disableAudioAnalysis()
+         */
+        void disableAudioAnalysis();
+        
+        /** @see Movie::getAudioSpectrum()
+         */
+        bool getAudioSpectrum(AudioSpectrum& spectrum) const;
+        
+        /** @see Movie::getPlaybackStats()
+         */
+        PlaybackStats getPlaybackStats() const;
+        
+        /** @see Movie::setDecodePriority()
+         */
+        void setDecodePriority(int priority);
+        
+        /** @see Movie::getMemoryUsage()
+         */
+        MemoryUsage getMemoryUsage() const;
+        
+        /** Attach the movie to a playback clock, or detach it with nullptr
+         *
+         * Once attached, the playback controls of the movie are forwarded to the clock
+         */
+        void setPlaybackClock(PlaybackClockImpl* clock);
+        
+        /** @return the playback clock the movie is attached to, or nullptr
+         */
+        PlaybackClockImpl* getPlaybackClock() const;
+        
+        /** @return the timer of the opened media, or nullptr if no media is opened
+         */
+        std::shared_ptr<Timer> getTimer() const;
+        
+        /** @see VideoStream::getPresentationLateness(), zero if the movie has no video or isn't playing
+         */
+        sf::Time getPresentationLateness() const;
+        
+        /** Decode the first image of the selected video stream once the movie is stopped
+         */
+        void preloadVideo();
+        
+        /** Take into account a change of the timer status or position made by the playback clock
+         */
+        void didChangeTimerState();
+        
         void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
         void didUpdateVideo(const VideoStream& sender, const sf::Texture& image) override;
         void didUpdateSubtitle(const SubtitleStream& sender,
-                               const std::list<sf::Sprite>& sprites,
-                               const std::list<sf::Vector2i>& positions) override;
+                               const sf::VertexArray& vertices,
+                               std::shared_ptr<const sf::Texture> texture) override;
         void didWipeOutSubtitles(const SubtitleStream& sender) override;
         
     private:
+        /** Register or unregister @a observer on all the audio streams of the opened media
+         */
+        void setAudioSampleObserverRegistered(AudioSampleObserver& observer, bool registered);
+        
+        /** @return the audio stream described by @a streamDescriptor, or nullptr if there is none
+         */
+        std::shared_ptr<AudioStream> findAudioStream(const StreamDescriptor& streamDescriptor) const;
+        
+        /** @return the selected subtitle stream, from the media or from a subtitle file, or nullptr
+         */
+        std::shared_ptr<SubtitleStream> getSelectedSubtitleStream() const;
+        
+        /** Place the subtitles over the displayed video frame, they're kept in the display frame
+         */
+        void updateSubtitlesTransform();
+        
+        /** Smooth the video texture when the video is scaled
+         */
+        void updateSmoothing() const;
+        
         sf::Transformable& m_movieView;
+        
+        // Declared before the demuxer so that they outlive the audio streams that notify them
+        std::set<AudioSampleObserver*> m_audioSampleObservers;
+        std::shared_ptr<AudioAnalyzer> m_audioAnalyzer;
+        
         std::shared_ptr<Demuxer> m_demuxer;
         std::shared_ptr<Timer> m_timer;
+        PlaybackClockImpl* m_playbackClock;
+        
+        // By stream identifier, declared after the timer that they observe
+        std::map<int, std::shared_ptr<SubtitleFile> > m_subtitleFiles;
         sf::Sprite m_videoSprite;
-        std::list<sf::Sprite> m_subtitleSprites;
+        sf::VertexArray m_subtitleVertices;
+        std::shared_ptr<const sf::Texture> m_subtitleTexture;
+        sf::Transform m_subtitlesTransform;
         Streams m_audioStreamsDesc;
         Streams m_videoStreamsDesc;
         Streams m_subtitleStreamsDesc;
         sf::FloatRect m_displayFrame;
+        int m_decodePriority;
+        
+        // Set when the state changed while not playing, so that the next update takes it into account
+        bool m_hasPendingChanges;
+        
+        // Set when the displayed image or subtitles changed, cleared when drawing
+        mutable bool m_hasVisibleChanges;
         LayoutDebugger<sf::Sprite> m_debugger;
     };
     
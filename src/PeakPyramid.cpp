@@ -0,0 +1,213 @@
+
+/*
+ *  PeakPyramid.cpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+
+#include "PeakPyramid.hpp"
+#include "AudioKernels.hpp"
+#include "Macros.hpp"
+#include <algorithm>
+
+namespace sfe
+{
+    bool PeakPyramid::Peak::isEmpty() const
+    {
+        return minimum > maximum;
+    }
+    
+    void PeakPyramid::Peak::merge(const Peak& other)
+    {
+        minimum = std::min(minimum, other.minimum);
+        maximum = std::max(maximum, other.maximum);
+    }
+    
+    PeakPyramid::Peak PeakPyramid::Peak::empty()
+    {
+        Peak peak;
+        peak.minimum = 32767;
+        peak.maximum = -32768;
+        return peak;
+    }
+    
+    PeakPyramid::PeakPyramid(sf::Int64 frameCount, unsigned int framesPerPeak) :
+    m_framesPerPeak(framesPerPeak),
+    m_frameCount(0),
+    m_levels()
+    {
+        CHECK(framesPerPeak > 0, "PeakPyramid::PeakPyramid() - invalid argument: framesPerPeak");
+        resize(std::max<sf::Int64>(frameCount, 1));
+    }
+    
+    void PeakPyramid::addSamples(sf::Int64 firstFrame, const sf::Int16* samples, std::size_t frameCount,
+                                 unsigned int channelCount)
+    {
+        CHECK(firstFrame >= 0, "PeakPyramid::addSamples() - invalid argument: firstFrame");
+        
+        if (frameCount == 0 || channelCount == 0)
+            return;
+        
+        // Summarize the samples before locking, so that concurrent decoders don't wait for each other
+        const sf::Int64 endFrame = firstFrame + frameCount;
+        const std::size_t firstPeak = static_cast<std::size_t>(firstFrame / m_framesPerPeak);
+        const std::size_t lastPeak = static_cast<std::size_t>((endFrame - 1) / m_framesPerPeak);
+        std::vector<Peak> newPeaks(lastPeak - firstPeak + 1, Peak::empty());
+        
+        for (std::size_t i = 0; i < newPeaks.size(); i++)
+        {
+            const sf::Int64 peakBegin = static_cast<sf::Int64>(firstPeak + i) * m_framesPerPeak;
+            const sf::Int64 begin = std::max(firstFrame, peakBegin);
+            const sf::Int64 end = std::min(endFrame, peakBegin + m_framesPerPeak);
+            
+            AudioKernels::accumulateMinMax(samples + (begin - firstFrame) * channelCount,
+                                           static_cast<std::size_t>(end - begin) * channelCount,
+                                           newPeaks[i].minimum, newPeaks[i].maximum);
+        }
+        
+        std::lock_guard<std::mutex> lock(m_mutex);
+        
+        if (endFrame > m_frameCount)
+            resize(endFrame);
+        
+        for (std::size_t i = 0; i < newPeaks.size(); i++)
+            m_levels[0][firstPeak + i].merge(newPeaks[i]);
+        
+        propagate(firstPeak, lastPeak);
+    }
+    
+    void PeakPyramid::getPeaks(sf::Int64 beginFrame, sf::Int64 endFrame, std::size_t peakCount,
+                               std::vector<Peak>& peaks) const
+    {
+        peaks.assign(peakCount, Peak::empty());
+        
+        if (peakCount == 0 || endFrame <= beginFrame)
+            return;
+        
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const double sliceLength = static_cast<double>(endFrame - beginFrame) / peakCount;
+        
+        for (std::size_t i = 0; i < peakCount; i++)
+        {
+            const sf::Int64 sliceBegin = std::max<sf::Int64>(beginFrame + static_cast<sf::Int64>(i * sliceLength), 0);
+            const sf::Int64 sliceEnd = std::max(beginFrame + static_cast<sf::Int64>((i + 1) * sliceLength),
+                                                sliceBegin + 1);
+            
+            if (sliceBegin >= m_frameCount)
+                break;
+            
+            sf::Int64 firstPeak = sliceBegin / m_framesPerPeak;
+            sf::Int64 lastPeak = std::min<sf::Int64>((sliceEnd - 1) / m_framesPerPeak, m_levels[0].size() - 1);
+            
+            // Climb the levels: peaks at the edges of the range are read at the current level,
+            // the aligned middle part is read from the coarser levels
+            for (std::size_t level = 0; level < m_levels.size() && firstPeak <= lastPeak; level++)
+            {
+                const std::vector<Peak>& levelPeaks = m_levels[level];
+                
+                if (level + 1 == m_levels.size())
+                {
+                    for (sf::Int64 j = firstPeak; j <= lastPeak; j++)
+                        peaks[i].merge(levelPeaks[static_cast<std::size_t>(j)]);
+                    break;
+                }
+                
+                while (firstPeak <= lastPeak && firstPeak % LevelFactor != 0)
+                    peaks[i].merge(levelPeaks[static_cast<std::size_t>(firstPeak++)]);
+                
+                while (firstPeak <= lastPeak && (lastPeak + 1) % LevelFactor != 0)
+                    peaks[i].merge(levelPeaks[static_cast<std::size_t>(lastPeak--)]);
+                
+                if (firstPeak > lastPeak)
+                    break;
+                
+                firstPeak /= LevelFactor;
+                lastPeak = (lastPeak + 1) / LevelFactor - 1;
+            }
+        }
+    }
+    
+    sf::Int64 PeakPyramid::getFrameCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_frameCount;
+    }
+    
+    unsigned int PeakPyramid::getFramesPerPeak() const
+    {
+        return m_framesPerPeak;
+    }
+    
+    std::size_t PeakPyramid::getLevelCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_levels.size();
+    }
+    
+    void PeakPyramid::resize(sf::Int64 frameCount)
+    {
+        const std::size_t previousLevelCount = m_levels.size();
+        std::size_t peakCount = static_cast<std::size_t>((frameCount + m_framesPerPeak - 1) / m_framesPerPeak);
+        std::size_t level = 0;
+        
+        while (true)
+        {
+            if (level == m_levels.size())
+                m_levels.push_back(std::vector<Peak>());
+            
+            m_levels[level].resize(peakCount, Peak::empty());
+            
+            if (peakCount <= 1)
+                break;
+            
+            peakCount = (peakCount + LevelFactor - 1) / LevelFactor;
+            level++;
+        }
+        
+        m_frameCount = frameCount;
+        
+        // New coarse levels don't know about the peaks that were already added
+        if (previousLevelCount > 0 && m_levels.size() > previousLevelCount)
+            propagate(0, m_levels[0].size() - 1);
+    }
+    
+    void PeakPyramid::propagate(std::size_t firstPeak, std::size_t lastPeak)
+    {
+        for (std::size_t level = 1; level < m_levels.size(); level++)
+        {
+            const std::vector<Peak>& children = m_levels[level - 1];
+            std::vector<Peak>& parents = m_levels[level];
+            firstPeak /= LevelFactor;
+            lastPeak /= LevelFactor;
+            
+            for (std::size_t parent = firstPeak; parent <= lastPeak; parent++)
+            {
+                const std::size_t childrenEnd = std::min<std::size_t>((parent + 1) * LevelFactor, children.size());
+                Peak peak = Peak::empty();
+                
+                for (std::size_t child = parent * LevelFactor; child < childrenEnd; child++)
+                    peak.merge(children[child]);
+                
+                parents[parent] = peak;
+            }
+        }
+    }
+}
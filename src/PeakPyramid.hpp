@@ -0,0 +1,128 @@
+
+/*
+ *  PeakPyramid.hpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef SFEMOVIE_PEAK_PYRAMID_HPP
+#define SFEMOVIE_PEAK_PYRAMID_HPP
+
+#include <SFML/Config.hpp>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace sfe
+{
+    /** Multi-resolution storage of the lowest and highest sample values of an audio track
+     *
+     * The finest level holds one peak per few hundred frames, and each coarser level merges
+     * a fixed count of peaks from the level below, so that any time range can be summarized by
+     * reading a bounded count of peaks.
+     *
+     * Samples can be added in any order and from several threads. Adding the same samples twice
+     * is harmless, which lets overlapping decoded segments be merged without care.
+     */
+    class PeakPyramid
+    {
+    public:
+        struct Peak
+        {
+            sf::Int16 minimum;
+            sf::Int16 maximum;
+            
+            /** @return true if no sample has been merged into this peak yet
+             */
+            bool isEmpty() const;
+            
+            /** Widen this peak so that it also covers @a other
+             */
+            void merge(const Peak& other);
+            
+            /** @return a peak that covers no sample
+             */
+            static Peak empty();
+        };
+        
+        /** Count of peaks merged into one peak of the next coarser level
+         */
+        static const unsigned int LevelFactor = 4;
+        
+        /** Create an empty pyramid
+         *
+         * @param frameCount the expected count of frames of the audio track, the pyramid grows if
+         * frames are added past this count
+         * @param framesPerPeak the count of frames summarized by a peak of the finest level
+         */
+        PeakPyramid(sf::Int64 frameCount, unsigned int framesPerPeak = 256);
+        
+        /** Merge interleaved samples into the pyramid
+         *
+         * @param firstFrame the index of the first frame of @a samples in the audio track
+         * @param samples the interleaved signed 16 bits samples
+         * @param frameCount the count of frames in @a samples
+         * @param channelCount the count of interleaved channels
+         */
+        void addSamples(sf::Int64 firstFrame, const sf::Int16* samples, std::size_t frameCount,
+                        unsigned int channelCount);
+        
+        /** Summarize the given range of frames
+         *
+         * The range is split into @a peakCount slices of equal length, each of them summarized by
+         * the coarsest level that is still finer than the slice
+         *
+         * @param beginFrame the first frame of the range
+         * @param endFrame the frame following the last frame of the range
+         * @param peakCount the count of slices to compute
+         * @param[out] peaks the @a peakCount computed peaks, empty ones cover frames that were not added yet
+         */
+        void getPeaks(sf::Int64 beginFrame, sf::Int64 endFrame, std::size_t peakCount,
+                      std::vector<Peak>& peaks) const;
+        
+        /** @return the count of frames covered by the pyramid
+         */
+        sf::Int64 getFrameCount() const;
+        
+        /** @return the count of frames summarized by a peak of the finest level
+         */
+        unsigned int getFramesPerPeak() const;
+        
+        /** @return the count of resolution levels
+         */
+        std::size_t getLevelCount() const;
+    
+    private:
+        /** Make sure the finest level covers @a frameCount frames, and create the coarser levels
+         */
+        void resize(sf::Int64 frameCount);
+        
+        /** Recompute the coarser levels from the given range of peaks of the finest level
+         */
+        void propagate(std::size_t firstPeak, std::size_t lastPeak);
+        
+        unsigned int m_framesPerPeak;
+        sf::Int64 m_frameCount;
+        std::vector<std::vector<Peak> > m_levels;
+        mutable std::mutex m_mutex;
+    };
+}
+
+#endif
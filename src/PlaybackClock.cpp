@@ -0,0 +1,89 @@
+
+/*
+ *  PlaybackClock.cpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#include <sfeMovie/PlaybackClock.hpp>
+#include "PlaybackClockImpl.hpp"
+#include "MovieImpl.hpp"
+
+namespace sfe
+{
+    PlaybackClock::PlaybackClock() :
+    m_impl(new PlaybackClockImpl())
+    {
+    }
+    
+    PlaybackClock::~PlaybackClock()
+    {
+    }
+    
+    void PlaybackClock::attach(Movie& movie)
+    {
+        m_impl->attach(*movie.m_impl);
+    }
+    
+    void PlaybackClock::detach(Movie& movie)
+    {
+        m_impl->detach(*movie.m_impl);
+    }
+    
+    std::size_t PlaybackClock::getMovieCount() const
+    {
+        return m_impl->getMovieCount();
+    }
+    
+    void PlaybackClock::play()
+    {
+        m_impl->play();
+    }
+    
+    void PlaybackClock::pause()
+    {
+        m_impl->pause();
+    }
+    
+    void PlaybackClock::stop()
+    {
+        m_impl->stop();
+    }
+    
+    bool PlaybackClock::setPlayingOffset(sf::Time position)
+    {
+        return m_impl->seek(position);
+    }
+    
+    Status PlaybackClock::getStatus() const
+    {
+        return m_impl->getStatus();
+    }
+    
+    sf::Time PlaybackClock::getPlayingOffset() const
+    {
+        return m_impl->getOffset();
+    }
+    
+    sf::Time PlaybackClock::getDrift(const Movie& movie) const
+    {
+        return m_impl->getDrift(*movie.m_impl);
+    }
+}
@@ -0,0 +1,394 @@
+
+/*
+ *  PlaybackClockImpl.cpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#include "PlaybackClockImpl.hpp"
+#include "MovieImpl.hpp"
+#include "Timer.hpp"
+#include "DecodeScheduler.hpp"
+#include "Log.hpp"
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace sfe
+{
+    namespace
+    {
+        const int SeekPriority = std::numeric_limits<int>::max();
+    }
+    
+    PlaybackClockImpl::PlaybackClockImpl() :
+    m_reference(std::make_shared<Timer>()),
+    m_movies()
+    {
+    }
+    
+    PlaybackClockImpl::~PlaybackClockImpl()
+    {
+        while (!m_movies.empty())
+            detach(*m_movies.back());
+    }
+    
+    void PlaybackClockImpl::attach(MovieImpl& movie)
+    {
+        if (movie.getPlaybackClock() == this)
+            return;
+        
+        if (movie.getPlaybackClock())
+            movie.getPlaybackClock()->detach(movie);
+        
+        // The movie starts again from the position of the clock
+        std::shared_ptr<Timer> timer = movie.getTimer();
+        if (timer && timer->getStatus() != Stopped)
+            movie.stop();
+        
+        m_movies.push_back(&movie);
+        movie.setPlaybackClock(this);
+        synchronize(movie);
+    }
+    
+    void PlaybackClockImpl::detach(MovieImpl& movie)
+    {
+        std::vector<MovieImpl*>::iterator it = std::find(m_movies.begin(), m_movies.end(), &movie);
+        
+        if (it == m_movies.end())
+        {
+            sfeLogWarning("PlaybackClock::detach() - movie is not attached to this clock");
+            return;
+        }
+        
+        m_movies.erase(it);
+        
+        std::shared_ptr<Timer> timer = movie.getTimer();
+        if (timer)
+            timer->setReference(nullptr);
+        
+        movie.setPlaybackClock(nullptr);
+    }
+    
+    std::size_t PlaybackClockImpl::getMovieCount() const
+    {
+        return m_movies.size();
+    }
+    
+    void PlaybackClockImpl::play()
+    {
+        if (m_reference->getStatus() == Playing)
+        {
+            sfeLogError("PlaybackClock::play() - clock already playing");
+            return;
+        }
+        
+        playTimers();
+        updateMovies();
+    }
+    
+    void PlaybackClockImpl::pause()
+    {
+        if (m_reference->getStatus() == Paused)
+        {
+            sfeLogError("PlaybackClock::pause() - clock already paused");
+            return;
+        }
+        
+        pauseTimers();
+        updateMovies();
+    }
+    
+    void PlaybackClockImpl::stop()
+    {
+        if (m_reference->getStatus() == Stopped)
+        {
+            sfeLogError("PlaybackClock::stop() - clock already stopped");
+            return;
+        }
+        
+        for (MovieImpl* movie : getMovies(Stopped))
+        {
+            try
+            {
+                movie->getTimer()->stop();
+                movie->preloadVideo();
+            }
+            catch (std::runtime_error& e)
+            {
+                sfeLogError(std::string("PlaybackClock::stop() - ") + e.what());
+            }
+        }
+        
+        m_reference->stop();
+        updateMovies();
+    }
+    
+    bool PlaybackClockImpl::seek(sf::Time position)
+    {
+        if (position < sf::Time::Zero)
+        {
+            sfeLogError("PlaybackClock::setPlayingOffset() - position out of range");
+            return false;
+        }
+        
+        const bool wasPlaying = (m_reference->getStatus() == Playing);
+        
+        // The movie timers read the new position from the reference while seeking
+        if (wasPlaying)
+            pauseTimers();
+        
+        m_reference->seek(position);
+        
+        if (m_reference->getStatus() == Stopped)
+            m_reference->pause();
+        
+        std::vector<MovieImpl*> seekedMovies;
+        
+        for (MovieImpl* movie : getMovies())
+        {
+            // Movies shorter than the position have nothing to show
+            if (position < movie->getDuration())
+            {
+                seekedMovies.push_back(movie);
+            }
+            else if (movie->getTimer()->getStatus() != Stopped)
+            {
+                movie->getTimer()->stop();
+                movie->preloadVideo();
+            }
+        }
+        
+        const bool couldSeek = seekTimers(seekedMovies, position);
+        
+        for (MovieImpl* movie : seekedMovies)
+        {
+            if (movie->getTimer()->getStatus() == Stopped)
+                movie->getTimer()->pause();
+        }
+        
+        if (wasPlaying)
+            playTimers();
+        
+        updateMovies();
+        return couldSeek;
+    }
+    
+    Status PlaybackClockImpl::getStatus() const
+    {
+        return m_reference->getStatus();
+    }
+    
+    sf::Time PlaybackClockImpl::getOffset() const
+    {
+        return m_reference->getOffset();
+    }
+    
+    sf::Time PlaybackClockImpl::getDrift(const MovieImpl& movie) const
+    {
+        std::shared_ptr<Timer> timer = movie.getTimer();
+        
+        if (movie.getPlaybackClock() != this || !timer || timer->getStatus() == Stopped)
+            return sf::Time::Zero;
+        
+        // Both offsets are the same unless the timer lost its reference, what matters is how late
+        // the displayed image is
+        return timer->getOffset() - m_reference->getOffset() - movie.getPresentationLateness();
+    }
+    
+    void PlaybackClockImpl::synchronize(MovieImpl& movie)
+    {
+        std::shared_ptr<Timer> timer = movie.getTimer();
+        
+        if (!timer)
+            return;
+        
+        timer->setReference(m_reference);
+        
+        const sf::Time position = m_reference->getOffset();
+        
+        if (m_reference->getStatus() != Stopped && position < movie.getDuration())
+        {
+            try
+            {
+                timer->seek(position);
+                timer->pause();
+                
+                if (m_reference->getStatus() == Playing)
+                    timer->play();
+            }
+            catch (std::runtime_error& e)
+            {
+                sfeLogError(std::string("PlaybackClock::attach() - ") + e.what());
+            }
+        }
+        
+        movie.didChangeTimerState();
+    }
+    
+    void PlaybackClockImpl::playTimers()
+    {
+        const bool wasStopped = (m_reference->getStatus() == Stopped);
+        std::vector<MovieImpl*> readyMovies;
+        
+        // Movies that reached their end only play again once the clock stopped or seeked
+        for (MovieImpl* movie : getMovies(Playing))
+        {
+            try
+            {
+                if (wasStopped || movie->getTimer()->getStatus() != Stopped)
+                {
+                    movie->getTimer()->prepareToPlay();
+                    readyMovies.push_back(movie);
+                }
+            }
+            catch (std::runtime_error& e)
+            {
+                sfeLogError(std::string("PlaybackClock::play() - ") + e.what());
+            }
+        }
+        
+        // All the movies are buffered, they can start together
+        m_reference->play();
+        
+        for (MovieImpl* movie : readyMovies)
+        {
+            try
+            {
+                movie->getTimer()->startPlaying();
+            }
+            catch (std::runtime_error& e)
+            {
+                sfeLogError(std::string("PlaybackClock::play() - ") + e.what());
+            }
+        }
+    }
+    
+    void PlaybackClockImpl::pauseTimers()
+    {
+        const bool wasStopped = (m_reference->getStatus() == Stopped);
+        
+        m_reference->pause();
+        
+        for (MovieImpl* movie : getMovies(Paused))
+        {
+            try
+            {
+                if (wasStopped || movie->getTimer()->getStatus() != Stopped)
+                    movie->getTimer()->pause();
+            }
+            catch (std::runtime_error& e)
+            {
+                sfeLogError(std::string("PlaybackClock::pause() - ") + e.what());
+            }
+        }
+    }
+    
+    std::vector<MovieImpl*> PlaybackClockImpl::getMovies() const
+    {
+        std::vector<MovieImpl*> movies;
+        
+        for (MovieImpl* movie : m_movies)
+        {
+            if (movie->getTimer())
+                movies.push_back(movie);
+        }
+        
+        return movies;
+    }
+    
+    std::vector<MovieImpl*> PlaybackClockImpl::getMovies(Status excludedStatus) const
+    {
+        std::vector<MovieImpl*> movies;
+        
+        for (MovieImpl* movie : getMovies())
+        {
+            if (movie->getTimer()->getStatus() != excludedStatus)
+                movies.push_back(movie);
+        }
+        
+        return movies;
+    }
+    
+    bool PlaybackClockImpl::seekTimers(const std::vector<MovieImpl*>& movies, sf::Time position)
+    {
+        DecodeScheduler& scheduler = DecodeScheduler::getInstance();
+        
+        // Without decode workers the scheduler runs tasks inline, seek on short-lived threads
+        // instead so that the movies are still sought concurrently
+        const bool useThreads = scheduler.getWorkerCount() == 0 && movies.size() > 1;
+        std::vector<std::future<bool> > results;
+        std::vector<std::thread> threads;
+        
+        for (MovieImpl* movie : movies)
+        {
+            std::shared_ptr<Timer> timer = movie->getTimer();
+            std::shared_ptr<std::promise<bool> > result = std::make_shared<std::promise<bool> >();
+            results.push_back(result->get_future());
+            
+            std::function<void()> seek = [timer, position, result]()
+            {
+                // The promise must be fulfilled whatever happens, the caller waits for it
+                try
+                {
+                    result->set_value(timer->seek(position));
+                }
+                catch (std::exception& e)
+                {
+                    sfeLogError(std::string("PlaybackClock::setPlayingOffset() - ") + e.what());
+                    result->set_value(false);
+                }
+                catch (...)
+                {
+                    sfeLogError("PlaybackClock::setPlayingOffset() - unknown error while seeking");
+                    result->set_value(false);
+                }
+            };
+            
+            // The caller waits for the seeks, they go before any decoding
+            if (useThreads)
+                threads.push_back(std::thread(seek));
+            else
+                scheduler.submit(movie, SeekPriority, DecodeScheduler::Clock::now(), seek);
+        }
+        
+        bool couldSeek = true;
+        
+        for (std::future<bool>& result : results)
+            couldSeek = result.get() && couldSeek;
+        
+        for (std::thread& thread : threads)
+            thread.join();
+        
+        return couldSeek;
+    }
+    
+    void PlaybackClockImpl::updateMovies()
+    {
+        for (MovieImpl* movie : m_movies)
+        {
+            if (movie->getTimer())
+                movie->didChangeTimerState();
+        }
+    }
+}
@@ -0,0 +1,136 @@
+
+/*
+ *  PlaybackClockImpl.hpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef SFEMOVIE_PLAYBACK_CLOCK_IMPL_HPP
+#define SFEMOVIE_PLAYBACK_CLOCK_IMPL_HPP
+
+#include <SFML/System.hpp>
+#include <sfeMovie/Movie.hpp>
+#include <memory>
+#include <vector>
+
+namespace sfe
+{
+    class MovieImpl;
+    class Timer;
+    
+    /** Keeps the timers of several movies in sync
+     *
+     * Each movie keeps its own timer and observers, but reads its offset from the reference timer of
+     * the clock. The clock changes the status of all the timers together, and starts the reference
+     * only once all the movies are ready to play.
+     */
+    class PlaybackClockImpl
+    {
+    public:
+        PlaybackClockImpl();
+        
+        /** Detach all the movies
+         */
+        ~PlaybackClockImpl();
+        
+        /** @see PlaybackClock::attach()
+         */
+        void attach(MovieImpl& movie);
+        
+        /** @see PlaybackClock::detach()
+         */
+        void detach(MovieImpl& movie);
+        
+        /** @see PlaybackClock::getMovieCount()
+         */
+        std::size_t getMovieCount() const;
+        
+        /** @see PlaybackClock::play()
+         */
+        void play();
+        
+        /** @see PlaybackClock::pause()
+         */
+        void pause();
+        
+        /** @see PlaybackClock::stop()
+         */
+        void stop();
+        
+        /** @see PlaybackClock::setPlayingOffset()
+         */
+        bool seek(sf::Time position);
+        
+        /** @see PlaybackClock::getStatus()
+         */
+        Status getStatus() const;
+        
+        /** @see PlaybackClock::getPlayingOffset()
+         */
+        sf::Time getOffset() const;
+        
+        /** @see PlaybackClock::getDrift()
+         */
+        sf::Time getDrift(const MovieImpl& movie) const;
+        
+        /** Make the timer of an attached movie follow the clock, and bring it to the position and status
+         * of the clock
+         *
+         * This must be called again when the movie opens another media, as it gets a new timer
+         *
+         * @param movie the attached movie, whose timer is stopped
+         */
+        void synchronize(MovieImpl& movie);
+    
+    private:
+        /** Change the status of the movie timers without updating the movies
+         */
+        void playTimers();
+        void pauseTimers();
+        
+        /** @return the attached movies that have a media opened
+         */
+        std::vector<MovieImpl*> getMovies() const;
+        
+        /** @return the attached movies that have a media opened and whose timer status is not
+         * @a excludedStatus
+         */
+        std::vector<MovieImpl*> getMovies(Status excludedStatus) const;
+        
+        /** Seek the timers of the given movies on the decoding threads and wait for them
+         *
+         * Seeking involves I/O and decoding in each movie, but no status change
+         *
+         * @param movies the movies to seek, whose timers are not playing
+         * @param position the position to seek to
+         * @return true if all the movies could seek
+         */
+        bool seekTimers(const std::vector<MovieImpl*>& movies, sf::Time position);
+        
+        /** Update the movies after their timers changed
+         */
+        void updateMovies();
+        
+        std::shared_ptr<Timer> m_reference;
+        std::vector<MovieImpl*> m_movies;
+    };
+}
+
+#endif
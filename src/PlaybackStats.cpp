@@ -0,0 +1,102 @@
+
+/*
+ *  PlaybackStats.cpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#include <sfeMovie/PlaybackStats.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace sfe
+{
+    TimeHistogram::TimeHistogram() :
+    count(0),
+    total(sf::Time::Zero),
+    maximum(sf::Time::Zero)
+    {
+        std::fill(buckets, buckets + BucketCount, 0);
+    }
+    
+    void TimeHistogram::add(sf::Time duration)
+    {
+        sf::Int64 microseconds = std::max(duration.asMicroseconds(), sf::Int64(0));
+        unsigned int bucket = 0;
+        
+        while (microseconds > 0 && bucket + 1 < BucketCount)
+        {
+            microseconds >>= 1;
+            bucket++;
+        }
+        
+        buckets[bucket]++;
+        count++;
+        total += duration;
+        maximum = std::max(maximum, duration);
+    }
+    
+    sf::Time TimeHistogram::getMean() const
+    {
+        return count ? sf::microseconds(total.asMicroseconds() / static_cast<sf::Int64>(count)) : sf::Time::Zero;
+    }
+    
+    sf::Time TimeHistogram::getPercentile(float ratio) const
+    {
+        if (count == 0)
+            return sf::Time::Zero;
+        
+        const float clampedRatio = std::min(std::max(ratio, 0.f), 1.f);
+        const sf::Uint64 rank = std::max<sf::Uint64>(static_cast<sf::Uint64>(std::ceil(clampedRatio * count)), 1);
+        sf::Uint64 cumulatedCount = 0;
+        
+        for (unsigned int bucket = 0; bucket < BucketCount; bucket++)
+        {
+            cumulatedCount += buckets[bucket];
+            
+            // The last bucket has no upper bound
+            if (cumulatedCount >= rank)
+                return (bucket + 1 < BucketCount) ? std::min(getBucketUpperBound(bucket), maximum) : maximum;
+        }
+        
+        return maximum;
+    }
+    
+    sf::Time TimeHistogram::getBucketUpperBound(unsigned int bucket)
+    {
+        return sf::microseconds(sf::Int64(1) << std::min(bucket, BucketCount - 1));
+    }
+    
+    StreamStats::StreamStats() :
+    stream(StreamDescriptor::NoSelection(Unknown)),
+    framesDecoded(0),
+    framesPresented(0),
+    framesDroppedLate(0),
+    framesRepeated(0),
+    decodeTime(),
+    convertTime(),
+    uploadTime(),
+    syncError(),
+    playLatency(),
+    pauseLatency(),
+    stopLatency()
+    {
+    }
+}
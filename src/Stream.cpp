@@ -31,6 +31,7 @@ extern "C"
 #include "Stream.hpp"
 #include "Utilities.hpp"
 #include "TimerPriorities.hpp"
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <stdexcept>
@@ -43,34 +44,37 @@ namespace sfe
                            + "/" + avcodec_get_name(stream->codec->codec_id) + "' stream @ " + s(stream));
     }
     
+    std::size_t Stream::packetMemory(const AVPacket* packet)
+    {
+        return sizeof(*packet) + std::max(packet->size, 0);
+    }
+    
     Stream::Stream(AVFormatContext*& formatCtx, AVStream*& stream, DataSource& dataSource, std::shared_ptr<Timer> timer) :
     m_formatCtx(formatCtx),
     m_stream(stream),
     m_dataSource(dataSource),
+    m_memoryAccount(dataSource.getMemoryAccount()),
     m_timer(timer),
     m_codec(nullptr),
     m_streamID(-1),
     m_packetList(),
     m_status(Stopped),
-    m_readerMutex()
+    m_readerMutex(),
+    m_statsMutex(),
+    m_stats()
     {
         CHECK(stream, "Stream::Stream() - invalid stream argument");
         CHECK(timer, "Inconcistency error: null timer");
-        int err = 0;
         
         m_stream = stream;
         m_streamID = stream->index;
         CHECK(m_stream, "Inconcistency error: null stream")
         CHECK(m_streamID >= 0, "Inconcistency error: invalid stream id");
         
-        // Get the decoder
+        // Get the decoder, it is only loaded once the stream gets selected
         m_codec = avcodec_find_decoder(m_stream->codec->codec_id);
         CHECK(m_codec, "Stream() - no decoder for " + std::string(avcodec_get_name(m_stream->codec->codec_id)) + " codec");
         
-        // Load the codec
-        err = avcodec_open2(m_stream->codec, m_codec, nullptr);
-        CHECK0(err, "Stream() - unable to load decoder for codec " + std::string(avcodec_get_name(m_stream->codec->codec_id)));
-        
         AVDictionaryEntry* entry = av_dict_get(m_stream->metadata, "language", nullptr, 0);
         if (entry)
         {
@@ -80,12 +84,13 @@ namespace sfe
     
     Stream::~Stream()
     {
-        disconnect();
+        m_timer->removeObserver(*this);
         Stream::flushBuffers();
         
         if (m_formatCtx && m_stream && m_stream->codec)
         {
-            avcodec_close(m_stream->codec);
+            if (isDecoderOpen())
+                avcodec_close(m_stream->codec);
         }
         else
         {
@@ -95,6 +100,8 @@ namespace sfe
     
     void Stream::connect()
     {
+        openDecoder();
+        
         if (isPassive())
             m_timer->addObserver(*this, PassiveStreamTimerPriority);
         else
@@ -104,6 +111,53 @@ namespace sfe
     void Stream::disconnect()
     {
         m_timer->removeObserver(*this);
+        closeDecoder();
+    }
+    
+    void Stream::openDecoder()
+    {
+        if (isDecoderOpen())
+            return;
+        
+        int err = avcodec_open2(m_stream->codec, m_codec, nullptr);
+        CHECK0(err, "Stream::openDecoder() - unable to load decoder for codec "
+               + std::string(avcodec_get_name(m_stream->codec->codec_id)));
+        
+        try
+        {
+            didOpenDecoder();
+        }
+        catch (...)
+        {
+            avcodec_close(m_stream->codec);
+            throw;
+        }
+        
+        sfeLogDebug("Opened decoder of " + description());
+    }
+    
+    void Stream::closeDecoder()
+    {
+        if (!isDecoderOpen())
+            return;
+        
+        willCloseDecoder();
+        avcodec_close(m_stream->codec);
+        
+        sfeLogDebug("Closed decoder of " + description());
+    }
+    
+    bool Stream::isDecoderOpen() const
+    {
+        return avcodec_is_open(m_stream->codec) != 0;
+    }
+    
+    void Stream::didOpenDecoder()
+    {
+    }
+    
+    void Stream::willCloseDecoder()
+    {
     }
     
     void Stream::pushEncodedData(AVPacket* packet)
@@ -111,6 +165,7 @@ namespace sfe
         CHECK(packet, "invalid argument");
         sf::Lock l(m_readerMutex);
         m_packetList.push_back(packet);
+        m_memoryAccount.add(MemoryAccount::EncodedPackets, packetMemory(packet));
     }
     
     void Stream::prependEncodedData(AVPacket* packet)
@@ -118,6 +173,7 @@ namespace sfe
         CHECK(packet, "invalid argument");
         sf::Lock l(m_readerMutex);
         m_packetList.push_front(packet);
+        m_memoryAccount.add(MemoryAccount::EncodedPackets, packetMemory(packet));
     }
     
     AVPacket* Stream::popEncodedData()
@@ -134,10 +190,11 @@ namespace sfe
         {
             result = m_packetList.front();
             m_packetList.pop_front();
+            m_memoryAccount.remove(MemoryAccount::EncodedPackets, packetMemory(result));
         }
         else
         {
-            if (m_stream->codec->codec->capabilities & CODEC_CAP_DELAY)
+            if (m_codec->capabilities & CODEC_CAP_DELAY)
             {
                 AVPacket* flushPacket = (AVPacket*)av_malloc(sizeof(*flushPacket));
                 av_init_packet(flushPacket);
@@ -160,7 +217,7 @@ namespace sfe
             sfeLogWarning("packets flushed while the stream is still playing");
         }
         
-        if (m_formatCtx && m_stream)
+        if (m_formatCtx && m_stream && isDecoderOpen())
             avcodec_flush_buffers(m_stream->codec);
         
         AVPacket* pkt = nullptr;
@@ -169,6 +226,7 @@ namespace sfe
         {
             pkt = m_packetList.front();
             m_packetList.pop_front();
+            m_memoryAccount.remove(MemoryAccount::EncodedPackets, packetMemory(pkt));
             
             av_free_packet(pkt);
             av_free(pkt);
@@ -177,7 +235,8 @@ namespace sfe
     
     bool Stream::needsMoreData() const
     {
-        return m_packetList.size() < 10;
+        // Read fewer packets ahead when the movies use too much memory
+        return m_packetList.size() < (MemoryAccount::isOverBudget() ? 2 : 10);
     }
     
     MediaType Stream::getStreamKind() const
@@ -261,6 +320,11 @@ namespace sfe
         return false;
     }
     
+    bool Stream::getTimeUntilNextUpdate(sf::Time& delay) const
+    {
+        return false;
+    }
+    
     void Stream::setStatus(Status status)
     {
         m_status = status;
@@ -289,7 +353,18 @@ namespace sfe
         return true;
     }
     
-    bool Stream::hasPackets()
+    StreamStats Stream::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        
+        StreamStats stats = m_stats;
+        stats.stream.type = getStreamKind();
+        stats.stream.identifier = m_streamID;
+        stats.stream.language = m_language;
+        return stats;
+    }
+    
+    bool Stream::hasPackets() const
     {
         return !m_packetList.empty();
     }
@@ -27,8 +27,10 @@
 
 #include "Macros.hpp"
 #include "Timer.hpp"
+#include "MemoryAccount.hpp"
 #include <list>
 #include <memory>
+#include <mutex>
 #include <SFML/System.hpp>
 #include <sfeMovie/Movie.hpp>
 
@@ -46,16 +48,24 @@ namespace sfe
         {
             virtual void requestMoreData(Stream& starvingStream) = 0;
             virtual void resetEndOfFileStatus() = 0;
+            
+            /** @return the account where the streams count their buffers
+             */
+            virtual MemoryAccount& getMemoryAccount() = 0;
         };
         
         /** @return a textual description of the given FFmpeg stream
          */
         static std::string AVStreamDescription(AVStream* stream);
         
+        /** @return the memory used by the given packet, as counted in MemoryAccount::EncodedPackets
+         */
+        static std::size_t packetMemory(const AVPacket* packet);
+        
         /** Create a stream from the given FFmpeg stream
          *
-         * At the end of the constructor, the stream is guaranteed
-         * to have all of its fields set and the decoder loaded
+         * At the end of the constructor, the stream is guaranteed to have all of its fields set
+         * and a decoder available, but the decoder is only loaded once the stream is connected
          *
          * @param stream the FFmpeg stream
          * @param dataSource the encoded data provider for this stream
@@ -68,13 +78,31 @@ namespace sfe
         
         /** Connect this stream against the reference timer to receive playback events; this allows this
          * stream to be played
+         *
+         * The decoder is loaded if it was not yet
          */
         void connect();
         
         /** Disconnect this stream from the reference timer ; this disables this stream
+         *
+         * The decoder and the decoding buffers are released
          */
         void disconnect();
         
+        /** Load the decoder and allocate the decoding buffers, if not done yet
+         *
+         * This is done by connect(), streams that are decoded without being connected must call it
+         */
+        void openDecoder();
+        
+        /** Release the decoder and the decoding buffers, if they were loaded
+         */
+        void closeDecoder();
+        
+        /** @return true if the decoder is loaded, false otherwise
+         */
+        bool isDecoderOpen() const;
+        
         /** Called by the demuxer to provide the stream with encoded data
          *
          * @return packet the encoded data usable by this stream
@@ -156,10 +184,25 @@ namespace sfe
          */
         std::string description() const;
         
+        /** @return the decoding and presentation statistics of this stream
+         */
+        StreamStats getStats() const;
+        
         /** Update the current stream's status and eventually decode frames
          */
         virtual void update() = 0;
         
+        /** Tell when update() will next have something to show
+         *
+         * The default implementation never schedules anything, which suits the streams that are
+         * played in background
+         *
+         * @param[out] delay the time left before the output of the stream changes, unmodified if
+         * nothing is scheduled
+         * @return true if an update is scheduled, false if nothing changes until the status does
+         */
+        virtual bool getTimeUntilNextUpdate(sf::Time& delay) const;
+        
         /** @return true if the given packet is for the current stream
          */
         bool canUsePacket(AVPacket* packet) const;
@@ -176,9 +219,22 @@ namespace sfe
         void didStop(const Timer& timer, Status previousStatus) override;
         bool didSeek(const Timer& timer, sf::Time oldPosition) override;
         
+        /** Called right after the decoder is loaded, to allocate the decoding buffers
+         *
+         * The default implementation does nothing
+         */
+        virtual void didOpenDecoder();
+        
+        /** Called right before the decoder is released, to release the decoding buffers
+         *
+         * This is not called when the stream is destroyed, destructors must release the buffers
+         * themselves. The default implementation does nothing
+         */
+        virtual void willCloseDecoder();
+        
         /** @return true if any raw packet for the current stream is queued
          */
-        bool hasPackets();
+        bool hasPackets() const;
         
         void setStatus(Status status);
         
@@ -186,6 +242,7 @@ namespace sfe
         AVStream*& m_stream;
         
         DataSource& m_dataSource;
+        MemoryAccount& m_memoryAccount;
         std::shared_ptr<Timer> m_timer;
         AVCodec* m_codec;
         int m_streamID;
@@ -193,6 +250,10 @@ namespace sfe
         std::list <AVPacket*> m_packetList;
         Status m_status;
         sf::Mutex m_readerMutex;
+        
+        // Updated by subclasses while decoding, which happens on the audio thread for audio streams
+        mutable std::mutex m_statsMutex;
+        StreamStats m_stats;
     };
 }
 
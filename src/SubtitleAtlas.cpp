@@ -0,0 +1,241 @@
+
+/*
+ *  SubtitleAtlas.cpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#include "SubtitleAtlas.hpp"
+#include "Log.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace sfe
+{
+    namespace
+    {
+        const unsigned int DefaultAtlasWidth = 1024;
+        
+        // Transparent pixels kept between images so that smoothing doesn't blend them together
+        const unsigned int Padding = 1;
+        
+        const unsigned int RGBASize = 4;
+        
+        unsigned int nextPowerOfTwo(unsigned int value)
+        {
+            unsigned int power = 1;
+            while (power < value)
+                power <<= 1;
+            return power;
+        }
+    }
+    
+    ShelfPacker::ShelfPacker(unsigned int width) :
+    m_width(width),
+    m_shelves()
+    {
+    }
+    
+    void ShelfPacker::reset(unsigned int width)
+    {
+        m_width = width;
+        m_shelves.clear();
+    }
+    
+    bool ShelfPacker::pack(unsigned int width, unsigned int height, sf::Vector2u& position)
+    {
+        if (width > m_width)
+            return false;
+        
+        Shelf* bestShelf = nullptr;
+        
+        for (Shelf& shelf : m_shelves)
+        {
+            if (shelf.height >= height && shelf.usedWidth + width <= m_width &&
+                (!bestShelf || shelf.height < bestShelf->height))
+                bestShelf = &shelf;
+        }
+        
+        if (!bestShelf)
+        {
+            Shelf shelf;
+            shelf.top = getHeight();
+            shelf.height = height;
+            shelf.usedWidth = 0;
+            m_shelves.push_back(shelf);
+            bestShelf = &m_shelves.back();
+        }
+        
+        position.x = bestShelf->usedWidth;
+        position.y = bestShelf->top;
+        bestShelf->usedWidth += width;
+        
+        return true;
+    }
+    
+    unsigned int ShelfPacker::getWidth() const
+    {
+        return m_width;
+    }
+    
+    unsigned int ShelfPacker::getHeight() const
+    {
+        return m_shelves.empty() ? 0 : m_shelves.back().top + m_shelves.back().height;
+    }
+    
+    SubtitleAtlas::SubtitleAtlas() :
+    m_texture(std::make_shared<sf::Texture>()),
+    m_vertices(sf::Quads),
+    m_packer(DefaultAtlasWidth),
+    m_placements(),
+    m_packingOrder(),
+    m_pixels()
+    {
+    }
+    
+    void SubtitleAtlas::update(const std::vector<const Image*>& images)
+    {
+        m_vertices.clear();
+        
+        if (images.empty())
+            return;
+        
+        const unsigned int maximumSize = sf::Texture::getMaximumSize();
+        unsigned int width = std::max(DefaultAtlasWidth, m_texture->getSize().x);
+        
+        for (const Image* image : images)
+            width = std::max(width, nextPowerOfTwo(image->size.x + Padding));
+        
+        width = std::min(width, maximumSize);
+        
+        // Highest images first
+        m_packingOrder.resize(images.size());
+        for (std::size_t i = 0; i < images.size(); i++)
+            m_packingOrder[i] = i;
+        
+        std::stable_sort(m_packingOrder.begin(), m_packingOrder.end(), [&images](std::size_t a, std::size_t b)
+        {
+            return images[a]->size.y > images[b]->size.y;
+        });
+        
+        m_packer.reset(width);
+        m_placements.assign(images.size(), sf::Vector2u(0, 0));
+        std::vector<bool> packed(images.size(), false);
+        
+        for (std::size_t i : m_packingOrder)
+        {
+            const sf::Vector2u& size = images[i]->size;
+            
+            if (m_packer.pack(size.x + Padding, size.y + Padding, m_placements[i]) &&
+                m_placements[i].y + size.y <= maximumSize)
+            {
+                packed[i] = true;
+            }
+            else
+            {
+                sfeLogWarning("SubtitleAtlas::update() - subtitle image of " + s(size.x) + "x" + s(size.y)
+                              + " pixels does not fit in the largest texture, it won't be displayed");
+            }
+        }
+        
+        const unsigned int height = std::min(m_packer.getHeight(), maximumSize);
+        
+        if (!reserve(width, height))
+            return;
+        
+        // Compose the whole used area so that it's uploaded at once, this also clears the padding
+        m_pixels.assign(static_cast<std::size_t>(width) * height * RGBASize, 0);
+        
+        for (std::size_t i = 0; i < images.size(); i++)
+        {
+            if (!packed[i])
+                continue;
+            
+            const Image& image = *images[i];
+            const sf::Vector2u& placement = m_placements[i];
+            const std::size_t rowSize = image.size.x * RGBASize;
+            
+            for (unsigned int y = 0; y < image.size.y; y++)
+            {
+                std::memcpy(&m_pixels[((placement.y + y) * width + placement.x) * RGBASize],
+                            &image.pixels[y * rowSize], rowSize);
+            }
+            
+            const float left = static_cast<float>(image.position.x);
+            const float top = static_cast<float>(image.position.y);
+            const float right = left + image.size.x;
+            const float bottom = top + image.size.y;
+            const float textureLeft = static_cast<float>(placement.x);
+            const float textureTop = static_cast<float>(placement.y);
+            const float textureRight = textureLeft + image.size.x;
+            const float textureBottom = textureTop + image.size.y;
+            
+            m_vertices.append(sf::Vertex(sf::Vector2f(left, top), sf::Vector2f(textureLeft, textureTop)));
+            m_vertices.append(sf::Vertex(sf::Vector2f(right, top), sf::Vector2f(textureRight, textureTop)));
+            m_vertices.append(sf::Vertex(sf::Vector2f(right, bottom), sf::Vector2f(textureRight, textureBottom)));
+            m_vertices.append(sf::Vertex(sf::Vector2f(left, bottom), sf::Vector2f(textureLeft, textureBottom)));
+        }
+        
+        m_texture->update(m_pixels.data(), width, height, 0, 0);
+    }
+    
+    void SubtitleAtlas::clear()
+    {
+        m_vertices.clear();
+    }
+    
+    const sf::VertexArray& SubtitleAtlas::getVertices() const
+    {
+        return m_vertices;
+    }
+    
+    std::shared_ptr<const sf::Texture> SubtitleAtlas::getTexture() const
+    {
+        return m_texture;
+    }
+    
+    sf::BlendMode SubtitleAtlas::getBlendMode()
+    {
+        return sf::BlendMode(sf::BlendMode::One, sf::BlendMode::OneMinusSrcAlpha);
+    }
+    
+    bool SubtitleAtlas::reserve(unsigned int width, unsigned int height)
+    {
+        const sf::Vector2u& size = m_texture->getSize();
+        
+        if (size.x >= width && size.y >= height)
+            return true;
+        
+        // Grow by powers of two so that the texture is rarely created again
+        const unsigned int maximumSize = sf::Texture::getMaximumSize();
+        const unsigned int newWidth = std::min(std::max(size.x, nextPowerOfTwo(width)), maximumSize);
+        const unsigned int newHeight = std::min(std::max(size.y, nextPowerOfTwo(height)), maximumSize);
+        
+        if (!m_texture->create(newWidth, newHeight))
+        {
+            sfeLogError("SubtitleAtlas::reserve() - could not create a " + s(newWidth) + "x" + s(newHeight)
+                        + " texture, subtitles won't be displayed");
+            return false;
+        }
+        
+        m_texture->setSmooth(true);
+        return true;
+    }
+}
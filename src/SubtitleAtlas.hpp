@@ -0,0 +1,142 @@
+
+/*
+ *  SubtitleAtlas.hpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef SFEMOVIE_SUBTITLE_ATLAS_HPP
+#define SFEMOVIE_SUBTITLE_ATLAS_HPP
+
+#include <SFML/Graphics.hpp>
+#include <memory>
+#include <vector>
+
+namespace sfe
+{
+    /** Places rectangles in rows of fixed width and unbounded height
+     *
+     * Each row (shelf) is as high as the first rectangle placed in it. Rectangles go to the
+     * lowest shelf they fit in, or to a new shelf. Placing them from the highest to the lowest
+     * one keeps the wasted space low.
+     */
+    class ShelfPacker
+    {
+    public:
+        /** Create a packer with no shelf
+         *
+         * @param width the width available for each shelf
+         */
+        ShelfPacker(unsigned int width);
+        
+        /** Remove all the shelves, and change the width available for the next ones
+         *
+         * @param width the width available for each shelf
+         */
+        void reset(unsigned int width);
+        
+        /** Find a place for a rectangle
+         *
+         * @param width the width of the rectangle
+         * @param height the height of the rectangle
+         * @param[out] position the top left corner of the place given to the rectangle
+         * @return true on success, false if the rectangle is wider than the shelves
+         */
+        bool pack(unsigned int width, unsigned int height, sf::Vector2u& position);
+        
+        /** @return the width available for each shelf
+         */
+        unsigned int getWidth() const;
+        
+        /** @return the height covered by all the shelves
+         */
+        unsigned int getHeight() const;
+    
+    private:
+        struct Shelf
+        {
+            unsigned int top;
+            unsigned int height;
+            unsigned int usedWidth;
+        };
+        
+        unsigned int m_width;
+        std::vector<Shelf> m_shelves;
+    };
+    
+    /** Texture holding all the subtitle images displayed at once, and the quads that display them
+     *
+     * The texture is reused from one subtitle to the next one and only grows, so that
+     * displaying a subtitle costs a single texture upload and a single draw call
+     * whatever its count of images.
+     */
+    class SubtitleAtlas
+    {
+    public:
+        /** A subtitle image, in RGBA format with premultiplied alpha
+         */
+        struct Image
+        {
+            sf::Vector2i position;          //!< Top left corner in the video frame
+            sf::Vector2u size;              //!< Width and height in pixels
+            std::vector<sf::Uint8> pixels;  //!< size.x * size.y RGBA pixels
+        };
+        
+        SubtitleAtlas();
+        
+        /** Replace the content of the atlas with the given images
+         *
+         * @param images the images to display, in drawing order
+         */
+        void update(const std::vector<const Image*>& images);
+        
+        /** Remove all the images
+         */
+        void clear();
+        
+        /** @return the quads displaying the images, in video frame coordinates, to be drawn with getTexture()
+         */
+        const sf::VertexArray& getVertices() const;
+        
+        /** @return the texture holding the images, to be drawn with getBlendMode()
+         */
+        std::shared_ptr<const sf::Texture> getTexture() const;
+        
+        /** @return the blending of premultiplied alpha images
+         */
+        static sf::BlendMode getBlendMode();
+    
+    private:
+        /** Make the texture at least as large as requested, without shrinking it
+         *
+         * @return true on success, false if the texture could not be created
+         */
+        bool reserve(unsigned int width, unsigned int height);
+        
+        std::shared_ptr<sf::Texture> m_texture;
+        sf::VertexArray m_vertices;
+        ShelfPacker m_packer;
+        std::vector<sf::Vector2u> m_placements;
+        std::vector<std::size_t> m_packingOrder;
+        std::vector<sf::Uint8> m_pixels;
+    };
+}
+
+#endif
@@ -0,0 +1,400 @@
+
+/*
+ *  SubtitleFile.cpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+#include "SubtitleFile.hpp"
+#include "TimerPriorities.hpp"
+#include "Log.hpp"
+#include "Utilities.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace sfe
+{
+    namespace
+    {
+        // How long before being displayed the events are decoded, so that they're rendered in time
+        const sf::Time LookAhead = sf::seconds(10);
+        
+        // Used instead of LookAhead when the movies use more memory than their budget
+        const sf::Time ReducedLookAhead = sf::seconds(2);
+    }
+    
+    SubtitleFile::SubtitleFile(const std::string& sourceFile, std::shared_ptr<Timer> timer,
+                               SubtitleStream::Delegate& delegate) :
+    m_sourceFile(sourceFile),
+    m_timer(timer),
+    m_delegate(delegate),
+    m_renderingFrame(0, 0),
+    m_isSelected(false),
+    m_formatCtx(nullptr),
+    m_avStream(nullptr),
+    m_events(),
+    m_isIndexed(false),
+    m_shouldStop(false),
+    m_thread(),
+    m_memoryAccount(),
+    m_stream(nullptr),
+    m_loadFailed(false),
+    m_isReading(false),
+    m_endReached(false),
+    m_pendingPacket(nullptr)
+    {
+        CHECK(sourceFile.size(), "SubtitleFile::SubtitleFile() - invalid argument: sourceFile");
+        CHECK(timer, "Inconsistency error: null timer");
+        
+        // Notified before the subtitle stream so that it's given the events before fast forwarding
+        m_timer->addObserver(*this, DemuxerTimerPriority);
+        m_thread = std::thread(&SubtitleFile::index, this);
+    }
+    
+    SubtitleFile::~SubtitleFile()
+    {
+        m_shouldStop = true;
+        m_thread.join();
+        m_timer->removeObserver(*this);
+        
+        resetReading();
+        
+        // The stream must be destroyed before the format context that owns its codec context
+        m_stream.reset();
+        
+        if (m_formatCtx)
+            avformat_close_input(&m_formatCtx);
+    }
+    
+    void SubtitleFile::setRenderingFrame(int width, int height)
+    {
+        m_renderingFrame = sf::Vector2i(width, height);
+        
+        if (m_stream)
+            m_stream->setRenderingFrame(width, height);
+    }
+    
+    void SubtitleFile::setSelected(bool selected)
+    {
+        if (selected == m_isSelected)
+            return;
+        
+        m_isSelected = selected;
+        
+        if (m_stream)
+        {
+            if (selected)
+            {
+                m_stream->connect();
+            }
+            else
+            {
+                m_stream->disconnect();
+                m_stream->flushBuffers();
+                resetReading();
+            }
+        }
+    }
+    
+    bool SubtitleFile::isSelected() const
+    {
+        return m_isSelected;
+    }
+    
+    std::shared_ptr<SubtitleStream> SubtitleFile::getStream() const
+    {
+        return m_stream;
+    }
+    
+    void SubtitleFile::update()
+    {
+        if (!m_stream && !m_loadFailed && m_isIndexed)
+            loadStream();
+        
+        if (m_stream && m_isSelected)
+        {
+            readEvents(m_timer->getOffset());
+            m_stream->update();
+        }
+    }
+    
+    bool SubtitleFile::getTimeUntilNextUpdate(sf::Time& delay) const
+    {
+        if (!m_stream && !m_loadFailed && m_isIndexed)
+        {
+            delay = sf::Time::Zero;
+            return true;
+        }
+        
+        if (!m_stream || !m_isSelected || m_stream->getStatus() != Playing)
+            return false;
+        
+        bool isScheduled = m_stream->getTimeUntilNextUpdate(delay);
+        
+        // The next unread event is read once it enters the look-ahead window
+        if (m_pendingPacket && m_pendingPacket->pts != AV_NOPTS_VALUE)
+        {
+            const sf::Time lookAhead = MemoryAccount::isOverBudget() ? ReducedLookAhead : LookAhead;
+            const sf::Time readDelay = std::max(timestampToTime(m_pendingPacket->pts) - lookAhead - m_timer->getOffset(),
+                                                sf::Time::Zero);
+            
+            if (!isScheduled || readDelay < delay)
+                delay = readDelay;
+            
+            isScheduled = true;
+        }
+        
+        return isScheduled;
+    }
+    
+    void SubtitleFile::index()
+    {
+        std::vector<EventIndex::Interval> events;
+        
+        try
+        {
+            m_formatCtx = avformat_alloc_context();
+            CHECK(m_formatCtx, "SubtitleFile::index() - out of memory");
+            m_formatCtx->interrupt_callback.callback = &SubtitleFile::shouldInterrupt;
+            m_formatCtx->interrupt_callback.opaque = this;
+            
+            // Text subtitle demuxers read the whole file while opening, that's why it's done here too
+            int err = avformat_open_input(&m_formatCtx, m_sourceFile.c_str(), nullptr, nullptr);
+            CHECK0(err, "SubtitleFile::index() - error while opening subtitles: " + m_sourceFile);
+            
+            err = avformat_find_stream_info(m_formatCtx, nullptr);
+            CHECK(err >= 0, "SubtitleFile::index() - error while retreiving subtitles information");
+            
+            const int streamIndex = av_find_best_stream(m_formatCtx, AVMEDIA_TYPE_SUBTITLE, -1, -1, nullptr, 0);
+            CHECK(streamIndex >= 0, "SubtitleFile::index() - no subtitle stream in " + m_sourceFile);
+            m_avStream = m_formatCtx->streams[streamIndex];
+            
+            AVPacket packet;
+            av_init_packet(&packet);
+            
+            while (!m_shouldStop && av_read_frame(m_formatCtx, &packet) >= 0)
+            {
+                if (packet.stream_index == streamIndex && packet.pts != AV_NOPTS_VALUE)
+                {
+                    EventIndex::Interval event;
+                    event.start = timestampToTime(packet.pts);
+                    event.end = timestampToTime(packet.pts + std::max(packet.duration, 0));
+                    event.value = packet.pts;
+                    events.push_back(event);
+                }
+                
+                av_free_packet(&packet);
+            }
+        }
+        catch (std::runtime_error& e)
+        {
+            sfeLogError(e.what());
+            
+            if (m_formatCtx)
+                avformat_close_input(&m_formatCtx);
+            
+            m_avStream = nullptr;
+            events.clear();
+        }
+        
+        std::stable_sort(events.begin(), events.end(),
+                         [](const EventIndex::Interval& a, const EventIndex::Interval& b) { return a.start < b.start; });
+        
+        for (std::size_t i = 0; i < events.size(); i++)
+        {
+            // Bitmap subtitles often have no duration, they're displayed until the next one
+            if (events[i].end == events[i].start && i + 1 < events.size())
+                events[i].end = events[i + 1].start;
+            
+            m_events.insert(events[i].start, events[i].end, events[i].value);
+        }
+        
+        if (m_avStream)
+            sfeLogDebug("Indexed " + s(events.size()) + " subtitles in " + m_sourceFile);
+        
+        m_isIndexed = true;
+    }
+    
+    void SubtitleFile::loadStream()
+    {
+        m_thread.join();
+        
+        if (!m_avStream)
+        {
+            m_loadFailed = true;
+            return;
+        }
+        
+        try
+        {
+            // Only the subtitle stream is read from now on
+            for (unsigned int i = 0; i < m_formatCtx->nb_streams; i++)
+            {
+                if (m_formatCtx->streams[i] != m_avStream)
+                    m_formatCtx->streams[i]->discard = AVDISCARD_ALL;
+            }
+            
+            m_stream = std::make_shared<SubtitleStream>(m_formatCtx, m_formatCtx->streams[m_avStream->index], *this,
+                                                        m_timer, m_delegate);
+            m_stream->setRenderingFrame(m_renderingFrame.x, m_renderingFrame.y);
+            
+            if (m_isSelected)
+            {
+                m_stream->connect();
+                
+                // The stream missed the status changes that happened while indexing
+                Timer::Observer& streamObserver = *m_stream;
+                
+                if (m_timer->getStatus() == Playing)
+                    streamObserver.didPlay(*m_timer, Stopped);
+                else if (m_timer->getStatus() == Paused)
+                    streamObserver.didPause(*m_timer, Stopped);
+            }
+        }
+        catch (std::runtime_error& e)
+        {
+            sfeLogError("error while loading subtitles from " + m_sourceFile + ": " + e.what());
+            m_stream.reset();
+            m_loadFailed = true;
+        }
+    }
+    
+    void SubtitleFile::readEvents(sf::Time position)
+    {
+        const sf::Time windowEnd = position + (MemoryAccount::isOverBudget() ? ReducedLookAhead : LookAhead);
+        
+        if (!m_isReading)
+        {
+            // Start from the earliest event still displayed at the given position, if any
+            std::vector<const EventIndex::Interval*> visibleEvents;
+            m_events.findOverlapping(position, visibleEvents);
+            
+            sf::Int64 timestamp = av_rescale_q(position.asMicroseconds(), AV_TIME_BASE_Q, m_avStream->time_base);
+            if (!visibleEvents.empty())
+                timestamp = visibleEvents.front()->value;
+            
+            if (avformat_seek_file(m_formatCtx, m_avStream->index, INT64_MIN, timestamp, timestamp, 0) < 0)
+                sfeLogWarning("Error while seeking subtitles at time " + s(position.asMilliseconds()) + "ms");
+            
+            m_isReading = true;
+            m_endReached = false;
+        }
+        
+        while (!m_endReached)
+        {
+            AVPacket* packet = m_pendingPacket;
+            m_pendingPacket = nullptr;
+            
+            if (!packet)
+            {
+                packet = static_cast<AVPacket*>(av_malloc(sizeof(*packet)));
+                CHECK(packet, "SubtitleFile::readEvents() - out of memory");
+                av_init_packet(packet);
+                
+                if (av_read_frame(m_formatCtx, packet) < 0)
+                {
+                    av_free(packet);
+                    m_endReached = true;
+                    break;
+                }
+            }
+            
+            const sf::Time start = timestampToTime(packet->pts);
+            const sf::Time end = timestampToTime(packet->pts + packet->duration);
+            
+            if (packet->pts != AV_NOPTS_VALUE && start >= windowEnd)
+            {
+                m_pendingPacket = packet;
+                break;
+            }
+            
+            // Events before the playback position are only read when seeking
+            if (packet->stream_index == m_avStream->index && (packet->duration <= 0 || end > position))
+            {
+                m_stream->pushEncodedData(packet);
+            }
+            else
+            {
+                av_free_packet(packet);
+                av_free(packet);
+            }
+        }
+    }
+    
+    void SubtitleFile::resetReading()
+    {
+        if (m_pendingPacket)
+        {
+            av_free_packet(m_pendingPacket);
+            av_free(m_pendingPacket);
+            m_pendingPacket = nullptr;
+        }
+        
+        m_isReading = false;
+    }
+    
+    sf::Time SubtitleFile::timestampToTime(sf::Int64 timestamp) const
+    {
+        return sf::microseconds(av_rescale_q(timestamp, m_avStream->time_base, AV_TIME_BASE_Q));
+    }
+    
+    int SubtitleFile::shouldInterrupt(void* subtitleFile)
+    {
+        return static_cast<SubtitleFile*>(subtitleFile)->m_shouldStop ? 1 : 0;
+    }
+    
+    void SubtitleFile::requestMoreData(Stream& starvingStream)
+    {
+        CHECK(false, "Internal inconcistency - passive streams cannot request data");
+    }
+    
+    void SubtitleFile::resetEndOfFileStatus()
+    {
+        m_endReached = false;
+    }
+    
+    MemoryAccount& SubtitleFile::getMemoryAccount()
+    {
+        return m_memoryAccount;
+    }
+    
+    MemoryUsage SubtitleFile::getMemoryUsage() const
+    {
+        return m_memoryAccount.getUsage();
+    }
+    
+    bool SubtitleFile::didSeek(const Timer& timer, sf::Time oldPosition)
+    {
+        if (m_stream && m_isSelected)
+        {
+            m_stream->flushBuffers();
+            resetReading();
+            readEvents(timer.getOffset());
+        }
+        
+        return true;
+    }
+}
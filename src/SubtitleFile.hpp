@@ -0,0 +1,156 @@
+
+/*
+ *  SubtitleFile.hpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef SFEMOVIE_SUBTITLE_FILE_HPP
+#define SFEMOVIE_SUBTITLE_FILE_HPP
+
+#include "IntervalIndex.hpp"
+#include "Stream.hpp"
+#include "SubtitleStream.hpp"
+#include "Timer.hpp"
+#include <SFML/System.hpp>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+}
+
+namespace sfe
+{
+    /** A subtitle file played along with a media, such as a .srt or .ass file next to a movie
+     *
+     * The file is opened and indexed on a background thread, so that large files don't delay playback.
+     * Only the time interval of each event is kept in memory: the events are read, decoded and rendered
+     * shortly before they're displayed.
+     */
+    class SubtitleFile : public Stream::DataSource, public Timer::Observer
+    {
+    public:
+        /** Start opening and indexing the given file in background
+         *
+         * @param sourceFile the path of the subtitle file
+         * @param timer the timer of the media with which the subtitles are displayed
+         * @param delegate the delegate that displays the subtitles
+         */
+        SubtitleFile(const std::string& sourceFile, std::shared_ptr<Timer> timer, SubtitleStream::Delegate& delegate);
+        
+        /** Stop indexing and close the file
+         */
+        ~SubtitleFile();
+        
+        /** Define the size of the video frame the subtitles are displayed over
+         *
+         * @see SubtitleStream::setRenderingFrame()
+         */
+        void setRenderingFrame(int width, int height);
+        
+        /** Enable or disable the display of the subtitles, it can only be done while the timer is stopped
+         */
+        void setSelected(bool selected);
+        
+        /** @return true if the subtitles are displayed when playing
+         */
+        bool isSelected() const;
+        
+        /** @return the subtitle stream of the file, or nullptr if it's not loaded yet
+         */
+        std::shared_ptr<SubtitleStream> getStream() const;
+        
+        /** Load the subtitle stream once indexing is done, read the events about to be displayed
+         * and update the subtitle stream
+         */
+        void update();
+        
+        /** @see Stream::getTimeUntilNextUpdate()
+         */
+        bool getTimeUntilNextUpdate(sf::Time& delay) const;
+        
+        /** @return the memory used by the buffers of the subtitle stream
+         */
+        MemoryUsage getMemoryUsage() const;
+    
+    private:
+        typedef IntervalIndex<sf::Int64> EventIndex;
+        
+        /** Indexing thread: open the file and read the time interval of all its events
+         */
+        void index();
+        
+        /** Create the subtitle stream from the indexed file, on the thread that displays it
+         */
+        void loadStream();
+        
+        /** Give the subtitle stream the events displayed from the given position and shortly after
+         *
+         * @param position the current playback position
+         */
+        void readEvents(sf::Time position);
+        
+        /** Release the packet that was read ahead and make the next read start from the playback position
+         */
+        void resetReading();
+        
+        /** @return the time of the given timestamp of the subtitle stream
+         */
+        sf::Time timestampToTime(sf::Int64 timestamp) const;
+        
+        static int shouldInterrupt(void* subtitleFile);
+        
+        // Data source interface, subtitle streams are passive and fed by readEvents()
+        void requestMoreData(Stream& starvingStream) override;
+        void resetEndOfFileStatus() override;
+        MemoryAccount& getMemoryAccount() override;
+        
+        // Timer interface
+        bool didSeek(const Timer& timer, sf::Time oldPosition) override;
+        
+        std::string m_sourceFile;
+        std::shared_ptr<Timer> m_timer;
+        SubtitleStream::Delegate& m_delegate;
+        sf::Vector2i m_renderingFrame;
+        bool m_isSelected;
+        
+        // Written by the indexing thread until m_isIndexed is set, by the updating thread afterwards
+        AVFormatContext* m_formatCtx;
+        AVStream* m_avStream;
+        EventIndex m_events;
+        std::atomic<bool> m_isIndexed;
+        std::atomic<bool> m_shouldStop;
+        std::thread m_thread;
+        
+        // Declared before the stream that counts its buffers in it
+        MemoryAccount m_memoryAccount;
+        std::shared_ptr<SubtitleStream> m_stream;
+        bool m_loadFailed;
+        bool m_isReading;
+        bool m_endReached;
+        AVPacket* m_pendingPacket;
+    };
+}
+
+#endif
@@ -30,11 +30,21 @@ extern "C"
 
 #include <sfeMovie/Movie.hpp>
 #include "SubtitleStream.hpp"
+#include "ImageKernels.hpp"
 #include "Log.hpp"
+#include "DecodeScheduler.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <cassert>
 #include <cstdint>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
 
 namespace sfe
 {
@@ -67,72 +77,603 @@ namespace sfe
         
         ASSLibrary()
         : library(ass_library_init())
-        , renderer(ass_renderer_init(library))
         {
             CHECK(library, "Failed initializing ASS library");
-            CHECK(renderer, "Failed initializing ASS renderer");
             ass_set_message_cb(library, assLogger, nullptr);
-            ass_set_fonts(renderer, NULL, NULL , 1, NULL, 1);
-            ass_set_margins(renderer, 10, 0, 0, 0);
         }
         
         ~ASSLibrary()
         {
-            ass_renderer_done(renderer);
             ass_library_done(library);
         }
         
         ASS_Library* library;
-        ASS_Renderer* renderer;
+        
+        // Tracks and renderers are created and destroyed from several threads
+        std::mutex mutex;
     private:
         
         static std::weak_ptr<ASSLibrary> sharedInstance;
     };
     
     std::weak_ptr<ASSLibrary> ASSLibrary::sharedInstance;
-    
+
 #endif
     
     const int RGBASize = 4;
     
-    SubtitleStream::SubtitleStream(AVFormatContext*& formatCtx, AVStream*& stream, DataSource& dataSource, std::shared_ptr<Timer> timer, Delegate& delegate) :
-    Stream(formatCtx, stream, dataSource, timer),
-    m_delegate(delegate)
+    namespace
+    {
+        /** A paletted subtitle bitmap copied from FFmpeg's buffers, so that it can be converted in background
+         */
+        struct PalettedBitmap
+        {
+            sf::Vector2i position;
+            sf::Vector2u size;
+            std::vector<sf::Uint8> indices;
+            sf::Uint32 palette[256]; // premultiplied RGBA
+        };
+        
+        std::shared_ptr<const std::vector<SubtitleAtlas::Image> > convertBitmaps(const std::vector<PalettedBitmap>& bitmaps)
+        {
+            std::shared_ptr<std::vector<SubtitleAtlas::Image> > images =
+                std::make_shared<std::vector<SubtitleAtlas::Image> >(bitmaps.size());
+            
+            for (std::size_t i = 0; i < bitmaps.size(); i++)
+            {
+                const PalettedBitmap& bitmap = bitmaps[i];
+                SubtitleAtlas::Image& image = (*images)[i];
+                image.position = bitmap.position;
+                image.size = bitmap.size;
+                image.pixels.resize(bitmap.indices.size() * RGBASize);
+                
+                ImageKernels::expandPalette(bitmap.indices.data(), bitmap.indices.size(), bitmap.palette,
+                                            image.pixels.data());
+            }
+            
+            return images;
+        }
+    }
+    
+    /** Converts the bitmap subtitles of a stream on a background thread, when there are no decoding
+     * threads to leave them to
+     */
+    class BitmapConversionWorker
+    {
+    public:
+        BitmapConversionWorker()
+        : m_shouldStop(false)
+        {
+            m_thread = std::thread(&BitmapConversionWorker::run, this);
+        }
+        
+        ~BitmapConversionWorker()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_queueMutex);
+                m_shouldStop = true;
+            }
+            
+            m_workCondition.notify_one();
+            m_thread.join();
+        }
+        
+        /** Queue a conversion, they're run in submission order
+         */
+        void submit(std::function<void()> task)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_queueMutex);
+                m_queue.push_back(std::move(task));
+            }
+            
+            m_workCondition.notify_one();
+        }
+        
+        /** Drop the conversions that didn't start yet
+         */
+        void flush()
+        {
+            std::lock_guard<std::mutex> lock(m_queueMutex);
+            m_queue.clear();
+        }
+        
+    private:
+        /** Worker thread loop
+         */
+        void run()
+        {
+            while (true)
+            {
+                std::function<void()> task;
+                
+                {
+                    std::unique_lock<std::mutex> lock(m_queueMutex);
+                    m_workCondition.wait(lock, [this] { return m_shouldStop || !m_queue.empty(); });
+                    
+                    if (m_shouldStop)
+                        return;
+                    
+                    task = std::move(m_queue.front());
+                    m_queue.pop_front();
+                }
+                
+                task();
+            }
+        }
+        
+        std::mutex m_queueMutex;
+        std::condition_variable m_workCondition;
+        std::deque<std::function<void()> > m_queue;
+        bool m_shouldStop;
+        std::thread m_thread;
+    };
+
 #ifdef SFEMOVIE_ENABLE_ASS_SUBTITLES
-    ,
-    m_ass(ASSLibrary::instance()),
-    m_track(nullptr)
+    namespace
+    {
+        /** Layers that overlap each other, composited into a single image
+         */
+        struct LayerGroup
+        {
+            sf::IntRect bounds;
+            std::vector<std::size_t> layers; // indices in drawing order
+        };
+        
+        sf::IntRect unite(const sf::IntRect& a, const sf::IntRect& b)
+        {
+            const int left = std::min(a.left, b.left);
+            const int top = std::min(a.top, b.top);
+            const int right = std::max(a.left + a.width, b.left + b.width);
+            const int bottom = std::max(a.top + a.height, b.top + b.height);
+            
+            return sf::IntRect(left, top, right - left, bottom - top);
+        }
+        
+        /** Composite the libass layers into premultiplied RGBA images
+         *
+         * Text outline, shadow and fill are separate layers of a single color each, drawn over each
+         * other. Compositing overlapping layers gives one image per block of text instead of one
+         * per layer, while layers that are apart don't produce a large, mostly transparent image.
+         */
+        void composeLayers(const ASS_Image* firstLayer, std::vector<SubtitleAtlas::Image>& images)
+        {
+            std::vector<const ASS_Image*> layers;
+            std::vector<LayerGroup> groups;
+            
+            for (const ASS_Image* layer = firstLayer; layer; layer = layer->next)
+            {
+                if (layer->w == 0 || layer->h == 0)
+                    continue;
+                
+                LayerGroup group;
+                group.bounds = sf::IntRect(layer->dst_x, layer->dst_y, layer->w, layer->h);
+                group.layers.push_back(layers.size());
+                layers.push_back(layer);
+                
+                // Merge all the groups the layer overlaps, merging may make the group overlap further ones
+                bool merged = true;
+                while (merged)
+                {
+                    merged = false;
+                    
+                    for (std::vector<LayerGroup>::iterator it = groups.begin(); it != groups.end(); ++it)
+                    {
+                        if (it->bounds.intersects(group.bounds))
+                        {
+                            group.bounds = unite(group.bounds, it->bounds);
+                            group.layers.insert(group.layers.end(), it->layers.begin(), it->layers.end());
+                            groups.erase(it);
+                            merged = true;
+                            break;
+                        }
+                    }
+                }
+                
+                std::sort(group.layers.begin(), group.layers.end());
+                groups.push_back(group);
+            }
+            
+            for (const LayerGroup& group : groups)
+            {
+                images.push_back(SubtitleAtlas::Image());
+                SubtitleAtlas::Image& image = images.back();
+                image.position = sf::Vector2i(group.bounds.left, group.bounds.top);
+                image.size = sf::Vector2u(group.bounds.width, group.bounds.height);
+                image.pixels.assign(image.size.x * image.size.y * RGBASize, 0);
+                
+                for (std::size_t index : group.layers)
+                {
+                    const ASS_Image& layer = *layers[index];
+                    const sf::Uint8 color[4] =
+                    {
+                        static_cast<sf::Uint8>(layer.color >> 24),
+                        static_cast<sf::Uint8>(layer.color >> 16 & 255),
+                        static_cast<sf::Uint8>(layer.color >> 8 & 255),
+                        static_cast<sf::Uint8>(255 - (layer.color & 255))
+                    };
+                    
+                    const int left = layer.dst_x - group.bounds.left;
+                    const int top = layer.dst_y - group.bounds.top;
+                    
+                    for (int y = 0; y < layer.h; ++y)
+                    {
+                        sf::Uint8* row = &image.pixels[((top + y) * image.size.x + left) * RGBASize];
+                        ImageKernels::blendCoverage(layer.bitmap + y * layer.stride, layer.w, color, row);
+                    }
+                }
+            }
+        }
+    }
+    
+    /** A frame rendered ahead of the moment it is displayed
+     */
+    struct ASSFrame
+    {
+        enum State
+        {
+            Pending,
+            Rendering,
+            Rendered
+        };
+        
+        ASSFrame(sf::Time time)
+        : time(time)
+        , state(Pending)
+        , revision(0)
+        , images()
+        {
+        }
+        
+        sf::Time time;
+        State state;
+        
+        // Incremented when an event covering the frame is added while it's being rendered
+        unsigned int revision;
+        std::shared_ptr<const std::vector<SubtitleAtlas::Image> > images;
+    };
+    
+    /** Renders ASS subtitle frames on a background thread, as soon as their events are decoded
+     *
+     * libass tracks and renderers are not thread safe, all their uses go through this class.
+     * A frame is rendered at each time an event appears or disappears, as the displayed frame only
+     * changes then. Events are not decoded in display order: a frame is rendered again when an event
+     * decoded later covers it. Frames that libass reports unchanged share the previous images.
+     */
+    class ASSRenderWorker
+    {
+    public:
+        ASSRenderWorker(const char* header, int headerSize)
+        : m_library(ASSLibrary::instance())
+        , m_track(nullptr)
+        , m_renderer(nullptr)
+        , m_frameSize(0, 0)
+        , m_lastImages()
+        , m_shouldStop(false)
+        {
+            std::lock_guard<std::mutex> lock(m_library->mutex);
+            
+            m_track = ass_new_track(m_library->library);
+            CHECK(m_track, "Failed initializing ASS track");
+            ass_process_codec_private(m_track, const_cast<char*>(header), headerSize);
+        }
+        
+        ~ASSRenderWorker()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_queueMutex);
+                m_shouldStop = true;
+            }
+            
+            m_workCondition.notify_one();
+            
+            if (m_thread.joinable())
+                m_thread.join();
+            
+            std::lock_guard<std::mutex> lock(m_library->mutex);
+            
+            if (m_renderer)
+                ass_renderer_done(m_renderer);
+            
+            ass_free_track(m_track);
+        }
+        
+        /** Set the size of the video frame the subtitles are rendered for, before any frame is rendered
+         */
+        void setFrameSize(int width, int height)
+        {
+            std::lock_guard<std::mutex> lock(m_renderMutex);
+            m_frameSize = sf::Vector2i(width, height);
+            
+            if (m_renderer)
+                ass_set_frame_size(m_renderer, width, height);
+        }
+        
+        /** Add a decoded event to the track and request the frames it changes to be rendered in background
+         *
+         * @param data the ASS event line
+         * @param size the size of @a data
+         * @param start the time at which the event appears
+         * @param end the time at which the event disappears
+         */
+        void addEvent(char* data, int size, sf::Time start, sf::Time end)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_renderMutex);
+                ass_process_data(m_track, data, size);
+            }
+            
+            {
+                std::lock_guard<std::mutex> lock(m_queueMutex);
+                
+                requestFrame(start);
+                requestFrame(end);
+                
+                for (FrameMap::iterator it = m_frames.lower_bound(start); it != m_frames.end() && it->first < end; ++it)
+                    invalidate(it->second);
+                
+                if (!m_thread.joinable())
+                    m_thread = std::thread(&ASSRenderWorker::run, this);
+            }
+            
+            m_workCondition.notify_one();
+        }
+        
+        /** Remove all the events and forget the requested frames
+         */
+        void flush()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_queueMutex);
+                m_frames.clear();
+                m_queue.clear();
+            }
+            
+            std::lock_guard<std::mutex> lock(m_renderMutex);
+            ass_flush_events(m_track);
+            m_lastImages.reset();
+        }
+        
+        /** Get the images to display at the given time, rendering them right now if the worker didn't yet
+         *
+         * The frames displayed before the given time are released, as time only goes forward until
+         * the next flush
+         *
+         * @param time the playback position
+         * @return the images to display, or null if no frame was requested before @a time
+         */
+        std::shared_ptr<const std::vector<SubtitleAtlas::Image> > getImages(sf::Time time)
+        {
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+            FrameMap::iterator it = m_frames.upper_bound(time);
+            
+            if (it == m_frames.begin())
+                return nullptr;
+            
+            --it;
+            m_frames.erase(m_frames.begin(), it);
+            std::shared_ptr<ASSFrame> frame = it->second;
+            
+            while (frame->state != ASSFrame::Rendered)
+            {
+                if (frame->state == ASSFrame::Pending)
+                {
+                    frame->state = ASSFrame::Rendering;
+                    const unsigned int revision = frame->revision;
+                    lock.unlock();
+                    
+                    sfeLogDebug("Subtitle frame at " + s(frame->time.asSeconds()) + "s was not rendered in advance");
+                    std::shared_ptr<const std::vector<SubtitleAtlas::Image> > images = render(frame->time);
+                    
+                    lock.lock();
+                    finishRendering(frame, revision, images);
+                }
+                else
+                {
+                    m_renderedCondition.wait(lock);
+                }
+            }
+            
+            return frame->images;
+        }
+    
+    private:
+        /** Worker thread loop
+         */
+        void run()
+        {
+            while (true)
+            {
+                std::shared_ptr<ASSFrame> frame;
+                unsigned int revision = 0;
+                
+                {
+                    std::unique_lock<std::mutex> lock(m_queueMutex);
+                    m_workCondition.wait(lock, [this] { return m_shouldStop || !m_queue.empty(); });
+                    
+                    if (m_shouldStop)
+                        return;
+                    
+                    frame = m_queue.front().lock();
+                    m_queue.pop_front();
+                    
+                    if (!frame || frame->state != ASSFrame::Pending)
+                        continue;
+                    
+                    frame->state = ASSFrame::Rendering;
+                    revision = frame->revision;
+                }
+                
+                std::shared_ptr<const std::vector<SubtitleAtlas::Image> > images = render(frame->time);
+                
+                {
+                    std::lock_guard<std::mutex> lock(m_queueMutex);
+                    finishRendering(frame, revision, images);
+                }
+                
+                m_renderedCondition.notify_all();
+            }
+        }
+        
+        /** Create the frame at the given time if it wasn't requested yet, m_queueMutex must be locked
+         */
+        void requestFrame(sf::Time time)
+        {
+            std::shared_ptr<ASSFrame>& frame = m_frames[time];
+            
+            if (!frame)
+            {
+                frame = std::make_shared<ASSFrame>(time);
+                m_queue.push_back(frame);
+            }
+        }
+        
+        /** Render the given frame again as it misses an event, m_queueMutex must be locked
+         */
+        void invalidate(const std::shared_ptr<ASSFrame>& frame)
+        {
+            if (frame->state == ASSFrame::Rendered)
+            {
+                frame->state = ASSFrame::Pending;
+                frame->images.reset();
+                m_queue.push_back(frame);
+            }
+            else if (frame->state == ASSFrame::Rendering)
+            {
+                frame->revision++;
+            }
+        }
+        
+        /** Store the rendered images unless an event was added meanwhile, m_queueMutex must be locked
+         *
+         * @param revision the revision of the frame when its rendering started
+         */
+        void finishRendering(const std::shared_ptr<ASSFrame>& frame, unsigned int revision,
+                             std::shared_ptr<const std::vector<SubtitleAtlas::Image> > images)
+        {
+            if (frame->revision != revision)
+            {
+                frame->state = ASSFrame::Pending;
+                m_queue.push_back(frame);
+            }
+            else
+            {
+                frame->images = images;
+                frame->state = ASSFrame::Rendered;
+            }
+        }
+        
+        /** Render the frame at the given time, the previous images are reused if libass reports no change
+         */
+        std::shared_ptr<const std::vector<SubtitleAtlas::Image> > render(sf::Time time)
+        {
+            std::lock_guard<std::mutex> lock(m_renderMutex);
+            
+            if (!m_renderer)
+            {
+                // Loading the fonts is slow, it's done by the first rendering, normally on the worker thread
+                std::lock_guard<std::mutex> libraryLock(m_library->mutex);
+                
+                m_renderer = ass_renderer_init(m_library->library);
+                
+                if (!m_renderer)
+                {
+                    sfeLogError("Failed initializing ASS renderer, subtitles won't be displayed");
+                    return std::make_shared<std::vector<SubtitleAtlas::Image> >();
+                }
+                
+                ass_set_fonts(m_renderer, NULL, NULL , 1, NULL, 1);
+                ass_set_margins(m_renderer, 10, 0, 0, 0);
+                ass_set_frame_size(m_renderer, m_frameSize.x, m_frameSize.y);
+            }
+            
+            int changed = 0;
+            ASS_Image* layers = ass_render_frame(m_renderer, m_track, time.asMilliseconds(), &changed);
+            
+            if (changed || !m_lastImages)
+            {
+                std::shared_ptr<std::vector<SubtitleAtlas::Image> > images =
+                    std::make_shared<std::vector<SubtitleAtlas::Image> >();
+                composeLayers(layers, *images);
+                m_lastImages = images;
+            }
+            
+            return m_lastImages;
+        }
+        
+        std::shared_ptr<ASSLibrary> m_library;
+        
+        // Used by the worker thread and by the thread updating the stream
+        std::mutex m_renderMutex;
+        ASS_Track* m_track;
+        ASS_Renderer* m_renderer;
+        sf::Vector2i m_frameSize;
+        std::shared_ptr<const std::vector<SubtitleAtlas::Image> > m_lastImages;
+        
+        typedef std::map<sf::Time, std::shared_ptr<ASSFrame> > FrameMap;
+        
+        std::mutex m_queueMutex;
+        std::condition_variable m_workCondition;
+        std::condition_variable m_renderedCondition;
+        FrameMap m_frames;
+        std::deque<std::weak_ptr<ASSFrame> > m_queue;
+        bool m_shouldStop;
+        std::thread m_thread;
+    };
+
+
 #endif
+    
+    SubtitleStream::SubtitleStream(AVFormatContext*& formatCtx, AVStream*& stream, DataSource& dataSource, std::shared_ptr<Timer> timer, Delegate& delegate) :
+    Stream(formatCtx, stream, dataSource, timer),
+    m_delegate(delegate),
+    m_atlas(),
+    m_displayedImages(),
+    m_renderWorker(nullptr),
+    m_renderingFrame(0, 0),
+    m_conversionWorker(nullptr),
+    m_hasNextChange(false),
+    m_nextChangePosition(sf::Time::Zero),
+    m_hasPendingWipeOut(false)
     {
         const AVCodecDescriptor* desc = av_codec_get_codec_descriptor(m_stream->codec);
         CHECK(desc != NULL, "Could not get the codec descriptor!");
         
+#ifndef SFEMOVIE_ENABLE_ASS_SUBTITLES
         if((desc->props & AV_CODEC_PROP_BITMAP_SUB) == 0)
         {
-#ifdef SFEMOVIE_ENABLE_ASS_SUBTITLES
-            m_track    = ass_new_track(m_ass->library);
-            CHECK(m_track, "Failed initializing ASS track");
-            
-            ass_process_codec_private(m_track, reinterpret_cast<char*>(m_stream->codec->subtitle_header),
-                                      m_stream->codec->subtitle_header_size);
-#else
             throw std::runtime_error("Non-bitmap subtitle stream detected but ASS support is disabled. Cannot use stream.");
-#endif
         }
+#endif
     }
     
     SubtitleStream::~SubtitleStream()
     {
+    }
+    
+    void SubtitleStream::didOpenDecoder()
+    {
 #ifdef SFEMOVIE_ENABLE_ASS_SUBTITLES
-        if (m_track)
-            ass_free_track(m_track);
+        const AVCodecDescriptor* desc = av_codec_get_codec_descriptor(m_stream->codec);
+        
+        // Text decoders generate the ASS header when they're opened. The worker is kept when the decoder
+        // is closed as the decoded subtitles refer to it
+        if (!m_renderWorker && (desc->props & AV_CODEC_PROP_BITMAP_SUB) == 0)
+        {
+            m_renderWorker = std::make_shared<ASSRenderWorker>(reinterpret_cast<char*>(m_stream->codec->subtitle_header),
+                                                               m_stream->codec->subtitle_header_size);
+            m_renderWorker->setFrameSize(m_renderingFrame.x, m_renderingFrame.y);
+        }
 #endif
     }
     
     void SubtitleStream::setRenderingFrame(int width, int height)
     {
+        m_renderingFrame = sf::Vector2i(width, height);
+        
 #ifdef SFEMOVIE_ENABLE_ASS_SUBTITLES
-        ass_set_frame_size(m_ass->renderer, width, height);
+        if (m_renderWorker)
+            m_renderWorker->setFrameSize(width, height);
 #endif
     }
     
@@ -143,6 +684,13 @@ namespace sfe
     
     void SubtitleStream::update()
     {
+        // Seeking may flush the buffers from another thread, the delegate is only told from here
+        if (m_hasPendingWipeOut)
+        {
+            m_delegate.didWipeOutSubtitles(*this);
+            m_hasPendingWipeOut = false;
+        }
+        
         //only get new subtitles if we are running low
         if (m_status == Playing && hasPackets())
         {
@@ -150,86 +698,90 @@ namespace sfe
                 setStatus(Stopped);
         }
         
-        if (!m_pendingSubtitles.empty())
+        const sf::Time position = m_timer->getOffset();
+        std::vector<std::shared_ptr<SubtitleData> > visibleSubtitles;
+        
+        m_subtitles.findOverlapping(position, m_overlappingSubtitles);
+        for (const SubtitleIndex::Interval* interval : m_overlappingSubtitles)
+            visibleSubtitles.push_back(interval->value);
+        
+        if (visibleSubtitles.empty())
         {
-            //activate subtitle
-            if (m_pendingSubtitles.front()->start < m_timer->getOffset())
+            if (!m_visibleSubtitles.empty())
             {
-                std::shared_ptr<SubtitleData> subtitle = m_pendingSubtitles.front();
-                
+                m_delegate.didWipeOutSubtitles(*this);
+                m_displayedImages.reset();
+            }
+        }
 #ifdef SFEMOVIE_ENABLE_ASS_SUBTITLES
-                //this is the case for ass subtitles
-                if (subtitle->type == ASS)
-                {
-                    int changed = 0;
-                    CHECK(m_track, "Internal inconcistency - null track");
-                    ASS_Image* layer = ass_render_frame(m_ass->renderer, m_track,
-                                                        m_timer->getOffset().asMilliseconds(),
-                                                        &changed);
-                    
-                    if (changed)
-                    {
-                        
-                        for (; layer; layer = layer->next)
-                        {
-                            if (layer->w == 0 || layer->h == 0)
-                                continue;
-                            
-                            const uint8_t red   =   layer->color >> 24;
-                            const uint8_t green =   layer->color >> 16 & 255;
-                            const uint8_t blue  =   layer->color >> 8 & 255;
-                            const uint8_t alpha =   255 - (layer->color & 255);
-                            
-                            sf::Image image;
-                            image.create(layer->w, layer->h);
-                            
-                            for (int y = 0; y < layer->h; ++y)
-                            {
-                                const unsigned char *map = layer->bitmap + y * layer->stride;
-                                
-                                for (int x = 0; x < layer->w; ++x)
-                                {
-                                    const uint8_t mappedAlpha = ((unsigned)alpha * *map++)/255;
-                                    image.setPixel(x, y, sf::Color(red, green, blue, mappedAlpha));
-                                }
-                            }
-                            
-                            subtitle->positions.push_back(sf::Vector2i(layer->dst_x, layer->dst_y));
-                            subtitle->sprites.push_back(sf::Sprite());
-                            subtitle->textures.push_back(sf::Texture());
-                            
-                            sf::Sprite& sprite = subtitle->sprites.back();
-                            sf::Texture& texture = subtitle->textures.back();
-                            
-                            texture.loadFromImage(image);
-                            texture.setSmooth(true);
-                            sprite.setTexture(texture);
-                        }
-                    }
-                }
-#endif
+        else if (m_renderWorker)
+        {
+            // libass renders all the events visible at a given time into a single frame
+            std::shared_ptr<const std::vector<SubtitleAtlas::Image> > frameImages = m_renderWorker->getImages(position);
+            
+            // Unchanged frames share their images, they're already displayed
+            if (frameImages && frameImages != m_displayedImages)
+            {
+                std::vector<const SubtitleAtlas::Image*> images;
+                for (const SubtitleAtlas::Image& image : *frameImages)
+                    images.push_back(&image);
                 
-                m_delegate.didUpdateSubtitle(*this, subtitle->sprites, subtitle->positions);
-                m_visibleSubtitles.push_back(subtitle);
-                m_pendingSubtitles.pop_front();
+                display(images);
+                m_displayedImages = frameImages;
             }
         }
+#endif
+        else if (visibleSubtitles != m_visibleSubtitles)
+        {
+            // Bitmap subtitles that overlap in time are displayed together
+            std::vector<const SubtitleAtlas::Image*> images;
+            for (const std::shared_ptr<SubtitleData>& subtitle : visibleSubtitles)
+            {
+                for (const SubtitleAtlas::Image& image : subtitle->getImages())
+                    images.push_back(&image);
+            }
+            
+            display(images);
+        }
         
-        
-        if (!m_visibleSubtitles.empty())
+        // The displayed subtitles change when one of them ends or when the next one starts
+        m_hasNextChange = m_subtitles.findNextStart(position, m_nextChangePosition);
+        for (const SubtitleIndex::Interval* interval : m_overlappingSubtitles)
         {
-            //remove subtitle
-            if (m_visibleSubtitles.front()->end < m_timer->getOffset())
+            if (!m_hasNextChange || interval->end < m_nextChangePosition)
             {
-                std::shared_ptr<SubtitleData> subtitle = m_visibleSubtitles.front();
-                m_visibleSubtitles.pop_front();
-                
-                if (m_visibleSubtitles.empty())
-                {
-                    m_delegate.didWipeOutSubtitles(*this);
-                }
+                m_hasNextChange = true;
+                m_nextChangePosition = interval->end;
             }
         }
+        
+        m_visibleSubtitles.swap(visibleSubtitles);
+        m_subtitles.eraseEndingBefore(position);
+    }
+    
+    bool SubtitleStream::getTimeUntilNextUpdate(sf::Time& delay) const
+    {
+        if (m_status != Playing)
+            return false;
+        
+        // Queued packets are decoded by the next update
+        if (hasPackets())
+        {
+            delay = sf::Time::Zero;
+            return true;
+        }
+        
+        if (!m_hasNextChange)
+            return false;
+        
+        delay = std::max(m_nextChangePosition - m_timer->getOffset(), sf::Time::Zero);
+        return true;
+    }
+    
+    void SubtitleStream::display(const std::vector<const SubtitleAtlas::Image*>& images)
+    {
+        m_atlas.update(images);
+        m_delegate.didUpdateSubtitle(*this, m_atlas.getVertices(), m_atlas.getTexture());
     }
     
     bool SubtitleStream::isPassive() const
@@ -254,8 +806,16 @@ namespace sfe
                 bool needsMoreDecoding = false;
                 
                 CHECK(packet != nullptr, "inconsistency error");
+                sf::Clock clock;
                 goOn = avcodec_decode_subtitle2(m_stream->codec, &sub, &gotSub, packet);
                 
+                if (gotSub)
+                {
+                    std::lock_guard<std::mutex> lock(m_statsMutex);
+                    m_stats.framesDecoded++;
+                    m_stats.decodeTime.add(clock.getElapsedTime());
+                }
+                
                 pts = 0;
                 if (packet->pts != AV_NOPTS_VALUE)
                     pts = packet->pts;
@@ -263,10 +823,11 @@ namespace sfe
                 if (gotSub && pts)
                 {
                     bool succeeded = false;
-                    std::shared_ptr<SubtitleData> sfeSub = std::make_shared<SubtitleData>(&sub, succeeded, m_track);
+                    std::shared_ptr<SubtitleData> sfeSub = std::make_shared<SubtitleData>(&sub, succeeded,
+                                                                                          m_renderWorker.get(), *this);
                     
                     if (succeeded)
-                        m_pendingSubtitles.push_back(sfeSub);
+                        m_subtitles.insert(sfeSub->start, sfeSub->end, sfeSub);
                 }
                 
                 if (needsMoreDecoding)
@@ -290,8 +851,11 @@ namespace sfe
     }
     
     
-    SubtitleStream::SubtitleData::SubtitleData(AVSubtitle* sub, bool& succeeded, ASS_Track* track)
+    SubtitleStream::SubtitleData::SubtitleData(AVSubtitle* sub, bool& succeeded, ASSRenderWorker* renderWorker,
+                                               SubtitleStream& stream)
     {
+        std::vector<PalettedBitmap> bitmaps;
+        
         assert(sub != nullptr);
         
         succeeded = false;
@@ -305,31 +869,33 @@ namespace sfe
             if (subItem->type == SUBTITLE_BITMAP)
             {
                 type = BITMAP;
-                sprites.push_back(sf::Sprite());
-                textures.push_back(sf::Texture());
-                
-                sf::Sprite& sprite = sprites.back();
-                sf::Texture& texture = textures.back();
                 
                 CHECK(subItem->pict.data[0] != nullptr, "FFmpeg inconcistency error");
                 CHECK(subItem->pict.data[1] != nullptr, "FFmpeg inconcistency error");
                 CHECK(subItem->w * subItem->h > 0, "FFmpeg inconcistency error");
                 
-                positions.push_back(sf::Vector2i(subItem->x, subItem->y));
-                
-                std::unique_ptr<uint32_t[]> palette(new uint32_t[subItem->nb_colors]);
-                for (int j = 0; j < subItem->nb_colors; j++)
-                    palette[j] = *(uint32_t*)&subItem->pict.data[1][j * RGBASize];
+                bitmaps.push_back(PalettedBitmap());
+                PalettedBitmap& bitmap = bitmaps.back();
+                bitmap.position = sf::Vector2i(subItem->x, subItem->y);
+                bitmap.size = sf::Vector2u(subItem->w, subItem->h);
+                bitmap.indices.resize(subItem->w * subItem->h);
                 
-                texture.create(subItem->w, subItem->h);
-                texture.setSmooth(true);
-                
-                std::unique_ptr<uint32_t[]> data(new uint32_t[subItem->w* sub->rects[i]->h]);
-                for (int j = 0; j < subItem->w * subItem->h; ++j)
-                    data[j] = palette[subItem->pict.data[0][j]];
+                for (int y = 0; y < subItem->h; ++y)
+                {
+                    std::memcpy(&bitmap.indices[y * subItem->w], subItem->pict.data[0] + y * subItem->pict.linesize[0],
+                                subItem->w);
+                }
                 
-                texture.update((uint8_t*)data.get());
-                sprite.setTexture(texture);
+                // Premultiply the palette rather than each pixel
+                std::memset(bitmap.palette, 0, sizeof(bitmap.palette));
+                for (int j = 0; j < std::min(subItem->nb_colors, 256); j++)
+                {
+                    sf::Uint8* color = reinterpret_cast<sf::Uint8*>(&bitmap.palette[j]);
+                    std::memcpy(color, &subItem->pict.data[1][j * RGBASize], RGBASize);
+                    
+                    for (int channel = 0; channel < 3; channel++)
+                        color[channel] = ImageKernels::divideBy255(color[channel] * color[3]);
+                }
                 
                 succeeded = true;
             }
@@ -337,25 +903,72 @@ namespace sfe
             else
             {
                 type = ASS;
-                CHECK(track, "Internal inconcistency - null track");
-                ass_process_data(track, subItem->ass, strlen(subItem->ass));
+                CHECK(renderWorker, "Internal inconcistency - null render worker");
+                renderWorker->addEvent(subItem->ass, static_cast<int>(strlen(subItem->ass)), start, end);
                 
                 succeeded = true;
             }
 #endif
         }
+        
+        // Full screen bitmaps take a few milliseconds to convert, don't do it on the thread updating the stream
+        if (succeeded && type == BITMAP)
+        {
+            typedef std::shared_ptr<const std::vector<SubtitleAtlas::Image> > Images;
+            std::shared_ptr<std::packaged_task<Images()> > task =
+                std::make_shared<std::packaged_task<Images()> >(std::bind(convertBitmaps, std::move(bitmaps)));
+            
+            conversion = task->get_future();
+            stream.convertInBackground([task]() { (*task)(); });
+        }
+    }
+    
+    void SubtitleStream::convertInBackground(std::function<void()> task)
+    {
+        DecodeScheduler& scheduler = DecodeScheduler::getInstance();
+        
+        // The scheduler runs the tasks inline when it has no workers
+        if (scheduler.getWorkerCount() > 0)
+        {
+            scheduler.submit(this, 0, DecodeScheduler::Clock::now(), std::move(task));
+        }
+        else
+        {
+            if (!m_conversionWorker)
+                m_conversionWorker = std::make_shared<BitmapConversionWorker>();
+            
+            m_conversionWorker->submit(std::move(task));
+        }
+    }
+    
+    const std::vector<SubtitleAtlas::Image>& SubtitleStream::SubtitleData::getImages()
+    {
+        if (conversion.valid())
+            images = conversion.get();
+        
+        return *images;
     }
     
     void SubtitleStream::flushBuffers()
     {
-        m_delegate.didWipeOutSubtitles(*this);
+        m_hasPendingWipeOut = true;
         Stream::flushBuffers();
-        m_pendingSubtitles.clear();
-        m_visibleSubtitles.clear();
         
+        // The dropped subtitles don't need their images anymore
+        DecodeScheduler::getInstance().cancel(this);
+        
+        if (m_conversionWorker)
+            m_conversionWorker->flush();
+        
+        m_subtitles.clear();
+        m_visibleSubtitles.clear();
+        m_atlas.clear();
+        m_displayedImages.reset();
+        m_hasNextChange = false;
+
 #ifdef SFEMOVIE_ENABLE_ASS_SUBTITLES
-        if (m_track)
-            ass_flush_events(m_track);
+        if (m_renderWorker)
+            m_renderWorker->flush();
 #endif
     }
     
@@ -366,25 +979,8 @@ namespace sfe
             onGetData();
         }
         
-        std::list< std::shared_ptr<SubtitleData>>::iterator it = m_visibleSubtitles.begin();
-        while (it != m_visibleSubtitles.end())
-        {
-            //erase subs that are deleted before the targetPosition
-            if (it->get()->end<targetPosition)
-                it = m_visibleSubtitles.erase(it);
-            else
-                ++it;
-        }
-        
-        it = m_pendingSubtitles.begin();
-        while (it != m_pendingSubtitles.end())
-        {
-            //erase subs that are deleted before the targetPosition
-            if (it->get()->end<targetPosition)
-                it = m_pendingSubtitles.erase(it);
-            else
-                ++it;
-        }
+        // Subtitles are looked up by time, the ones that ended are only kept until the next update
+        m_subtitles.eraseEndingBefore(targetPosition);
         
         return true;
     }
@@ -28,9 +28,14 @@
 
 #include "Macros.hpp"
 #include "Stream.hpp"
+#include "SubtitleAtlas.hpp"
+#include "IntervalIndex.hpp"
 #include <SFML/Graphics.hpp>
-#include <list>
+#include <functional>
+#include <future>
+#include <memory>
 #include <utility>
+#include <vector>
 
 extern "C"
 {
@@ -43,7 +48,8 @@ extern "C"
 
 namespace sfe
 {
-    class ASSLibrary;
+    class ASSRenderWorker;
+    class BitmapConversionWorker;
     
     class SubtitleStream : public Stream
     {
@@ -51,10 +57,16 @@ namespace sfe
         struct Delegate
         {
             /** Triggered by the subtitle stream when a new subtitle is available and should be displayed
+             *
+             * The texture is reused for the next subtitles, it is only valid for displaying the given vertices
+             * until the next call to this method
+             *
+             * @param vertices the quads displaying the subtitle, in video frame coordinates
+             * @param texture the texture to draw the quads with
              */
             virtual void didUpdateSubtitle(const SubtitleStream& sender,
-                                           const std::list<sf::Sprite>& subimages,
-                                           const std::list<sf::Vector2i>& positions) = 0;
+                                           const sf::VertexArray& vertices,
+                                           std::shared_ptr<const sf::Texture> texture) = 0;
             
             /** Triggered by the subtitle stream when buffers are flushed and the subtitles previously
              * sent for display are no more available
@@ -65,7 +77,8 @@ namespace sfe
         /** Create a subtitle stream from the given FFmpeg stream
          *
          * At the end of the constructor, the stream is guaranteed
-         * to have all of its fields set and the decoder loaded
+         * to have all of its fields set, the decoder is loaded
+         * once the stream is connected
          */
         SubtitleStream(AVFormatContext*& formatCtx, AVStream*& stream, DataSource& dataSource, std::shared_ptr<Timer> timer, Delegate& delegate);
         
@@ -90,32 +103,39 @@ namespace sfe
          */
         void update() override;
         
+        /** @see Stream::getTimeUntilNextUpdate()
+         */
+        bool getTimeUntilNextUpdate(sf::Time& delay) const override;
+        
         /** @see Stream::isPassive()
          */
         bool isPassive() const override;
-        
+         
          /** Empty the encoded data queue, destroy all the packets and flush the decoding pipeline
+          *
+          * The delegate is told that the subtitles were wiped out on the next update
          */
         void flushBuffers() override;
         
         /** @see Stream::fastForward()
          */
         bool fastForward(sf::Time targetPosition) override;
-        
+    
     private:
         enum SubtitleType
         {
             BITMAP  = 0,
             ASS     = 1,
         };
-
+        
         /** The struct we use to store our subtitles
          */
         struct SubtitleData
         {
-            std::list<sf::Texture> textures;
-            std::list<sf::Sprite> sprites;
-            std::list<sf::Vector2i> positions;
+            // Bitmap subtitles are converted to RGBA in background until they're first displayed.
+            // ASS subtitles have no images, they're rendered by frames that may show several events
+            std::future<std::shared_ptr<const std::vector<SubtitleAtlas::Image> > > conversion;
+            std::shared_ptr<const std::vector<SubtitleAtlas::Image> > images;
             //when will it appear (absolute)
             sf::Time start;
             //when will it disappear (absolute)
@@ -127,26 +147,56 @@ namespace sfe
              *
              * @param succeeded Whether this structure contains valid decoded subtitles
              * after construction time
-             * @param track The libass track we write our subtitle to
+             * @param renderWorker The worker rendering the libass track we write our subtitle to
+             * @param stream The stream decoding this subtitle, that converts the bitmaps in background
              */
-            SubtitleData(AVSubtitle* sub, bool& succeeded, ASS_Track* track);
+            SubtitleData(AVSubtitle* sub, bool& succeeded, ASSRenderWorker* renderWorker, SubtitleStream& stream);
+            
+            /** Get the images of a bitmap subtitle, waiting for their conversion if it's not done yet
+             */
+            const std::vector<SubtitleAtlas::Image>& getImages();
         };
         
+        typedef IntervalIndex<std::shared_ptr<SubtitleData> > SubtitleIndex;
+        
         /** Decode the packages that were send to the stream by the demuxer
          *
          * @return if the stream is finished or not
          */
         bool onGetData();
-
+        
+        /** Upload the given images and send them to the delegate
+         */
+        void display(const std::vector<const SubtitleAtlas::Image*>& images);
+        
+        /** Run the given bitmap conversion on the decoding threads, or on this stream's own worker
+         * if there are no decoding threads
+         */
+        void convertInBackground(std::function<void()> task);
+        
+        // Stream interface
+        void didOpenDecoder() override;
+        
         Delegate& m_delegate;
+        SubtitleAtlas m_atlas;
+        std::shared_ptr<const std::vector<SubtitleAtlas::Image> > m_displayedImages;
         
-        std::list< std::shared_ptr<SubtitleData> > m_pendingSubtitles;
-        std::list< std::shared_ptr<SubtitleData> > m_visibleSubtitles;
+        // Decoded subtitles by display interval, and the ones visible at the last update in start order
+        SubtitleIndex m_subtitles;
+        std::vector<const SubtitleIndex::Interval*> m_overlappingSubtitles;
+        std::vector<std::shared_ptr<SubtitleData> > m_visibleSubtitles;
         
-#ifdef SFEMOVIE_ENABLE_ASS_SUBTITLES
-        std::shared_ptr<ASSLibrary> m_ass;
-#endif
-        ASS_Track*      m_track;
+        // Null for bitmap subtitles, created once the decoder generated the ASS header
+        std::shared_ptr<ASSRenderWorker> m_renderWorker;
+        sf::Vector2i m_renderingFrame;
+        
+        // Only created when bitmaps must be converted and there are no decoding threads
+        std::shared_ptr<BitmapConversionWorker> m_conversionWorker;
+        
+        // When the displayed subtitles change next, as far as the decoded subtitles tell
+        bool m_hasNextChange;
+        sf::Time m_nextChangePosition;
+        bool m_hasPendingWipeOut;
     };
     
 };
@@ -25,6 +25,7 @@
 #include "Timer.hpp"
 #include "Macros.hpp"
 #include "Log.hpp"
+#include "TraceSpan.hpp"
 
 namespace sfe
 {
@@ -61,6 +62,7 @@ namespace sfe
     m_pausedTime(sf::Time::Zero),
     m_status(Stopped),
     m_timer(),
+    m_reference(nullptr),
     m_observers()
     {
     }
@@ -90,9 +92,20 @@ namespace sfe
     
     void Timer::play()
     {
-        CHECK(getStatus() != Playing, "Timer::play() - timer playing twice");
+        prepareToPlay();
+        startPlaying();
+    }
+    
+    void Timer::prepareToPlay()
+    {
+        CHECK(getStatus() != Playing, "Timer::prepareToPlay() - timer playing twice");
         
         notifyObservers(Playing);
+    }
+    
+    void Timer::startPlaying()
+    {
+        CHECK(getStatus() != Playing, "Timer::startPlaying() - timer playing twice");
         
         Status oldStatus = getStatus();
         m_status = Playing;
@@ -129,6 +142,7 @@ namespace sfe
     
     bool Timer::seek(sf::Time position)
     {
+        SFE_TRACE_SCOPE("Timer::seek");
         Status oldStatus = getStatus();
         sf::Time oldPosition = getOffset();
         bool couldSeek = false;
@@ -152,14 +166,27 @@ namespace sfe
     
     sf::Time Timer::getOffset() const
     {
+        if (m_reference && Timer::getStatus() != Stopped)
+            return m_reference->getOffset();
+        
         if (Timer::getStatus() == Playing)
             return m_pausedTime + m_timer.getElapsedTime();
         else
             return m_pausedTime;
     }
     
+    void Timer::setReference(std::shared_ptr<const Timer> reference)
+    {
+        // Carry on from the current offset, whatever clock it was read from
+        m_pausedTime = getOffset();
+        m_timer.restart();
+        m_reference = reference;
+    }
+    
     void Timer::notifyObservers(Status futureStatus)
     {
+        SFE_TRACE_SCOPE("Timer::notifyWillChangeStatus");
+        
         for (std::pair<int, std::set<Observer*> >&& pairByPriority : m_observersByPriority)
         {
             for (Observer* observer : pairByPriority.second)
@@ -180,6 +207,7 @@ namespace sfe
     void Timer::notifyObservers(Status oldStatus, Status newStatus)
     {
         CHECK(oldStatus != newStatus, "Timer::notifyObservers() - inconsistency: no change happened");
+        SFE_TRACE_SCOPE("Timer::notifyDidChangeStatus");
         
         for (std::pair<int, std::set<Observer*> >&& pairByPriority : m_observersByPriority)
         {
@@ -208,6 +236,7 @@ namespace sfe
     bool Timer::notifyObservers(sf::Time oldPosition)
     {
         CHECK(getStatus() != Playing, "inconsistency in timer");
+        SFE_TRACE_SCOPE("Timer::notifyDidSeek");
         bool successfullSeeking = true;
         
         for (std::pair<int, std::set<Observer*> >&& pairByPriority : m_observersByPriority)
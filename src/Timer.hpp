@@ -26,6 +26,7 @@
 #define SFEMOVIE_TIMER_HPP
 
 #include <set>
+#include <memory>
 #include <SFML/System.hpp>
 #include <sfeMovie/Movie.hpp>
 
@@ -105,9 +106,21 @@ namespace sfe
         void removeObserver(Observer& anObserver);
         
         /** Start this timer and notify all observers
+         *
+         * This is the same as prepareToPlay() followed by startPlaying()
          */
         void play();
         
+        /** Notify all observers that this timer is about to play, so that they get ready
+         *
+         * startPlaying() must be called next
+         */
+        void prepareToPlay();
+        
+        /** Start this timer once prepareToPlay() returned and notify all observers
+         */
+        void startPlaying();
+        
         /** Pause this timer (but do not reset it) and notify all observers
          */
         void pause();
@@ -138,6 +151,16 @@ namespace sfe
          */
         sf::Time getOffset() const;
         
+        /** Read the offset from another timer while this one is not stopped
+         *
+         * Timers following the same reference stay in sync as long as their owner changes the status
+         * of all of them together. When the reference is removed, this timer carries on from the
+         * offset of the reference.
+         *
+         * @param reference the timer to follow, or nullptr to use the own clock of this timer again
+         */
+        void setReference(std::shared_ptr<const Timer> reference);
+        
     private:
         /** Notify all observers that the timer's status is about to change to @a futureStatus
          *
@@ -166,6 +189,7 @@ namespace sfe
         sf::Time m_pausedTime;
         Status m_status;
         sf::Clock m_timer;
+        std::shared_ptr<const Timer> m_reference;
         std::map<Observer*, int> m_observers;
         std::map<int, std::set<Observer*> > m_observersByPriority;
     };
@@ -0,0 +1,94 @@
+
+/*
+ *  TraceSpan.hpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#ifndef SFEMOVIE_TRACE_SPAN_HPP
+#define SFEMOVIE_TRACE_SPAN_HPP
+
+#include <sfeMovie/Tracing.hpp>
+
+/** Record the time spent in the enclosing scope under the given name, which must be a string literal
+ *
+ * This compiles to nothing unless sfeMovie is built with SFEMOVIE_ENABLE_TRACING
+ */
+#ifdef SFEMOVIE_ENABLE_TRACING
+#define SFE_TRACE_SCOPE(name) sfe::Tracing::Span SFE_TRACE_JOIN(__sfeTraceSpan, __LINE__)(name)
+#define SFE_TRACE_THREAD_NAME(name) sfe::Tracing::setThreadName(name)
+#define SFE_TRACE_JOIN(a, b) SFE_TRACE_JOIN2(a, b)
+#define SFE_TRACE_JOIN2(a, b) a##b
+#else
+#define SFE_TRACE_SCOPE(name)
+#define SFE_TRACE_THREAD_NAME(name)
+#endif
+
+#ifdef SFEMOVIE_ENABLE_TRACING
+#include <SFML/Config.hpp>
+#include <atomic>
+
+namespace sfe
+{
+    namespace Tracing
+    {
+        extern std::atomic<bool> g_isRecording;
+        
+        /** @return the current time in microseconds, on the clock of the recorded spans
+         */
+        sf::Int64 now();
+        
+        /** Store a span in the buffer of the calling thread
+         */
+        void record(const char* name, sf::Int64 start, sf::Int64 duration);
+        
+        /** Name the calling thread in the traces, unless it already has a name
+         */
+        void setThreadName(const char* name);
+        
+        /** Records the time between its construction and its destruction, when recording
+         */
+        class Span
+        {
+        public:
+            explicit Span(const char* name)
+            : m_name(name)
+            , m_start(g_isRecording.load(std::memory_order_relaxed) ? now() : -1)
+            {
+            }
+            
+            ~Span()
+            {
+                if (m_start >= 0)
+                    record(m_name, m_start, now() - m_start);
+            }
+        
+        private:
+            Span(const Span&);
+            Span& operator=(const Span&);
+            
+            const char* m_name;
+            sf::Int64 m_start;
+        };
+    }
+}
+#endif
+
+#endif
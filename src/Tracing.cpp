@@ -0,0 +1,235 @@
+
+/*
+ *  Tracing.cpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+#include "TraceSpan.hpp"
+#include "Log.hpp"
+
+#ifdef SFEMOVIE_ENABLE_TRACING
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#endif
+
+namespace sfe
+{
+#ifdef SFEMOVIE_ENABLE_TRACING
+    namespace
+    {
+        // Spans kept for each thread, about 1.5 MB
+        const std::size_t RingCapacity = 1 << 16;
+        
+        struct Event
+        {
+            const char* name;
+            sf::Int64 start;
+            sf::Int64 duration;
+        };
+        
+        /** The latest spans of a thread, only written by that thread
+         */
+        struct ThreadBuffer
+        {
+            ThreadBuffer(int threadId)
+            : threadId(threadId)
+            , name()
+            , events(RingCapacity)
+            , writtenCount(0)
+            , generation(0)
+            {
+            }
+            
+            int threadId;
+            std::string name; // written under g_buffersMutex
+            std::vector<Event> events;
+            std::atomic<std::size_t> writtenCount;
+            std::atomic<unsigned int> generation;
+        };
+        
+        std::mutex g_buffersMutex;
+        
+        // Kept after their thread ended so that their spans can still be written
+        std::vector<std::shared_ptr<ThreadBuffer> > g_buffers;
+        std::atomic<unsigned int> g_generation(0);
+        const std::chrono::steady_clock::time_point g_epoch = std::chrono::steady_clock::now();
+        thread_local ThreadBuffer* t_buffer = nullptr;
+        
+        ThreadBuffer& threadBuffer()
+        {
+            if (!t_buffer)
+            {
+                std::lock_guard<std::mutex> lock(g_buffersMutex);
+                g_buffers.push_back(std::make_shared<ThreadBuffer>(static_cast<int>(g_buffers.size()) + 1));
+                t_buffer = g_buffers.back().get();
+            }
+            
+            return *t_buffer;
+        }
+        
+        std::string escape(const std::string& text)
+        {
+            std::string result;
+            
+            for (char c : text)
+            {
+                if (c == '"' || c == '\\')
+                    result += '\\';
+                
+                if (static_cast<unsigned char>(c) >= 0x20)
+                    result += c;
+            }
+            
+            return result;
+        }
+    }
+    
+    namespace Tracing
+    {
+        std::atomic<bool> g_isRecording(false);
+        
+        sf::Int64 now()
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - g_epoch).count();
+        }
+        
+        void record(const char* name, sf::Int64 start, sf::Int64 duration)
+        {
+            ThreadBuffer& buffer = threadBuffer();
+            
+            // Spans of the previous recording are dropped lazily, by the thread that owns them
+            const unsigned int generation = g_generation.load(std::memory_order_relaxed);
+            if (buffer.generation.load(std::memory_order_relaxed) != generation)
+            {
+                buffer.writtenCount.store(0, std::memory_order_relaxed);
+                buffer.generation.store(generation, std::memory_order_relaxed);
+            }
+            
+            const std::size_t index = buffer.writtenCount.load(std::memory_order_relaxed);
+            Event& event = buffer.events[index % RingCapacity];
+            event.name = name;
+            event.start = start;
+            event.duration = duration;
+            buffer.writtenCount.store(index + 1, std::memory_order_release);
+        }
+        
+        void setThreadName(const char* name)
+        {
+            ThreadBuffer& buffer = threadBuffer();
+            
+            // Only the owning thread writes the name, so it can read it without locking
+            if (buffer.name.empty())
+            {
+                std::lock_guard<std::mutex> lock(g_buffersMutex);
+                buffer.name = name;
+            }
+        }
+        
+        bool isAvailable()
+        {
+            return true;
+        }
+        
+        void start()
+        {
+            g_generation++;
+            g_isRecording = true;
+        }
+        
+        void stop()
+        {
+            g_isRecording = false;
+        }
+        
+        bool writeChromeTrace(const std::string& filename)
+        {
+            std::ofstream file(filename.c_str());
+            
+            if (!file)
+            {
+                sfeLogError("Tracing::writeChromeTrace() - cannot write " + filename);
+                return false;
+            }
+            
+            const unsigned int generation = g_generation;
+            bool isFirstEvent = true;
+            file << "{\"traceEvents\":[";
+            
+            std::lock_guard<std::mutex> lock(g_buffersMutex);
+            
+            for (const std::shared_ptr<ThreadBuffer>& buffer : g_buffers)
+            {
+                if (!buffer->name.empty())
+                {
+                    file << (isFirstEvent ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                         << buffer->threadId << ",\"args\":{\"name\":\"" << escape(buffer->name) << "\"}}";
+                    isFirstEvent = false;
+                }
+                
+                if (buffer->generation != generation)
+                    continue;
+                
+                const std::size_t writtenCount = buffer->writtenCount.load(std::memory_order_acquire);
+                const std::size_t firstIndex = writtenCount > RingCapacity ? writtenCount - RingCapacity : 0;
+                
+                for (std::size_t i = firstIndex; i < writtenCount; i++)
+                {
+                    const Event& event = buffer->events[i % RingCapacity];
+                    file << (isFirstEvent ? "" : ",") << "\n{\"name\":\"" << escape(event.name)
+                         << "\",\"cat\":\"sfeMovie\",\"ph\":\"X\",\"ts\":" << event.start << ",\"dur\":" << event.duration
+                         << ",\"pid\":1,\"tid\":" << buffer->threadId << "}";
+                    isFirstEvent = false;
+                }
+            }
+            
+            file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+            return file.good();
+        }
+    }
+#else
+    namespace Tracing
+    {
+        bool isAvailable()
+        {
+            return false;
+        }
+        
+        void start()
+        {
+            sfeLogWarning("Tracing::start() - sfeMovie was built without SFEMOVIE_ENABLE_TRACING, nothing is recorded");
+        }
+        
+        void stop()
+        {
+        }
+        
+        bool writeChromeTrace(const std::string& filename)
+        {
+            sfeLogError("Tracing::writeChromeTrace() - sfeMovie was built without SFEMOVIE_ENABLE_TRACING");
+            return false;
+        }
+    }
+#endif
+}
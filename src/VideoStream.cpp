@@ -33,6 +33,9 @@ extern "C"
 #include "VideoStream.hpp"
 #include "Utilities.hpp"
 #include "Log.hpp"
+#include "TraceSpan.hpp"
+#include "DecodeScheduler.hpp"
+#include <algorithm>
 
 namespace sfe
 {
@@ -40,38 +43,81 @@ namespace sfe
                              DataSource& dataSource, std::shared_ptr<Timer> timer, Delegate& delegate) :
     Stream(formatCtx ,stream, dataSource, timer),
     m_texture(),
+    m_frameMemory(0),
     m_rawVideoFrame(nullptr),
     m_rgbaVideoBuffer(),
     m_rgbaVideoLinesize(),
     m_delegate(delegate),
+    m_hasPresentedFrame(false),
+    m_lastPresentedGap(sf::Time::Zero),
+    m_hasNextFramePosition(false),
+    m_nextFramePosition(sf::Time::Zero),
+    m_hasPendingUpload(false),
+    m_decodeMutex(),
+    m_isDecodingAhead(false),
+    m_decodedFrame(),
+    m_decodePriority(0),
     m_swsCtx(nullptr)
     {
-        int err;
-        
         for (int i = 0; i < 4;i++)
         {
             m_rgbaVideoBuffer[i] = nullptr;
             m_rgbaVideoLinesize[i] = 0;
         }
-        
-        m_rawVideoFrame = av_frame_alloc();
-        CHECK(m_rawVideoFrame, "VideoStream() - out of memory");
-        
-        // RGBA video buffer
-        err = av_image_alloc(m_rgbaVideoBuffer, m_rgbaVideoLinesize,
-                             m_stream->codec->width, m_stream->codec->height,
-                             PIX_FMT_RGBA, 1);
-        CHECK(err >= 0, "VideoStream() - av_image_alloc() error");
-        
-        // SFML video frame
-        err = m_texture.create(m_stream->codec->width, m_stream->codec->height);
-        CHECK(err, "VideoStream() - sf::Texture::create() error");
-        
-        initRescaler();
     }
     
     VideoStream::~VideoStream()
     {
+        cancelDecoding();
+        releaseBuffers();
+    }
+    
+    void VideoStream::didOpenDecoder()
+    {
+        int err;
+        
+        try
+        {
+            m_rawVideoFrame = av_frame_alloc();
+            CHECK(m_rawVideoFrame, "VideoStream::didOpenDecoder() - out of memory");
+            
+            // RGBA video buffer
+            err = av_image_alloc(m_rgbaVideoBuffer, m_rgbaVideoLinesize,
+                                 m_stream->codec->width, m_stream->codec->height,
+                                 PIX_FMT_RGBA, 1);
+            CHECK(err >= 0, "VideoStream::didOpenDecoder() - av_image_alloc() error");
+            
+            // SFML video frame
+            err = m_texture.create(m_stream->codec->width, m_stream->codec->height);
+            CHECK(err, "VideoStream::didOpenDecoder() - sf::Texture::create() error");
+            
+            // The RGBA buffer and its copy in the texture
+            m_frameMemory = 2 * static_cast<std::size_t>(m_stream->codec->width) * m_stream->codec->height * 4;
+            m_memoryAccount.add(MemoryAccount::VideoFrames, m_frameMemory);
+            
+            // The pixel format is unknown until the first frame is decoded when the streams
+            // were not analyzed, see OpenOptions::trustContainerHeader
+            if (m_stream->codec->pix_fmt != PIX_FMT_NONE)
+                initRescaler();
+        }
+        catch (...)
+        {
+            releaseBuffers();
+            throw;
+        }
+    }
+    
+    void VideoStream::willCloseDecoder()
+    {
+        cancelDecoding();
+        releaseBuffers();
+    }
+    
+    void VideoStream::releaseBuffers()
+    {
+        m_memoryAccount.remove(MemoryAccount::VideoFrames, m_frameMemory);
+        m_frameMemory = 0;
+        
         if (m_rawVideoFrame)
         {
             av_frame_free(&m_rawVideoFrame);
@@ -85,7 +131,22 @@ namespace sfe
         if (m_swsCtx)
         {
             sws_freeContext(m_swsCtx);
+            m_swsCtx = nullptr;
         }
+        
+        // Release the GPU memory, the texture object stays valid for the delegate
+        m_texture = sf::Texture();
+    }
+    
+    VideoStream::DecodedFrame::DecodedFrame() :
+    isReady(false),
+    hasPosition(false),
+    couldDecode(false),
+    gotFrame(false),
+    hasNextPosition(false),
+    position(sf::Time::Zero),
+    nextPosition(sf::Time::Zero)
+    {
     }
     
     MediaType VideoStream::getStreamKind() const
@@ -109,6 +170,41 @@ namespace sfe
     }
     
     void VideoStream::update()
+    {
+        bool hasDecodedFrame = false;
+        
+        if (m_hasPendingUpload)
+        {
+            uploadFrame(m_texture);
+            m_delegate.didUpdateVideo(*this, m_texture);
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(m_decodeMutex);
+            hasDecodedFrame = m_decodedFrame.isReady;
+        }
+        
+        // A frame decoded ahead is still displayed if the workers were just removed
+        if (DecodeScheduler::getInstance().getWorkerCount() > 0 || hasDecodedFrame)
+            updateFromDecodedFrames();
+        else
+            updateSynchronously();
+    }
+    
+    bool VideoStream::getTimeUntilNextUpdate(sf::Time& delay) const
+    {
+        if (getStatus() != Playing)
+            return false;
+        
+        // Until the next frame position is known, updating is what makes it known
+        delay = sf::Time::Zero;
+        if (m_hasNextFramePosition)
+            delay = std::max(m_nextFramePosition - m_timer->getOffset(), sf::Time::Zero);
+        
+        return true;
+    }
+    
+    void VideoStream::updateSynchronously()
     {
         sf::Time gap;
         bool couldComputeGap = false;
@@ -121,9 +217,7 @@ namespace sfe
             }
             else
             {
-                static const sf::Time skipFrameThreshold(sf::milliseconds(50));
-                if (getSynchronizationGap(gap) && gap + skipFrameThreshold >= sf::Time::Zero)
-                    m_delegate.didUpdateVideo(*this, m_texture);
+                presentFrame(getSynchronizationGap(gap), gap);
             }
         }
         
@@ -131,11 +225,150 @@ namespace sfe
         {
             setStatus(Stopped);
         }
+        
+        m_hasNextFramePosition = couldComputeGap;
+        m_nextFramePosition = m_timer->getOffset() + gap;
+    }
+    
+    void VideoStream::updateFromDecodedFrames()
+    {
+        std::unique_lock<std::mutex> lock(m_decodeMutex);
+        
+        if (getStatus() != Playing || m_isDecodingAhead)
+            return;
+        
+        sf::Time nextFrameDelay = sf::Time::Zero;
+        
+        if (m_decodedFrame.isReady)
+        {
+            const sf::Time offset = m_timer->getOffset();
+            
+            if (!m_decodedFrame.hasPosition)
+            {
+                setStatus(Stopped);
+                return;
+            }
+            
+            if (m_decodedFrame.position - offset >= sf::Time::Zero)
+            {
+                m_hasNextFramePosition = true;
+                m_nextFramePosition = m_decodedFrame.position;
+                return;
+            }
+            
+            if (!m_decodedFrame.couldDecode)
+            {
+                setStatus(Stopped);
+                return;
+            }
+            
+            if (m_decodedFrame.gotFrame)
+                uploadFrame(m_texture);
+            
+            presentFrame(m_decodedFrame.hasNextPosition, m_decodedFrame.nextPosition - offset);
+            nextFrameDelay = m_decodedFrame.nextPosition - offset;
+            m_hasNextFramePosition = m_decodedFrame.hasNextPosition;
+            m_nextFramePosition = m_decodedFrame.nextPosition;
+            m_decodedFrame = DecodedFrame();
+        }
+        
+        m_isDecodingAhead = true;
+        lock.unlock();
+        
+        // The workers must not read the timer, which is only used from the calling thread
+        const sf::Int64 delay = std::max(nextFrameDelay.asMicroseconds(), sf::Int64(0));
+        const DecodeScheduler::Clock::time_point now = DecodeScheduler::Clock::now();
+        DecodeScheduler::getInstance().submit(this, m_decodePriority, now + std::chrono::microseconds(delay),
+                                              std::bind(&VideoStream::decodeAhead, this, m_timer->getOffset(), now));
+    }
+    
+    void VideoStream::presentFrame(bool hasNextGap, sf::Time nextGap)
+    {
+        static const sf::Time skipFrameThreshold(sf::milliseconds(50));
+        if (hasNextGap && nextGap + skipFrameThreshold >= sf::Time::Zero)
+        {
+            m_delegate.didUpdateVideo(*this, m_texture);
+            
+            // The previous frame stayed displayed longer than planned by as much as this one is later
+            const float frameRate = getFrameRate();
+            const bool isRepeated = m_hasPresentedFrame && frameRate > 0 &&
+                                    m_lastPresentedGap - nextGap >= sf::seconds(1.f / frameRate);
+            
+            std::lock_guard<std::mutex> lock(m_statsMutex);
+            m_stats.framesPresented++;
+            m_stats.framesRepeated += isRepeated ? 1 : 0;
+            m_stats.syncError.add(nextGap < sf::Time::Zero ? -nextGap : nextGap);
+            m_hasPresentedFrame = true;
+            m_lastPresentedGap = nextGap;
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(m_statsMutex);
+            m_stats.framesDroppedLate++;
+        }
+    }
+    
+    void VideoStream::decodeAhead(sf::Time playbackPosition, DecodeScheduler::Clock::time_point positionTime)
+    {
+        static const sf::Time skipFrameThreshold(sf::milliseconds(50));
+        DecodedFrame frame;
+        sf::Time position;
+        
+        // Frames that would be dropped for being too late are skipped right away, to catch up
+        do
+        {
+            frame.hasPosition = computeEncodedPosition(position);
+            if (!frame.hasPosition)
+                break;
+            
+            frame.position = position - codecBufferingDelay();
+            frame.couldDecode = decodeFrame(frame.gotFrame);
+            frame.hasNextPosition = computeEncodedPosition(position);
+            frame.nextPosition = position - codecBufferingDelay();
+            
+            // The movie was playing when the task was submitted, so it kept going since then
+            const sf::Time elapsed = sf::microseconds(std::chrono::duration_cast<std::chrono::microseconds>(
+                DecodeScheduler::Clock::now() - positionTime).count());
+            
+            if (frame.couldDecode && frame.hasNextPosition &&
+                frame.nextPosition - (playbackPosition + elapsed) + skipFrameThreshold < sf::Time::Zero)
+            {
+                std::lock_guard<std::mutex> lock(m_statsMutex);
+                m_stats.framesDroppedLate++;
+            }
+            else
+            {
+                break;
+            }
+        } while (true);
+        
+        std::lock_guard<std::mutex> lock(m_decodeMutex);
+        m_decodedFrame = frame;
+        m_decodedFrame.isReady = true;
+        m_isDecodingAhead = false;
+    }
+    
+    void VideoStream::cancelDecoding()
+    {
+        DecodeScheduler::getInstance().cancel(this);
+        m_hasNextFramePosition = false;
+        
+        std::lock_guard<std::mutex> lock(m_decodeMutex);
+        m_isDecodingAhead = false;
+        m_decodedFrame = DecodedFrame();
+    }
+    
+    void VideoStream::setDecodePriority(int priority)
+    {
+        m_decodePriority = priority;
     }
     
     void VideoStream::flushBuffers()
     {
+        cancelDecoding();
         m_codecBufferingDelays.clear();
+        m_hasPresentedFrame = false;
+        m_hasPendingUpload = false;
         Stream::flushBuffers();
     }
     
@@ -143,11 +376,17 @@ namespace sfe
     {
         sf::Time position;
         bool couldGetPosition = false;
+        cancelDecoding();
         
         while ((couldGetPosition = computeEncodedPosition(position)) && position < targetPosition)
         {
-            // We HAVE to decode the frames to get a full image when we reach the target position
-            if (! onGetData(m_texture))
+            // We HAVE to decode the frames to get a full image when we reach the target position,
+            // but only the last one needs to be uploaded
+            bool gotFrame = false;
+            const bool goOn = decodeFrame(gotFrame);
+            m_hasPendingUpload = m_hasPendingUpload || gotFrame;
+            
+            if (! goOn)
             {
                 sfeLogError("Error while fast forwarding video stream up to position " +
                             s(targetPosition.asSeconds()) + "s");
@@ -166,14 +405,41 @@ namespace sfe
     void VideoStream::preload()
     {
         sfeLogDebug("Preload video image");
-        onGetData(m_texture);
+        cancelDecoding();
+        
+        bool gotFrame = false;
+        decodeFrame(gotFrame);
+        m_hasPendingUpload = m_hasPendingUpload || gotFrame;
+    }
+    
+    sf::Time VideoStream::getPresentationLateness() const
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        
+        if (!m_hasPresentedFrame || m_lastPresentedGap >= sf::Time::Zero)
+            return sf::Time::Zero;
+        
+        return -m_lastPresentedGap;
     }
     
     bool VideoStream::onGetData(sf::Texture& texture)
     {
-        AVPacket* packet = popEncodedData();
         bool gotFrame = false;
+        const bool goOn = decodeFrame(gotFrame);
+        
+        if (gotFrame)
+            uploadFrame(texture);
+        
+        return goOn;
+    }
+    
+    bool VideoStream::decodeFrame(bool& gotFrame)
+    {
+        AVPacket* packet = popEncodedData();
+        gotFrame = false;
         bool goOn = false;
+        sf::Clock clock;
+        sf::Time decodeTime;
         
         if (packet)
         {
@@ -184,12 +450,20 @@ namespace sfe
                 bool needsMoreDecoding = false;
                 
                 CHECK(packet != nullptr, "inconsistency error");
+                clock.restart();
                 goOn = decodePacket(packet, m_rawVideoFrame, gotFrame, needsMoreDecoding);
+                decodeTime += clock.getElapsedTime();
                 
                 if (gotFrame)
                 {
+                    clock.restart();
                     rescale(m_rawVideoFrame, m_rgbaVideoBuffer, m_rgbaVideoLinesize);
-                    texture.update(m_rgbaVideoBuffer[0]);
+                    const sf::Time convertTime = clock.getElapsedTime();
+                    
+                    std::lock_guard<std::mutex> lock(m_statsMutex);
+                    m_stats.framesDecoded++;
+                    m_stats.decodeTime.add(decodeTime);
+                    m_stats.convertTime.add(convertTime);
                 }
                 
                 if (!gotFrame && goOn)
@@ -226,6 +500,18 @@ namespace sfe
         return goOn;
     }
     
+    void VideoStream::uploadFrame(sf::Texture& texture)
+    {
+        SFE_TRACE_SCOPE("VideoStream::uploadTexture");
+        sf::Clock clock;
+        texture.update(m_rgbaVideoBuffer[0]);
+        const sf::Time uploadTime = clock.getElapsedTime();
+        m_hasPendingUpload = false;
+        
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        m_stats.uploadTime.add(uploadTime);
+    }
+    
     bool VideoStream::getSynchronizationGap(sf::Time& gap)
     {
         sf::Time position;
@@ -243,6 +529,7 @@ namespace sfe
     
     bool VideoStream::decodePacket(AVPacket* packet, AVFrame* outputFrame, bool& gotFrame, bool& needsMoreDecoding)
     {
+        SFE_TRACE_SCOPE("VideoStream::decodePacket");
         int gotPicture = 0;
         needsMoreDecoding = false;
         
@@ -285,6 +572,11 @@ namespace sfe
     void VideoStream::rescale(AVFrame* frame, uint8_t* outVideoBuffer[4], int outVideoLinesize[4])
     {
         CHECK(frame, "VideoStream::rescale() - invalid argument");
+        SFE_TRACE_SCOPE("VideoStream::rescale");
+        
+        if (!m_swsCtx)
+            initRescaler();
+        
         sws_scale(m_swsCtx, frame->data, frame->linesize, 0, frame->height, outVideoBuffer, outVideoLinesize);
     }
     
@@ -27,7 +27,10 @@
 
 #include "Macros.hpp"
 #include "Stream.hpp"
+#include "DecodeScheduler.hpp"
 #include <SFML/Graphics.hpp>
+#include <atomic>
+#include <mutex>
 #include <stdint.h>
 
 namespace sfe
@@ -43,7 +46,8 @@ namespace sfe
         /** Create a video stream from the given FFmpeg stream
          *
          * At the end of the constructor, the stream is guaranteed
-         * to have all of its fields set and the decoder loaded
+         * to have all of its fields set, the decoder is loaded
+         * once the stream is connected
          */
         VideoStream(AVFormatContext*& formatCtx, AVStream*& stream,
                     DataSource& dataSource, std::shared_ptr<Timer> timer, Delegate& delegate);
@@ -79,6 +83,10 @@ namespace sfe
          */
         void update() override;
         
+        /** @see Stream::getTimeUntilNextUpdate()
+         */
+        bool getTimeUntilNextUpdate(sf::Time& delay) const override;
+        
         /** @see Stream::flushBuffers()
          */
         virtual void flushBuffers();
@@ -88,11 +96,79 @@ namespace sfe
         bool fastForward(sf::Time targetPosition) override;
         
         /** Load packets until one frame can be decoded
+         *
+         * Like the frames decoded when seeking, the frame is uploaded to the texture by the next update(),
+         * so that this can be called from another thread than the rendering one
          */
         void preload();
+        
+        /** @return how late the frame that follows the displayed one was when it got displayed,
+         * or zero if it wasn't late or if no frame has been displayed
+         */
+        sf::Time getPresentationLateness() const;
+        
+        /** Set how urgent decoding this stream is compared to the streams of other movies, when
+         * frames are decoded by the DecodeThreads workers
+         *
+         * @param priority the streams of higher priority are decoded first
+         */
+        void setDecodePriority(int priority);
     private:
+        /** Result of decoding one frame ahead of its display time, on a DecodeThreads worker
+         */
+        struct DecodedFrame
+        {
+            DecodedFrame();
+            
+            bool isReady;           //!< Whether this frame was decoded and still has to be displayed
+            bool hasPosition;       //!< Whether the stream position could be computed before decoding
+            bool couldDecode;       //!< Whether decoding could go on, false at the end of the stream
+            bool gotFrame;          //!< Whether an image was decoded and rescaled to the RGBA buffer
+            bool hasNextPosition;   //!< Whether the stream position could be computed after decoding
+            sf::Time position;      //!< Display position of this frame
+            sf::Time nextPosition;  //!< Display position of the next frame
+        };
+        
         bool onGetData(sf::Texture& texture);
         
+        /** Decode the next frame and rescale it to the RGBA buffer
+         *
+         * @param[out] gotFrame set to true if an image was decoded
+         * @return false if no more data can be decoded (EOF), true otherwise
+         */
+        bool decodeFrame(bool& gotFrame);
+        
+        /** Upload the rescaled RGBA buffer to @a texture
+         */
+        void uploadFrame(sf::Texture& texture);
+        
+        /** Display the latest decoded frame if it is not too late, and count it in the statistics
+         *
+         * @param hasNextGap whether the synchronization gap of the next frame could be computed
+         * @param nextGap the synchronization gap of the next frame
+         */
+        void presentFrame(bool hasNextGap, sf::Time nextGap);
+        
+        /** Decode the frames in update(), as they are due
+         */
+        void updateSynchronously();
+        
+        /** Display the frames that DecodeThreads workers decoded, and ask for the next ones
+         */
+        void updateFromDecodedFrames();
+        
+        /** Decode the next frame into m_decodedFrame, called by a DecodeThreads worker
+         *
+         * @param playbackPosition the timer offset when the task was submitted
+         * @param positionTime the moment at which @a playbackPosition was read
+         */
+        void decodeAhead(sf::Time playbackPosition, DecodeScheduler::Clock::time_point positionTime);
+        
+        /** Drop the frame decoded ahead and wait for the ongoing decoding to finish, so that the
+         * decoder can be used by the calling thread
+         */
+        void cancelDecoding();
+        
         /** Returns the difference between the video stream timer and the reference timer
          *
          * A positive value means the video stream is ahead of the reference timer
@@ -123,6 +199,10 @@ namespace sfe
          */
         void initRescaler();
         
+        /** Release the decoded frame, the RGBA buffer, the texture and the rescaler
+         */
+        void releaseBuffers();
+        
         /** Convert the decoded video frame @a frame into RGBA image data
          *
          * @param frame the audio samples to convert
@@ -135,18 +215,40 @@ namespace sfe
         // Timer::Observer interface
         void willPlay(const Timer &timer) override;
         
+        // Stream interface
+        void didOpenDecoder() override;
+        void willCloseDecoder() override;
+        
         /** Returns the delay caused by the FFmpeg decoder buffering
          */
         sf::Time codecBufferingDelay() const;
         
         // Private data
         sf::Texture m_texture;
+        std::size_t m_frameMemory;
         AVFrame* m_rawVideoFrame;
         uint8_t *m_rgbaVideoBuffer[4];
         int m_rgbaVideoLinesize[4];
         std::list<sf::Time> m_codecBufferingDelays;
         Delegate& m_delegate;
         
+        // Synchronization gap of the last displayed frame, to detect frames that stay displayed too long
+        bool m_hasPresentedFrame;
+        sf::Time m_lastPresentedGap;
+        
+        // Display time of the next frame, known once the frames before it have been decoded
+        bool m_hasNextFramePosition;
+        sf::Time m_nextFramePosition;
+        
+        // Frame decoded in the RGBA buffer by seeking or preloading, uploaded by the next update
+        bool m_hasPendingUpload;
+        
+        // Decoding ahead: while m_isDecodingAhead is true, only the worker uses the decoder and packets
+        std::mutex m_decodeMutex;
+        bool m_isDecodingAhead;
+        DecodedFrame m_decodedFrame;
+        std::atomic<int> m_decodePriority;
+        
         // Rescaler data
         struct SwsContext *m_swsCtx;
     };
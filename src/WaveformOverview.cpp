@@ -0,0 +1,75 @@
+
+/*
+ *  WaveformOverview.cpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+
+#include <sfeMovie/WaveformOverview.hpp>
+#include "WaveformOverviewImpl.hpp"
+
+namespace sfe
+{
+    WaveformOverview::WaveformOverview() :
+    m_impl(new WaveformOverviewImpl())
+    {
+    }
+    
+    WaveformOverview::~WaveformOverview()
+    {
+    }
+    
+    bool WaveformOverview::generateFromFile(const std::string& filename, unsigned int segmentCount)
+    {
+        return m_impl->generateFromFile(filename, segmentCount);
+    }
+    
+    void WaveformOverview::cancel()
+    {
+        m_impl->cancel();
+    }
+    
+    bool WaveformOverview::isComplete() const
+    {
+        return m_impl->isComplete();
+    }
+    
+    bool WaveformOverview::hasFailed() const
+    {
+        return m_impl->hasFailed();
+    }
+    
+    float WaveformOverview::getProgress() const
+    {
+        return m_impl->getProgress();
+    }
+    
+    sf::Time WaveformOverview::getDuration() const
+    {
+        return m_impl->getDuration();
+    }
+    
+    bool WaveformOverview::getPeaks(sf::Time begin, sf::Time end, std::size_t peakCount,
+                                    std::vector<WaveformPeak>& peaks) const
+    {
+        return m_impl->getPeaks(begin, end, peakCount, peaks);
+    }
+}
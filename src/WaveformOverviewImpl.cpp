@@ -0,0 +1,238 @@
+
+/*
+ *  WaveformOverviewImpl.cpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+
+#include "WaveformOverviewImpl.hpp"
+#include "AudioSegmentDecoder.hpp"
+#include "Log.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace sfe
+{
+    namespace
+    {
+        // Each segment costs a seek and a decoder, don't split the media into tiny parts
+        const float MinimumSegmentDuration = 10.f; // seconds
+        
+        sf::Int64 timeToFrames(sf::Time time, unsigned int sampleRate)
+        {
+            return time.asMicroseconds() * sampleRate / 1000000;
+        }
+    }
+    
+    WaveformOverviewImpl::WaveformOverviewImpl() :
+    m_filename(),
+    m_pyramid(nullptr),
+    m_sampleRate(0),
+    m_duration(sf::Time::Zero),
+    m_workers(),
+    m_segmentCount(0),
+    m_finishedSegments(0),
+    m_failedSegments(0),
+    m_decodedFrames(0),
+    m_shouldStop(false)
+    {
+    }
+    
+    WaveformOverviewImpl::~WaveformOverviewImpl()
+    {
+        cancel();
+    }
+    
+    bool WaveformOverviewImpl::generateFromFile(const std::string& filename, unsigned int segmentCount)
+    {
+        cancel();
+        
+        m_pyramid.reset();
+        m_sampleRate = 0;
+        m_duration = sf::Time::Zero;
+        m_segmentCount = 0;
+        m_finishedSegments = 0;
+        m_failedSegments = 0;
+        m_decodedFrames = 0;
+        m_shouldStop = false;
+        
+        // Open the media synchronously so that errors can be reported, this decoder is
+        // then used for the first segment
+        std::shared_ptr<AudioSegmentDecoder> firstDecoder;
+        
+        try
+        {
+            firstDecoder = std::make_shared<AudioSegmentDecoder>(filename);
+        }
+        catch (std::runtime_error& e)
+        {
+            sfeLogError("WaveformOverview::generateFromFile() - " + std::string(e.what()));
+            return false;
+        }
+        
+        m_filename = filename;
+        m_sampleRate = firstDecoder->getSampleRate();
+        m_duration = firstDecoder->getDuration();
+        m_pyramid = std::make_shared<PeakPyramid>(timeToFrames(m_duration, m_sampleRate));
+        
+        if (segmentCount == 0)
+            segmentCount = std::max(std::thread::hardware_concurrency(), 1u);
+        
+        const unsigned int maxSegmentCount = std::max(static_cast<unsigned int>(m_duration.asSeconds() /
+                                                                                MinimumSegmentDuration), 1u);
+        m_segmentCount = std::min(segmentCount, maxSegmentCount);
+        
+        for (unsigned int i = 0; i < m_segmentCount; i++)
+        {
+            const sf::Int64 duration = m_duration.asMicroseconds();
+            const sf::Time begin = sf::microseconds(duration * i / m_segmentCount);
+            const sf::Time end = (i + 1 == m_segmentCount) ? sf::Time::Zero
+                                                           : sf::microseconds(duration * (i + 1) / m_segmentCount);
+            
+            m_workers.push_back(std::thread(&WaveformOverviewImpl::decodeSegment, this,
+                                            (i == 0) ? firstDecoder : nullptr, begin, end));
+        }
+        
+        return true;
+    }
+    
+    void WaveformOverviewImpl::cancel()
+    {
+        m_shouldStop = true;
+        
+        for (std::thread& worker : m_workers)
+            worker.join();
+        
+        m_workers.clear();
+    }
+    
+    bool WaveformOverviewImpl::isComplete() const
+    {
+        return m_pyramid && m_finishedSegments == m_segmentCount;
+    }
+    
+    bool WaveformOverviewImpl::hasFailed() const
+    {
+        return m_failedSegments > 0;
+    }
+    
+    float WaveformOverviewImpl::getProgress() const
+    {
+        if (isComplete())
+            return 1.f;
+        
+        const sf::Int64 frameCount = timeToFrames(m_duration, m_sampleRate);
+        
+        if (frameCount == 0)
+            return 0.f;
+        
+        // Segments slightly overlap so the count of decoded frames can exceed the total
+        return std::min(static_cast<float>(m_decodedFrames) / frameCount, 1.f);
+    }
+    
+    sf::Time WaveformOverviewImpl::getDuration() const
+    {
+        return m_duration;
+    }
+    
+    bool WaveformOverviewImpl::getPeaks(sf::Time begin, sf::Time end, std::size_t peakCount,
+                                        std::vector<WaveformPeak>& peaks) const
+    {
+        if (!m_pyramid)
+        {
+            sfeLogError("WaveformOverview::getPeaks() - no waveform has been generated");
+            return false;
+        }
+        
+        std::vector<PeakPyramid::Peak> pyramidPeaks;
+        m_pyramid->getPeaks(timeToFrames(begin, m_sampleRate), timeToFrames(end, m_sampleRate),
+                            peakCount, pyramidPeaks);
+        
+        peaks.resize(pyramidPeaks.size());
+        
+        for (std::size_t i = 0; i < pyramidPeaks.size(); i++)
+        {
+            const PeakPyramid::Peak& peak = pyramidPeaks[i];
+            peaks[i].decoded = !peak.isEmpty();
+            peaks[i].minimum = peaks[i].decoded ? peak.minimum / 32768.f : 0.f;
+            peaks[i].maximum = peaks[i].decoded ? peak.maximum / 32768.f : 0.f;
+        }
+        
+        return true;
+    }
+    
+    void WaveformOverviewImpl::decodeSegment(std::shared_ptr<AudioSegmentDecoder> decoder, sf::Time begin, sf::Time end)
+    {
+        bool succeeded = false;
+        
+        try
+        {
+            if (!decoder)
+                decoder = std::make_shared<AudioSegmentDecoder>(m_filename);
+            
+            if (begin > sf::Time::Zero && !decoder->seek(begin))
+                throw std::runtime_error("could not seek to " + s(begin.asSeconds()) + "s");
+            
+            const unsigned int channelCount = decoder->getChannelCount();
+            const sf::Int64 endFrame = timeToFrames(end, m_sampleRate);
+            bool hasMoreData = true;
+            
+            while (hasMoreData && !m_shouldStop)
+            {
+                const sf::Int16* samples = nullptr;
+                std::size_t sampleCount = 0;
+                sf::Time position;
+                
+                hasMoreData = decoder->decodeSamples(samples, sampleCount, position);
+                
+                const std::size_t frameCount = sampleCount / channelCount;
+                const sf::Int64 firstFrame = timeToFrames(position, m_sampleRate);
+                
+                if (frameCount > 0)
+                {
+                    m_pyramid->addSamples(firstFrame, samples, frameCount, channelCount);
+                    m_decodedFrames += frameCount;
+                }
+                
+                // The next segment starts where this one ends
+                if (end != sf::Time::Zero && firstFrame + static_cast<sf::Int64>(frameCount) >= endFrame)
+                    break;
+            }
+            
+            succeeded = true;
+        }
+        catch (std::runtime_error& e)
+        {
+            sfeLogError("WaveformOverview - decoding failure, this part of the waveform will be missing: "
+                        + std::string(e.what()));
+        }
+        
+        // Cancelled segments are neither finished nor failed
+        if (m_shouldStop)
+            return;
+        
+        // Counted first so that hasFailed() is up to date once isComplete() is true
+        if (!succeeded)
+            m_failedSegments++;
+        
+        m_finishedSegments++;
+    }
+}
@@ -0,0 +1,97 @@
+
+/*
+ *  WaveformOverviewImpl.hpp
+ *  sfeMovie project
+ *
+ *  Copyright (C) 2010-2015 Lucas Soltic
+ *  lucas.soltic@orange.fr
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ */
+
+
+#ifndef SFEMOVIE_WAVEFORM_OVERVIEW_IMPL_HPP
+#define SFEMOVIE_WAVEFORM_OVERVIEW_IMPL_HPP
+
+#include <sfeMovie/WaveformOverview.hpp>
+#include "PeakPyramid.hpp"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sfe
+{
+    class AudioSegmentDecoder;
+    
+    class WaveformOverviewImpl
+    {
+    public:
+        WaveformOverviewImpl();
+        ~WaveformOverviewImpl();
+        
+        /** @see WaveformOverview::generateFromFile()
+         */
+        bool generateFromFile(const std::string& filename, unsigned int segmentCount);
+        
+        /** @see WaveformOverview::cancel()
+         */
+        void cancel();
+        
+        /** @see WaveformOverview::isComplete()
+         */
+        bool isComplete() const;
+        
+        /** @see WaveformOverview::hasFailed()
+         */
+        bool hasFailed() const;
+        
+        /** @see WaveformOverview::getProgress()
+         */
+        float getProgress() const;
+        
+        /** @see WaveformOverview::getDuration()
+         */
+        sf::Time getDuration() const;
+        
+        /** @see WaveformOverview::getPeaks()
+         */
+        bool getPeaks(sf::Time begin, sf::Time end, std::size_t peakCount, std::vector<WaveformPeak>& peaks) const;
+    
+    private:
+        /** Decode the audio between @a begin and @a end into the peak pyramid, run by the worker threads
+         *
+         * @param decoder the decoder to use, or nullptr to open a new one
+         * @param begin the media position where to start decoding
+         * @param end the media position where to stop decoding, or zero to decode up to the end of the media
+         */
+        void decodeSegment(std::shared_ptr<AudioSegmentDecoder> decoder, sf::Time begin, sf::Time end);
+        
+        std::string m_filename;
+        std::shared_ptr<PeakPyramid> m_pyramid;
+        unsigned int m_sampleRate;
+        sf::Time m_duration;
+        std::vector<std::thread> m_workers;
+        unsigned int m_segmentCount;
+        std::atomic<unsigned int> m_finishedSegments;
+        std::atomic<unsigned int> m_failedSegments;
+        std::atomic<sf::Int64> m_decodedFrames;
+        std::atomic<bool> m_shouldStop;
+    };
+}
+
+#endif
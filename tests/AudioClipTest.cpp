@@ -0,0 +1,87 @@
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_MODULE AudioClipTest
+#include <boost/test/unit_test.hpp>
+#include <sfeMovie/AudioClip.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+    void writeLittleEndian(std::ofstream& file, sf::Uint32 value, int byteCount)
+    {
+        for (int i = 0; i < byteCount; i++)
+            file.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+    
+    // Write a 16 bits stereo WAV file whose samples all differ from their neighbours, so that
+    // misplaced or duplicated frames change the decoded result
+    void writeRampWave(const std::string& filename, unsigned int sampleRate, unsigned int seconds)
+    {
+        const sf::Uint32 frameCount = sampleRate * seconds;
+        const sf::Uint32 dataSize = frameCount * 2 * sizeof(sf::Int16);
+        std::ofstream file(filename.c_str(), std::ios::binary);
+        
+        file.write("RIFF", 4);
+        writeLittleEndian(file, 36 + dataSize, 4);
+        file.write("WAVEfmt ", 8);
+        writeLittleEndian(file, 16, 4);
+        writeLittleEndian(file, 1, 2);
+        writeLittleEndian(file, 2, 2);
+        writeLittleEndian(file, sampleRate, 4);
+        writeLittleEndian(file, sampleRate * 2 * sizeof(sf::Int16), 4);
+        writeLittleEndian(file, 2 * sizeof(sf::Int16), 2);
+        writeLittleEndian(file, 16, 2);
+        file.write("data", 4);
+        writeLittleEndian(file, dataSize, 4);
+        
+        for (sf::Uint32 i = 0; i < frameCount; i++)
+        {
+            writeLittleEndian(file, static_cast<sf::Uint16>(i), 2);
+            writeLittleEndian(file, static_cast<sf::Uint16>(i * 7), 2);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(AudioClipLoadingTest)
+{
+    sfe::AudioClip clip;
+    
+    BOOST_CHECK(!clip.loadFromFile("non-existing-file.wav"));
+    BOOST_CHECK(clip.getSamples() == nullptr);
+    BOOST_CHECK_EQUAL(clip.getSampleCount(), 0);
+    
+    BOOST_REQUIRE(clip.loadFromFile("small_3.flac"));
+    BOOST_CHECK(clip.getSamples() != nullptr);
+    BOOST_CHECK(clip.getSampleRate() > 0);
+    BOOST_CHECK(clip.getChannelCount() > 0);
+    BOOST_CHECK_EQUAL(clip.getSampleCount() % clip.getChannelCount(), 0);
+    BOOST_CHECK(clip.getDuration() > sf::Time::Zero);
+    
+    // A failed loading keeps the previous audio
+    const std::size_t sampleCount = clip.getSampleCount();
+    BOOST_CHECK(!clip.loadFromFile("non-existing-file.wav"));
+    BOOST_CHECK_EQUAL(clip.getSampleCount(), sampleCount);
+}
+
+BOOST_AUTO_TEST_CASE(AudioClipSegmentsTest)
+{
+    // Segments last at least 10 seconds, 40 seconds of audio can be decoded in 4 parallel segments
+    const std::string filename = "AudioClipSegmentsTest.wav";
+    writeRampWave(filename, 44100, 40);
+    
+    sfe::AudioClip sequential;
+    sfe::AudioClip parallel;
+    
+    BOOST_REQUIRE(sequential.loadFromFile(filename, 1));
+    BOOST_REQUIRE(parallel.loadFromFile(filename, 4));
+    std::remove(filename.c_str());
+    
+    // The stitched segments give exactly the samples of the sequential decoding
+    BOOST_CHECK_EQUAL(sequential.getSampleCount(), 40 * 44100 * 2);
+    BOOST_REQUIRE_EQUAL(sequential.getSampleCount(), parallel.getSampleCount());
+    BOOST_CHECK(std::equal(sequential.getSamples(), sequential.getSamples() + sequential.getSampleCount(),
+                           parallel.getSamples()));
+}
@@ -0,0 +1,146 @@
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_MODULE AudioKernelsTest
+#include <boost/test/unit_test.hpp>
+#include "AudioKernels.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    const double Pi = 3.14159265358979323846;
+}
+
+BOOST_AUTO_TEST_CASE(StereoLevelsTest)
+{
+    // Odd frame count so that both the vectorized and the remaining samples paths are used
+    const std::size_t frameCount = 1001;
+    std::vector<sf::Int16> samples(frameCount * 2);
+    
+    for (std::size_t i = 0; i < frameCount; i++)
+    {
+        samples[2 * i] = (i % 2) ? 16384 : -16384;
+        samples[2 * i + 1] = 0;
+    }
+    samples[2 * 500 + 1] = -32768;
+    
+    float peak[2];
+    float rms[2];
+    sfe::AudioKernels::computeStereoLevels(samples.data(), frameCount, peak, rms);
+    
+    BOOST_CHECK_CLOSE(peak[0], 16384 / 32767.f, 0.01);
+    BOOST_CHECK_CLOSE(peak[1], 1.f, 0.01);
+    BOOST_CHECK_CLOSE(rms[0], 0.5f, 0.01);
+    BOOST_CHECK_CLOSE(rms[1], std::sqrt(32768.f * 32768.f / frameCount) / 32768.f, 0.01);
+}
+
+BOOST_AUTO_TEST_CASE(DownmixTest)
+{
+    const std::size_t frameCount = 7;
+    std::vector<sf::Int16> samples(frameCount * 2);
+    std::vector<float> window(frameCount, 0.5f);
+    std::vector<float> output(frameCount);
+    
+    for (std::size_t i = 0; i < frameCount; i++)
+    {
+        samples[2 * i] = 32767;
+        samples[2 * i + 1] = static_cast<sf::Int16>(-32768 + 8192 * i);
+    }
+    
+    sfe::AudioKernels::downmixStereoWindowed(samples.data(), window.data(), frameCount, output.data());
+    
+    for (std::size_t i = 0; i < frameCount; i++)
+    {
+        const float expected = (samples[2 * i] + samples[2 * i + 1]) / 65536.f * 0.5f;
+        BOOST_CHECK_SMALL(output[i] - expected, 1e-6f);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(FFTTest)
+{
+    BOOST_CHECK_THROW(sfe::FFT(100), std::runtime_error);
+    
+    const unsigned int size = 256;
+    const unsigned int frequencyBin = 10;
+    sfe::FFT fft(size);
+    std::vector<float> real(size);
+    std::vector<float> imag(size, 0.f);
+    
+    BOOST_CHECK_EQUAL(fft.getSize(), size);
+    
+    for (unsigned int i = 0; i < size; i++)
+        real[i] = static_cast<float>(std::cos(2 * Pi * frequencyBin * i / size));
+    
+    fft.transform(real.data(), imag.data());
+    
+    // A pure cosine only has energy in its own bin and the mirrored one, each with half of it
+    for (unsigned int bin = 0; bin < size; bin++)
+    {
+        const float magnitude = std::sqrt(real[bin] * real[bin] + imag[bin] * imag[bin]);
+        
+        if (bin == frequencyBin || bin == size - frequencyBin)
+            BOOST_CHECK_CLOSE(magnitude, size / 2.f, 0.01);
+        else
+            BOOST_CHECK_SMALL(magnitude, 1e-3f);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(MinMaxTest)
+{
+    std::vector<sf::Int16> samples(37, 5);
+    samples[3] = -32768;
+    samples[36] = 32767;
+    
+    sf::Int16 minimum = 32767;
+    sf::Int16 maximum = -32768;
+    sfe::AudioKernels::accumulateMinMax(samples.data(), 36, minimum, maximum);
+    BOOST_CHECK_EQUAL(minimum, -32768);
+    BOOST_CHECK_EQUAL(maximum, 5);
+    
+    // Previous bounds are kept
+    sfe::AudioKernels::accumulateMinMax(samples.data() + 4, 33, minimum, maximum);
+    BOOST_CHECK_EQUAL(minimum, -32768);
+    BOOST_CHECK_EQUAL(maximum, 32767);
+}
+
+BOOST_AUTO_TEST_CASE(GainTest)
+{
+    // 19 samples so that the scalar tail is exercised after the vectorized part
+    std::vector<sf::Int16> samples(19);
+    for (std::size_t i = 0; i < samples.size(); i++)
+        samples[i] = static_cast<sf::Int16>(i % 2 ? 1000 : -1000);
+    samples[0] = 30000;
+    samples[18] = -30000;
+    
+    sfe::AudioKernels::applyGain(samples.data(), samples.size(), 2.f);
+    BOOST_CHECK_EQUAL(samples[0], 32767);
+    BOOST_CHECK_EQUAL(samples[18], -32768);
+    
+    for (std::size_t i = 1; i < 18; i++)
+        BOOST_CHECK_EQUAL(samples[i], i % 2 ? 2000 : -2000);
+    
+    sfe::AudioKernels::applyGain(samples.data(), samples.size(), 0.f);
+    BOOST_CHECK(std::count(samples.begin(), samples.end(), 0) == 19);
+}
+
+BOOST_AUTO_TEST_CASE(MixTest)
+{
+    std::vector<sf::Int16> destination(21, 100);
+    std::vector<sf::Int16> source(21, 300);
+    destination[2] = 32000;
+    destination[20] = -32000;
+    source[20] = -2000;
+    
+    sfe::AudioKernels::mixWithGain(destination.data(), source.data(), destination.size(), 0.5f);
+    BOOST_CHECK_EQUAL(destination[2], 32150);
+    BOOST_CHECK_EQUAL(destination[20], -32768);
+    
+    for (std::size_t i = 0; i < 20; i++)
+    {
+        if (i != 2)
+            BOOST_CHECK_EQUAL(destination[i], 250);
+    }
+    
+    // Source is left untouched
+    BOOST_CHECK_EQUAL(source[0], 300);
+}
@@ -0,0 +1,123 @@
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_MODULE DecodeSchedulerTest
+#include <boost/test/unit_test.hpp>
+#include "DecodeScheduler.hpp"
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    typedef sfe::DecodeScheduler::Clock Clock;
+    
+    struct Recorder
+    {
+        void record(int value)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            values.push_back(value);
+        }
+        
+        std::mutex mutex;
+        std::vector<int> values;
+    };
+}
+
+BOOST_AUTO_TEST_CASE(DecodeSchedulerInlineTest)
+{
+    sfe::DecodeScheduler& scheduler = sfe::DecodeScheduler::getInstance();
+    scheduler.setWorkerCount(0);
+    
+    // Without workers, tasks run right away
+    bool didRun = false;
+    scheduler.submit(&didRun, 0, Clock::now(), [&didRun]() { didRun = true; });
+    BOOST_CHECK(didRun);
+}
+
+BOOST_AUTO_TEST_CASE(DecodeSchedulerOrderTest)
+{
+    sfe::DecodeScheduler& scheduler = sfe::DecodeScheduler::getInstance();
+    scheduler.setWorkerCount(1);
+    
+    // Keep the only worker busy while the tasks are queued
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    int blocker = 0;
+    scheduler.submit(&blocker, 0, Clock::now(), [released]() { released.wait(); });
+    
+    Recorder recorder;
+    const Clock::time_point now = Clock::now();
+    scheduler.submit(&recorder, 0, now + std::chrono::milliseconds(30), [&recorder]() { recorder.record(3); });
+    scheduler.submit(&recorder, 0, now + std::chrono::milliseconds(10), [&recorder]() { recorder.record(2); });
+    scheduler.submit(&recorder, 5, now + std::chrono::milliseconds(50), [&recorder]() { recorder.record(1); });
+    scheduler.submit(&recorder, -1, now, [&recorder]() { recorder.record(4); });
+    
+    release.set_value();
+    scheduler.cancel(&blocker);
+    
+    // Highest priority first, then earliest deadline
+    scheduler.setWorkerCount(0);
+    BOOST_CHECK(recorder.values == std::vector<int>({1, 2, 3, 4}));
+}
+
+BOOST_AUTO_TEST_CASE(DecodeSchedulerCancelTest)
+{
+    sfe::DecodeScheduler& scheduler = sfe::DecodeScheduler::getInstance();
+    scheduler.setWorkerCount(1);
+    
+    std::promise<void> started;
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::atomic<bool> didFinish(false);
+    std::atomic<int> runCount(0);
+    int owner = 0;
+    
+    scheduler.submit(&owner, 0, Clock::now(), [&started, released, &didFinish]()
+    {
+        started.set_value();
+        released.wait();
+        didFinish = true;
+    });
+    scheduler.submit(&owner, 0, Clock::now(), [&runCount]() { runCount++; });
+    started.get_future().wait();
+    
+    std::atomic<unsigned int> workerCountWhileCancelling(0);
+    int otherOwner = 0;
+    
+    std::thread releaser([&release, &scheduler, &workerCountWhileCancelling, &otherOwner]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        
+        // Other movies must not be blocked while a cancel waits
+        scheduler.submit(&otherOwner, 0, Clock::now(), []() {});
+        workerCountWhileCancelling = scheduler.getWorkerCount();
+        release.set_value();
+    });
+    
+    // The running task is waited for and the queued one never runs
+    scheduler.cancel(&owner);
+    BOOST_CHECK(didFinish);
+    releaser.join();
+    BOOST_CHECK_EQUAL(workerCountWhileCancelling, 1u);
+    
+    scheduler.setWorkerCount(0);
+    BOOST_CHECK_EQUAL(runCount, 0);
+}
+
+BOOST_AUTO_TEST_CASE(DecodeSchedulerStealingTest)
+{
+    sfe::DecodeScheduler& scheduler = sfe::DecodeScheduler::getInstance();
+    scheduler.setWorkerCount(4);
+    
+    std::atomic<int> runCount(0);
+    const int taskCount = 1000;
+    
+    for (int i = 0; i < taskCount; i++)
+        scheduler.submit(&runCount, i % 3, Clock::now(), [&runCount]() { runCount++; });
+    
+    // Shrinking the pool runs what is still queued
+    scheduler.setWorkerCount(2);
+    scheduler.setWorkerCount(0);
+    BOOST_CHECK_EQUAL(runCount, taskCount);
+}
@@ -2,8 +2,12 @@
 #define BOOST_TEST_MAIN
 #define BOOST_TEST_MODULE DemuxerTest
 #include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 #include "Demuxer.hpp"
+#include "MemoryAccount.hpp"
 #include "Timer.hpp"
 #include "Utilities.hpp"
 #include <SFML/Audio.hpp>
@@ -14,8 +18,8 @@ class DummyDelegate : public sfe::VideoStream::Delegate, public sfe::SubtitleStr
 	}
     
     void didUpdateSubtitle(const sfe::SubtitleStream& sender,
-                           const std::list<sf::Sprite>& subimages,
-                           const std::list<sf::Vector2i>& positions)
+                           const sf::VertexArray& vertices,
+                           std::shared_ptr<const sf::Texture> texture)
     {
     }
     
@@ -27,6 +31,40 @@ class DummyDelegate : public sfe::VideoStream::Delegate, public sfe::SubtitleStr
 
 static DummyDelegate delegate;
 
+namespace
+{
+    void writeLittleEndian(std::ofstream& file, sf::Uint32 value, unsigned int byteCount)
+    {
+        for (unsigned int i = 0; i < byteCount; i++)
+            file.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+    
+    /** Write a WAV file announcing Vorbis audio without the Vorbis headers, so that its
+     * decoder is found but cannot be opened
+     */
+    void writeHeaderlessVorbisWave(const std::string& filename)
+    {
+        const sf::Uint32 dataSize = 4096;
+        std::ofstream file(filename.c_str(), std::ios::binary);
+        
+        file.write("RIFF", 4);
+        writeLittleEndian(file, 36 + dataSize, 4);
+        file.write("WAVEfmt ", 8);
+        writeLittleEndian(file, 16, 4);
+        writeLittleEndian(file, ('V' << 8) + 'o', 2);
+        writeLittleEndian(file, 1, 2);
+        writeLittleEndian(file, 44100, 4);
+        writeLittleEndian(file, 16000, 4);
+        writeLittleEndian(file, 1, 2);
+        writeLittleEndian(file, 0, 2);
+        file.write("data", 4);
+        writeLittleEndian(file, dataSize, 4);
+        
+        for (sf::Uint32 i = 0; i < dataSize; i++)
+            file.put(static_cast<char>(i * 31));
+    }
+}
+
 BOOST_AUTO_TEST_CASE(DemuxerAvailableCodecsTest)
 {
 	BOOST_CHECK(!sfe::Demuxer::getAvailableDemuxers().empty());
@@ -100,6 +138,11 @@ BOOST_AUTO_TEST_CASE(DemuxerShortOGVTest)
 	BOOST_CHECK(videoStream->getStatus() == sfe::Playing);
 	BOOST_CHECK(audioStream->getStatus() == sfe::Playing);
 	
+	// The next video frame is due soon
+	sf::Time delay;
+	BOOST_CHECK(demuxer->getTimeUntilNextUpdate(delay));
+	BOOST_CHECK(delay >= sf::Time::Zero && delay < sf::seconds(1));
+	
 	clock.restart();
 	while (clock.getElapsedTime() < sf::seconds(8)) {
 		demuxer->update();
@@ -127,6 +170,10 @@ BOOST_AUTO_TEST_CASE(DemuxerShortWAVTest)
 	demuxer->update();
 	BOOST_CHECK(demuxer->didReachEndOfFile() == false);
 	BOOST_CHECK(audioStream->getStatus() == sfe::Playing);
+	
+	// Audio is played in background, updates are never due
+	sf::Time delay;
+	BOOST_CHECK(!demuxer->getTimeUntilNextUpdate(delay));
 	sf::sleep(sf::seconds(4));
 	demuxer->update();
 	BOOST_CHECK(demuxer->didReachEndOfFile() == true);
@@ -186,3 +233,83 @@ BOOST_AUTO_TEST_CASE(DemuxerShortFLACTest)
 	BOOST_CHECK(demuxer->didReachEndOfFile() == true);
 	BOOST_CHECK(audioStream->getStatus() == sfe::Stopped);
 }
+
+BOOST_AUTO_TEST_CASE(DemuxerAudioLatencyTest)
+{
+    std::shared_ptr<sfe::Timer> timer = std::make_shared<sfe::Timer>();
+    std::shared_ptr<sfe::Demuxer> demuxer = std::make_shared<sfe::Demuxer>("small_3.flac", timer, delegate, delegate);
+    demuxer->selectFirstAudioStream();
+    
+    std::shared_ptr<sfe::Stream> audioStream = *demuxer->getStreamsOfType(sfe::Audio).begin();
+    
+    timer->play();
+    timer->pause();
+    timer->play();
+    timer->stop();
+    
+    // Each transition of the audio output is measured
+    const sfe::StreamStats stats = audioStream->getStats();
+    BOOST_CHECK_EQUAL(stats.playLatency.count, 2);
+    BOOST_CHECK_EQUAL(stats.pauseLatency.count, 1);
+    BOOST_CHECK_EQUAL(stats.stopLatency.count, 1);
+    BOOST_CHECK(stats.playLatency.maximum < sf::seconds(5));
+    BOOST_CHECK(stats.pauseLatency.maximum < sf::seconds(5));
+    BOOST_CHECK(stats.stopLatency.maximum < sf::seconds(5));
+}
+
+BOOST_AUTO_TEST_CASE(DemuxerUndecodableStreamTest)
+{
+    const std::string filename = "undecodable_vorbis.wav";
+    writeHeaderlessVorbisWave(filename);
+    
+    std::shared_ptr<sfe::Timer> timer = std::make_shared<sfe::Timer>();
+    std::shared_ptr<sfe::Demuxer> demuxer = std::make_shared<sfe::Demuxer>(filename, timer, delegate, delegate);
+    BOOST_REQUIRE_EQUAL(demuxer->getStreamsOfType(sfe::Audio).size(), 1);
+    
+    // The stream whose decoder cannot be opened is skipped and no longer listed
+    BOOST_CHECK_NO_THROW(demuxer->selectFirstAudioStream());
+    BOOST_CHECK(demuxer->getSelectedAudioStream() == nullptr);
+    BOOST_CHECK(demuxer->getStreams().empty());
+    BOOST_CHECK(demuxer->computeStreamDescriptors(sfe::Audio).empty());
+    
+    demuxer.reset();
+    std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(DemuxerPendingDataBudgetTest)
+{
+    const std::size_t limit = 64 * 1024;
+    std::size_t maximumWithoutLimit = 0;
+    std::size_t maximumWithLimit = 0;
+    
+    for (int pass = 0; pass < 2; pass++)
+    {
+        sfe::MemoryBudget::setLimit(pass == 0 ? 0 : limit);
+        
+        std::shared_ptr<sfe::Timer> timer = std::make_shared<sfe::Timer>();
+        std::shared_ptr<sfe::Demuxer> demuxer = std::make_shared<sfe::Demuxer>("small_1.ogv", timer, delegate, delegate);
+        demuxer->selectFirstVideoStream();
+        demuxer->selectFirstAudioStream();
+        
+        std::shared_ptr<sfe::AudioStream> audioStream = demuxer->getSelectedAudioStream();
+        BOOST_REQUIRE(audioStream != nullptr);
+        BOOST_REQUIRE(demuxer->getSelectedVideoStream() != nullptr);
+        
+        // Only consume audio, the video packets read meanwhile wait in the demuxer's queue
+        std::size_t& maximum = (pass == 0) ? maximumWithoutLimit : maximumWithLimit;
+        AVPacket* packet = nullptr;
+        
+        while (!demuxer->didReachEndOfFile() && (packet = audioStream->popEncodedData()) != nullptr)
+        {
+            av_free_packet(packet);
+            av_free(packet);
+            maximum = std::max(maximum, demuxer->getMemoryUsage().encodedPackets);
+        }
+    }
+    
+    sfe::MemoryBudget::setLimit(0);
+    
+    // The queue grows with the whole video without a limit, and stays around the limit otherwise
+    BOOST_CHECK(maximumWithoutLimit > 2 * limit);
+    BOOST_CHECK(maximumWithLimit < 2 * limit);
+}
@@ -0,0 +1,100 @@
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_MODULE ImageKernelsTest
+#include <boost/test/unit_test.hpp>
+#include "ImageKernels.hpp"
+#include <vector>
+
+namespace
+{
+    void expandPaletteReference(const sf::Uint8* indices, std::size_t pixelCount, const sf::Uint32 palette[256],
+                                sf::Uint8* destination)
+    {
+        sf::Uint32* data = reinterpret_cast<sf::Uint32*>(destination);
+        for (std::size_t j = 0; j < pixelCount; ++j)
+            data[j] = palette[indices[j]];
+    }
+}
+
+BOOST_AUTO_TEST_CASE(DivideBy255Test)
+{
+    for (unsigned int value = 0; value <= 255 * 255; value++)
+        BOOST_REQUIRE_EQUAL(sfe::ImageKernels::divideBy255(value), (value * 2 + 255) / 510);
+}
+
+BOOST_AUTO_TEST_CASE(BlendCoverageTest)
+{
+    // 37 pixels so that the scalar tail is exercised after the vectorized part
+    const std::size_t pixelCount = 37;
+    const sf::Uint8 color[4] = { 200, 100, 50, 128 };
+    std::vector<sf::Uint8> coverage(pixelCount);
+    std::vector<sf::Uint8> pixels(pixelCount * 4);
+    std::vector<sf::Uint8> expected(pixelCount * 4);
+    
+    for (std::size_t i = 0; i < pixelCount; i++)
+    {
+        coverage[i] = static_cast<sf::Uint8>(i * 7);
+        
+        // Valid premultiplied pixels: color components don't exceed alpha
+        const sf::Uint8 alpha = static_cast<sf::Uint8>(255 - i * 5);
+        pixels[4 * i] = static_cast<sf::Uint8>(alpha * (i % 3) / 2);
+        pixels[4 * i + 1] = alpha / 3;
+        pixels[4 * i + 2] = alpha;
+        pixels[4 * i + 3] = alpha;
+    }
+    
+    coverage[0] = 0;
+    coverage[pixelCount - 1] = 255;
+    
+    for (std::size_t i = 0; i < pixelCount; i++)
+    {
+        const unsigned int alpha = sfe::ImageKernels::divideBy255(coverage[i] * color[3]);
+        
+        for (int channel = 0; channel < 4; channel++)
+        {
+            const unsigned int source = (channel == 3) ? alpha
+                                                       : sfe::ImageKernels::divideBy255(color[channel] * alpha);
+            const unsigned int kept = sfe::ImageKernels::divideBy255(pixels[4 * i + channel] * (255 - alpha));
+            expected[4 * i + channel] = static_cast<sf::Uint8>(source + kept);
+        }
+    }
+    
+    std::vector<sf::Uint8> original(pixels);
+    sfe::ImageKernels::blendCoverage(coverage.data(), pixelCount, color, pixels.data());
+    
+    for (std::size_t i = 0; i < pixels.size(); i++)
+        BOOST_CHECK_EQUAL(static_cast<int>(pixels[i]), static_cast<int>(expected[i]));
+    
+    // No coverage leaves the pixel untouched
+    for (int channel = 0; channel < 4; channel++)
+        BOOST_CHECK_EQUAL(pixels[channel], original[channel]);
+    
+    // An opaque color fully covering a pixel replaces it
+    const sf::Uint8 opaque[4] = { 10, 20, 30, 255 };
+    sfe::ImageKernels::blendCoverage(coverage.data() + pixelCount - 1, 1, opaque, pixels.data());
+    BOOST_CHECK_EQUAL(pixels[0], 10);
+    BOOST_CHECK_EQUAL(pixels[1], 20);
+    BOOST_CHECK_EQUAL(pixels[2], 30);
+    BOOST_CHECK_EQUAL(pixels[3], 255);
+}
+
+BOOST_AUTO_TEST_CASE(ExpandPaletteTest)
+{
+    sf::Uint32 palette[256];
+    for (unsigned int i = 0; i < 256; i++)
+        palette[i] = i * 0x01010101u ^ 0x00FF00FFu;
+    
+    // Runs and varying indices, with a length that exercises the scalar tail
+    std::vector<sf::Uint8> indices(16 * 5 + 7, 3);
+    for (std::size_t i = 16; i < 48; i++)
+        indices[i] = static_cast<sf::Uint8>(i * 31);
+    indices[70] = 255;
+    indices[indices.size() - 1] = 128;
+    
+    std::vector<sf::Uint8> pixels(indices.size() * 4);
+    std::vector<sf::Uint8> expected(indices.size() * 4);
+    sfe::ImageKernels::expandPalette(indices.data(), indices.size(), palette, pixels.data());
+    expandPaletteReference(indices.data(), indices.size(), palette, expected.data());
+    
+    BOOST_CHECK(pixels == expected);
+}
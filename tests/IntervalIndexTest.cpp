@@ -0,0 +1,141 @@
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_MODULE IntervalIndexTest
+#include <boost/test/unit_test.hpp>
+#include "IntervalIndex.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    typedef sfe::IntervalIndex<int> Index;
+    
+    std::vector<int> findOverlapping(const Index& index, sf::Time time)
+    {
+        std::vector<const Index::Interval*> intervals;
+        index.findOverlapping(time, intervals);
+        
+        std::vector<int> values;
+        for (const Index::Interval* interval : intervals)
+            values.push_back(interval->value);
+        return values;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(IntervalIndexOverlapTest)
+{
+    Index index;
+    BOOST_CHECK(findOverlapping(index, sf::seconds(1)).empty());
+    
+    // Events overlap and don't end in the order they start
+    index.insert(sf::seconds(0), sf::seconds(10), 0);
+    index.insert(sf::seconds(2), sf::seconds(4), 1);
+    index.insert(sf::seconds(3), sf::seconds(6), 2);
+    index.insert(sf::seconds(12), sf::seconds(13), 3);
+    BOOST_CHECK_EQUAL(index.getSize(), 4);
+    
+    BOOST_CHECK(findOverlapping(index, sf::seconds(1)) == std::vector<int>({0}));
+    BOOST_CHECK(findOverlapping(index, sf::seconds(3.5f)) == std::vector<int>({0, 1, 2}));
+    BOOST_CHECK(findOverlapping(index, sf::seconds(4)) == std::vector<int>({0, 2}));
+    BOOST_CHECK(findOverlapping(index, sf::seconds(10)).empty());
+    BOOST_CHECK(findOverlapping(index, sf::seconds(12)) == std::vector<int>({3}));
+    
+    // Out of order insertion
+    index.insert(sf::seconds(1), sf::seconds(5), 4);
+    BOOST_CHECK(findOverlapping(index, sf::seconds(3.5f)) == std::vector<int>({0, 4, 1, 2}));
+    
+    index.clear();
+    BOOST_CHECK_EQUAL(index.getSize(), 0);
+    BOOST_CHECK(findOverlapping(index, sf::seconds(3.5f)).empty());
+}
+
+BOOST_AUTO_TEST_CASE(IntervalIndexEraseTest)
+{
+    Index index;
+    index.insert(sf::seconds(0), sf::seconds(10), 0);
+    index.insert(sf::seconds(2), sf::seconds(4), 1);
+    index.insert(sf::seconds(3), sf::seconds(6), 2);
+    
+    index.eraseEndingBefore(sf::seconds(4));
+    BOOST_CHECK_EQUAL(index.getSize(), 2);
+    BOOST_CHECK(findOverlapping(index, sf::seconds(3.5f)) == std::vector<int>({0, 2}));
+    
+    index.insert(sf::seconds(5), sf::seconds(7), 3);
+    BOOST_CHECK(findOverlapping(index, sf::seconds(5.5f)) == std::vector<int>({0, 2, 3}));
+    
+    index.eraseEndingBefore(sf::seconds(7));
+    BOOST_CHECK_EQUAL(index.getSize(), 1);
+    BOOST_CHECK(findOverlapping(index, sf::seconds(8)) == std::vector<int>({0}));
+}
+
+BOOST_AUTO_TEST_CASE(IntervalIndexNextStartTest)
+{
+    Index index;
+    sf::Time start = sf::seconds(-1);
+    BOOST_CHECK(!index.findNextStart(sf::seconds(0), start));
+    
+    index.insert(sf::seconds(0), sf::seconds(10), 0);
+    index.insert(sf::seconds(2), sf::seconds(4), 1);
+    index.insert(sf::seconds(3), sf::seconds(6), 2);
+    index.insert(sf::seconds(8), sf::seconds(9), 3);
+    
+    BOOST_CHECK(index.findNextStart(sf::seconds(0), start));
+    BOOST_CHECK(start == sf::seconds(2));
+    BOOST_CHECK(index.findNextStart(sf::seconds(2.5f), start));
+    BOOST_CHECK(start == sf::seconds(3));
+    
+    // Erased intervals don't count, even when looking before their end
+    index.eraseEndingBefore(sf::seconds(5));
+    BOOST_CHECK(index.findNextStart(sf::seconds(1), start));
+    BOOST_CHECK(start == sf::seconds(3));
+    
+    start = sf::seconds(-1);
+    BOOST_CHECK(!index.findNextStart(sf::seconds(8), start));
+    BOOST_CHECK(start == sf::seconds(-1));
+}
+
+BOOST_AUTO_TEST_CASE(IntervalIndexBruteForceTest)
+{
+    Index index;
+    std::vector<Index::Interval> reference;
+    unsigned int seed = 1;
+    
+    for (int i = 0; i < 2000; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        
+        // Mostly in order, like decoded subtitles, with a few late ones
+        const sf::Int64 start = (seed % 16 == 0) ? (seed >> 8) % (i * 100 + 1) : i * 100;
+        const sf::Int64 end = start + 1 + (seed >> 4) % 3000;
+        
+        index.insert(sf::milliseconds(start), sf::milliseconds(end), i);
+        reference.push_back(Index::Interval{sf::milliseconds(start), sf::milliseconds(end), i});
+        
+        if (i % 50 == 49)
+        {
+            const sf::Time time = sf::milliseconds((i - 30) * 100);
+            
+            std::vector<int> expected;
+            for (const Index::Interval& interval : reference)
+            {
+                if (interval.start <= time && time < interval.end)
+                    expected.push_back(interval.value);
+            }
+            
+            std::vector<int> found = findOverlapping(index, time);
+            std::sort(expected.begin(), expected.end());
+            std::sort(found.begin(), found.end());
+            BOOST_CHECK(found == expected);
+            
+            if (i % 100 == 99)
+            {
+                const sf::Time eraseTime = time - sf::seconds(1);
+                index.eraseEndingBefore(eraseTime);
+                reference.erase(std::remove_if(reference.begin(), reference.end(),
+                                               [eraseTime](const Index::Interval& interval)
+                                               { return interval.end <= eraseTime; }),
+                                reference.end());
+                BOOST_CHECK_EQUAL(index.getSize(), reference.size());
+            }
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_MODULE MediaInfoTest
+#include <boost/test/unit_test.hpp>
+#include <sfeMovie/MediaInfo.hpp>
+
+BOOST_AUTO_TEST_CASE(MediaInfoProbeTest)
+{
+    sfe::MediaInfo info = sfe::probe("small_1.ogv");
+    BOOST_REQUIRE(info.isValid);
+    BOOST_CHECK_EQUAL(info.format, "ogg");
+    BOOST_CHECK(info.duration > sf::Time::Zero);
+    
+    unsigned videoStreamCount = 0;
+    unsigned audioStreamCount = 0;
+    
+    for (const sfe::StreamInfo& stream : info.streams)
+    {
+        BOOST_CHECK(!stream.codec.empty());
+        BOOST_CHECK(stream.isDecodable);
+        BOOST_CHECK(stream.descriptor.identifier >= 0);
+        
+        if (stream.descriptor.type == sfe::Video)
+        {
+            videoStreamCount++;
+            BOOST_CHECK(stream.frameSize.x > 0 && stream.frameSize.y > 0);
+            BOOST_CHECK(stream.frameRate > 0);
+        }
+        else if (stream.descriptor.type == sfe::Audio)
+        {
+            audioStreamCount++;
+            BOOST_CHECK(stream.sampleRate > 0);
+            BOOST_CHECK(stream.channelCount > 0);
+            BOOST_CHECK(!stream.channelLayout.empty());
+        }
+    }
+    
+    BOOST_CHECK_EQUAL(videoStreamCount, 1);
+    BOOST_CHECK_EQUAL(audioStreamCount, 1);
+    
+    BOOST_CHECK(!sfe::probe("non-existing-file.ogv").isValid);
+}
+
+BOOST_AUTO_TEST_CASE(MediaInfoBatchProbeTest)
+{
+    std::vector<std::string> filenames;
+    filenames.push_back("small_1.ogv");
+    filenames.push_back("non-existing-file.ogv");
+    filenames.push_back("long_1.wav");
+    filenames.push_back("small_4.wav");
+    
+    std::vector<sfe::MediaInfo> infos = sfe::probe(filenames, sfe::OpenOptions(), 2);
+    BOOST_REQUIRE_EQUAL(infos.size(), filenames.size());
+    
+    // Results are in the order of the files
+    BOOST_CHECK(infos[0].isValid);
+    BOOST_CHECK_EQUAL(infos[0].format, "ogg");
+    BOOST_CHECK(!infos[1].isValid);
+    BOOST_CHECK(infos[2].isValid);
+    BOOST_CHECK_EQUAL(infos[2].format, "wav");
+    BOOST_CHECK(infos[3].isValid);
+    BOOST_CHECK_EQUAL(infos[3].format, "wav");
+    BOOST_REQUIRE_EQUAL(infos[2].streams.size(), 1);
+    BOOST_CHECK(infos[2].streams[0].descriptor.type == sfe::Audio);
+}
@@ -0,0 +1,55 @@
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_MODULE MemoryAccountTest
+#include <boost/test/unit_test.hpp>
+#include "MemoryAccount.hpp"
+
+BOOST_AUTO_TEST_CASE(MemoryAccountCountingTest)
+{
+    const std::size_t processBefore = sfe::MemoryBudget::getUsage().getTotal();
+    
+    {
+        sfe::MemoryAccount first;
+        sfe::MemoryAccount second;
+        
+        first.add(sfe::MemoryAccount::VideoFrames, 1000);
+        first.add(sfe::MemoryAccount::EncodedPackets, 300);
+        second.add(sfe::MemoryAccount::AudioSamples, 200);
+        first.remove(sfe::MemoryAccount::EncodedPackets, 100);
+        
+        BOOST_CHECK_EQUAL(first.getUsage().videoFrames, 1000);
+        BOOST_CHECK_EQUAL(first.getUsage().audioSamples, 0);
+        BOOST_CHECK_EQUAL(first.getUsage().encodedPackets, 200);
+        BOOST_CHECK_EQUAL(first.getUsage().getTotal(), 1200);
+        BOOST_CHECK_EQUAL(second.getUsage().getTotal(), 200);
+        BOOST_CHECK_EQUAL(sfe::MemoryBudget::getUsage().getTotal(), processBefore + 1400);
+    }
+    
+    // Destroyed accounts no longer count in the process usage
+    BOOST_CHECK_EQUAL(sfe::MemoryBudget::getUsage().getTotal(), processBefore);
+}
+
+BOOST_AUTO_TEST_CASE(MemoryBudgetLimitTest)
+{
+    BOOST_CHECK_EQUAL(sfe::MemoryBudget::getLimit(), 0);
+    
+    sfe::MemoryAccount account;
+    account.add(sfe::MemoryAccount::VideoFrames, 5000);
+    
+    // No limit by default
+    BOOST_CHECK(!sfe::MemoryAccount::isOverBudget());
+    BOOST_CHECK(!sfe::MemoryAccount::exceedsBudget(1000000));
+    
+    sfe::MemoryBudget::setLimit(10000);
+    BOOST_CHECK_EQUAL(sfe::MemoryBudget::getLimit(), 10000);
+    BOOST_CHECK(!sfe::MemoryAccount::isOverBudget());
+    BOOST_CHECK(!sfe::MemoryAccount::exceedsBudget(10000));
+    BOOST_CHECK(sfe::MemoryAccount::exceedsBudget(10001));
+    
+    account.add(sfe::MemoryAccount::EncodedPackets, 6000);
+    BOOST_CHECK(sfe::MemoryAccount::isOverBudget());
+    
+    account.remove(sfe::MemoryAccount::EncodedPackets, 6000);
+    BOOST_CHECK(!sfe::MemoryAccount::isOverBudget());
+    
+    sfe::MemoryBudget::setLimit(0);
+}
@@ -0,0 +1,82 @@
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_MODULE PeakPyramidTest
+#include <boost/test/unit_test.hpp>
+#include "PeakPyramid.hpp"
+#include <vector>
+
+namespace
+{
+    // Stereo samples where the left channel is the frame index and the right channel its opposite
+    std::vector<sf::Int16> makeRamp(sf::Int64 firstFrame, std::size_t frameCount)
+    {
+        std::vector<sf::Int16> samples(frameCount * 2);
+        
+        for (std::size_t i = 0; i < frameCount; i++)
+        {
+            samples[2 * i] = static_cast<sf::Int16>(firstFrame + i);
+            samples[2 * i + 1] = static_cast<sf::Int16>(-(firstFrame + i));
+        }
+        
+        return samples;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(LevelsTest)
+{
+    sfe::PeakPyramid pyramid(10000, 10);
+    
+    // 1000 peaks on the finest level, then 250, 63, 16, 4, 1
+    BOOST_CHECK_EQUAL(pyramid.getLevelCount(), 6);
+    BOOST_CHECK_EQUAL(pyramid.getFrameCount(), 10000);
+    
+    // Growing past the expected length adds levels
+    std::vector<sf::Int16> samples = makeRamp(10000, 500);
+    pyramid.addSamples(10000, samples.data(), 500, 2);
+    BOOST_CHECK_EQUAL(pyramid.getFrameCount(), 10500);
+    BOOST_CHECK_EQUAL(pyramid.getLevelCount(), 7);
+}
+
+BOOST_AUTO_TEST_CASE(QueryTest)
+{
+    sfe::PeakPyramid pyramid(8000, 16);
+    std::vector<sfe::PeakPyramid::Peak> peaks;
+    
+    pyramid.getPeaks(0, 8000, 4, peaks);
+    BOOST_REQUIRE_EQUAL(peaks.size(), 4);
+    for (const sfe::PeakPyramid::Peak& peak : peaks)
+        BOOST_CHECK(peak.isEmpty());
+    
+    // Slices are aligned on the finest peaks (16 frames) so that the results are exact
+    // Second half first, with an overlap and odd chunk sizes to exercise merging
+    std::vector<sf::Int16> secondHalf = makeRamp(3990, 4010);
+    pyramid.addSamples(3990, secondHalf.data(), 4010, 2);
+    
+    pyramid.getPeaks(0, 8000, 4, peaks);
+    BOOST_CHECK(peaks[0].isEmpty());
+    BOOST_CHECK_EQUAL(peaks[1].minimum, -3999);
+    BOOST_CHECK_EQUAL(peaks[1].maximum, 3999);
+    BOOST_CHECK_EQUAL(peaks[3].minimum, -7999);
+    BOOST_CHECK_EQUAL(peaks[3].maximum, 7999);
+    
+    std::vector<sf::Int16> firstHalf = makeRamp(0, 4001);
+    pyramid.addSamples(0, firstHalf.data(), 4001, 2);
+    
+    pyramid.getPeaks(0, 8000, 4, peaks);
+    BOOST_CHECK_EQUAL(peaks[0].minimum, -1999);
+    BOOST_CHECK_EQUAL(peaks[0].maximum, 1999);
+    BOOST_CHECK_EQUAL(peaks[2].minimum, -5999);
+    BOOST_CHECK_EQUAL(peaks[2].maximum, 5999);
+    
+    // Slices shorter than the finest peaks still report the peak containing them
+    pyramid.getPeaks(100, 104, 4, peaks);
+    for (const sfe::PeakPyramid::Peak& peak : peaks)
+    {
+        BOOST_CHECK_EQUAL(peak.minimum, -111);
+        BOOST_CHECK_EQUAL(peak.maximum, 111);
+    }
+    
+    // Nothing past the end
+    pyramid.getPeaks(7000, 9000, 2, peaks);
+    BOOST_CHECK(!peaks[0].isEmpty());
+    BOOST_CHECK(peaks[1].isEmpty());
+}
@@ -0,0 +1,37 @@
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_MODULE PlaybackStatsTest
+#include <boost/test/unit_test.hpp>
+#include <sfeMovie/PlaybackStats.hpp>
+
+BOOST_AUTO_TEST_CASE(TimeHistogramTest)
+{
+    sfe::TimeHistogram histogram;
+    BOOST_CHECK_EQUAL(histogram.getMean().asMicroseconds(), 0);
+    BOOST_CHECK_EQUAL(histogram.getPercentile(0.5f).asMicroseconds(), 0);
+    
+    // 90 durations of 3ms and 10 of 40ms
+    for (int i = 0; i < 90; i++)
+        histogram.add(sf::milliseconds(3));
+    for (int i = 0; i < 10; i++)
+        histogram.add(sf::milliseconds(40));
+    
+    BOOST_CHECK_EQUAL(histogram.count, 100);
+    BOOST_CHECK_EQUAL(histogram.maximum.asMilliseconds(), 40);
+    BOOST_CHECK_EQUAL(histogram.getMean().asMicroseconds(), 6700);
+    
+    // 3000us is in bucket [2048, 4096[
+    BOOST_CHECK_EQUAL(histogram.buckets[12], 90);
+    BOOST_CHECK_EQUAL(histogram.getPercentile(0.5f).asMicroseconds(), 4096);
+    BOOST_CHECK_EQUAL(histogram.getPercentile(0.9f).asMicroseconds(), 4096);
+    
+    // Percentiles don't exceed the maximum
+    BOOST_CHECK_EQUAL(histogram.getPercentile(0.95f).asMilliseconds(), 40);
+    BOOST_CHECK_EQUAL(histogram.getPercentile(1.f).asMilliseconds(), 40);
+    
+    // Zero and very long durations land in the first and last buckets
+    histogram.add(sf::Time::Zero);
+    histogram.add(sf::seconds(3600));
+    BOOST_CHECK_EQUAL(histogram.buckets[0], 1);
+    BOOST_CHECK_EQUAL(histogram.buckets[sfe::TimeHistogram::BucketCount - 1], 1);
+    BOOST_CHECK_EQUAL(histogram.getPercentile(1.f).asSeconds(), 3600);
+}
@@ -0,0 +1,78 @@
+
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_MODULE ShelfPackerTest
+#include <boost/test/unit_test.hpp>
+#include "SubtitleAtlas.hpp"
+#include <vector>
+
+namespace
+{
+    bool intersects(sf::Vector2u positionA, sf::Vector2u sizeA, sf::Vector2u positionB, sf::Vector2u sizeB)
+    {
+        return positionA.x < positionB.x + sizeB.x && positionB.x < positionA.x + sizeA.x &&
+               positionA.y < positionB.y + sizeB.y && positionB.y < positionA.y + sizeA.y;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ShelfPackerPlacementTest)
+{
+    sfe::ShelfPacker packer(100);
+    sf::Vector2u position;
+    
+    BOOST_CHECK_EQUAL(packer.getHeight(), 0);
+    BOOST_CHECK(!packer.pack(101, 10, position));
+    
+    BOOST_REQUIRE(packer.pack(60, 30, position));
+    BOOST_CHECK_EQUAL(position.x, 0);
+    BOOST_CHECK_EQUAL(position.y, 0);
+    
+    // Fits next to the first one
+    BOOST_REQUIRE(packer.pack(40, 20, position));
+    BOOST_CHECK_EQUAL(position.x, 60);
+    BOOST_CHECK_EQUAL(position.y, 0);
+    
+    // No room left on the first shelf
+    BOOST_REQUIRE(packer.pack(10, 10, position));
+    BOOST_CHECK_EQUAL(position.x, 0);
+    BOOST_CHECK_EQUAL(position.y, 30);
+    BOOST_CHECK_EQUAL(packer.getHeight(), 40);
+    
+    // Too high for the second shelf
+    BOOST_REQUIRE(packer.pack(10, 15, position));
+    BOOST_CHECK_EQUAL(position.y, 40);
+    
+    // The lowest shelf that fits is preferred
+    BOOST_REQUIRE(packer.pack(10, 10, position));
+    BOOST_CHECK_EQUAL(position.x, 10);
+    BOOST_CHECK_EQUAL(position.y, 30);
+    
+    packer.reset(50);
+    BOOST_CHECK_EQUAL(packer.getWidth(), 50);
+    BOOST_CHECK_EQUAL(packer.getHeight(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(ShelfPackerOverlapTest)
+{
+    sfe::ShelfPacker packer(256);
+    std::vector<sf::Vector2u> positions;
+    std::vector<sf::Vector2u> sizes;
+    
+    for (unsigned int i = 0; i < 200; i++)
+    {
+        const sf::Vector2u size(1 + (i * 37) % 120, 1 + (i * 53) % 40);
+        sf::Vector2u position;
+        
+        BOOST_REQUIRE(packer.pack(size.x, size.y, position));
+        BOOST_CHECK(position.x + size.x <= packer.getWidth());
+        BOOST_CHECK(position.y + size.y <= packer.getHeight());
+        
+        positions.push_back(position);
+        sizes.push_back(size);
+    }
+    
+    for (std::size_t i = 0; i < positions.size(); i++)
+    {
+        for (std::size_t j = i + 1; j < positions.size(); j++)
+            BOOST_CHECK(!intersects(positions[i], sizes[i], positions[j], sizes[j]));
+    }
+}
@@ -140,3 +140,33 @@ BOOST_AUTO_TEST_CASE(TimerTestPriorities)
     
     timer.play();
 }
+
+BOOST_AUTO_TEST_CASE(TimerTestReference)
+{
+    std::shared_ptr<sfe::Timer> reference = std::make_shared<sfe::Timer>();
+    sfe::Timer timer;
+    MyObserver obs;
+    
+    timer.addObserver(obs);
+    timer.setReference(reference);
+    reference->seek(sf::seconds(5));
+    reference->pause();
+    
+    // A stopped timer does not follow its reference
+    BOOST_CHECK(timer.getOffset() == sf::Time::Zero);
+    
+    timer.prepareToPlay();
+    BOOST_CHECK(obs.m_willPlay == true);
+    BOOST_CHECK(obs.m_didPlay == false);
+    BOOST_CHECK(timer.getStatus() == sfe::Stopped);
+    
+    timer.startPlaying();
+    BOOST_CHECK(obs.m_didPlay == true);
+    BOOST_CHECK(timer.getStatus() == sfe::Playing);
+    BOOST_CHECK(timer.getOffset() == sf::seconds(5));
+    
+    // Removing the reference carries on from its offset
+    timer.pause();
+    timer.setReference(nullptr);
+    BOOST_CHECK(timer.getOffset() == sf::seconds(5));
+}